@@ -0,0 +1,124 @@
+﻿/*
+* Benchmark - structure of arrays transforms.
+* Composes a million model matrices per frame into a flat float buffer, the way they would be written into
+* an instance or stream buffer. The glm path is the current per-object one: an array of glm::vec3 positions
+* and axis-angle rotations, glm::translate then glm::rotate per cube. The TransformArray paths keep positions,
+* unit quaternions and scales in separate lanes and compose them one object at a time or a SIMD group at a
+* time. Reports ms per frame and the largest difference from the glm matrices.
+*
+* Usage: TransformBenchmark [--objects N] [--frames N]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "transform/transformarray.hpp"
+
+struct Options {
+	size_t objects = 1000000;
+	unsigned int frames = 30;
+};
+
+// Array of structures layout of the exercises.
+struct CubeTransform {
+	glm::vec3 position;
+	glm::vec3 axis;
+	float angle; // Radians.
+};
+
+enum Method { METHOD_GLM, METHOD_SOA_SCALAR, METHOD_SOA_SIMD, METHOD_COUNT };
+const char *methodNames[METHOD_COUNT] = { "glm per object", "soa scalar", "soa simd" };
+
+bool parseOptions(int argc, char *argv[], Options &options);
+void composeGlm(const std::vector<CubeTransform> &cubes, float *destination);
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<CubeTransform> cubes(options.objects);
+	TransformArray transforms;
+	transforms.resize(options.objects);
+	for (size_t i = 0; i < options.objects; i++) {
+		CubeTransform &cube = cubes[i];
+		cube.position = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+		cube.axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.1f));
+		cube.angle = unit(random) * 6.2831853f;
+		transforms.setPosition(i, cube.position);
+		transforms.setRotation(i, glm::angleAxis(cube.angle, cube.axis));
+	}
+
+	// Two buffers, so the glm result stays around for comparison.
+	std::vector<float> reference(options.objects * 16), matrices(options.objects * 16);
+	std::printf(
+		"%zu objects, %u frames, SIMD width %u\n\n%16s %10s %10s %10s %12s\n",
+		options.objects, options.frames, TransformArray::simdWidth(), "method", "mean ms", "p50 ms", "speedup", "max error"
+	);
+	double baseline = 0.0;
+	for (int method = 0; method < METHOD_COUNT; method++) {
+		float *destination = method == METHOD_GLM ? reference.data() : matrices.data();
+		std::vector<double> times;
+		for (unsigned int frame = 0; frame < options.frames; frame++) {
+			Stopwatch frameTime;
+			if (method == METHOD_GLM)
+				composeGlm(cubes, destination);
+			else
+				transforms.composeMatrices(0, options.objects, destination, method == METHOD_SOA_SIMD);
+			times.push_back(frameTime.elapsedMs());
+		}
+
+		float maxError = 0.0f;
+		if (method != METHOD_GLM)
+			for (size_t i = 0; i < matrices.size(); i++)
+				maxError = std::max(maxError, std::abs(matrices[i] - reference[i]));
+		SampleStats stats = summarize(times);
+		if (method == METHOD_GLM)
+			baseline = stats.mean;
+		std::printf("%16s %10.3f %10.3f %9.2fx %12.2e\n", methodNames[method], stats.mean, stats.p50, baseline / stats.mean, maxError);
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--objects") == 0 && value) {
+			options.objects = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--objects N] [--frames N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void composeGlm(const std::vector<CubeTransform> &cubes, float *destination) {
+	for (size_t i = 0; i < cubes.size(); i++) {
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, cubes[i].position);
+		model = glm::rotate(model, cubes[i].angle, cubes[i].axis);
+		std::memcpy(destination + i * 16, &model[0][0], sizeof(glm::mat4));
+	}
+}
\ No newline at end of file
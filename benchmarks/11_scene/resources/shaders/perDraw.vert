@@ -0,0 +1,20 @@
+#version 330 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vTexCoord;
+
+out vec2 fTexCoord;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+// Compact vertex format dequantization.
+uniform vec3 positionScale;
+uniform vec3 positionOrigin;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOrigin;
+
+void main() {
+    gl_Position = projection * view * model * vec4(vPos * positionScale + positionOrigin, 1.0);
+    fTexCoord = vTexCoord * texCoordScale + texCoordOrigin;
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 core
+
+in vec2 fTexCoord;
+
+layout (location = 0) out vec4 color;
+
+// No textures, so fill rate stays the same for every render path.
+void main() {
+    color = vec4(fTexCoord, 0.5, 1.0);
+}
\ No newline at end of file
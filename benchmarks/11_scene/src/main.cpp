@@ -0,0 +1,428 @@
+﻿/*
+* Benchmark - scene scaling.
+* Renders procedural cube fields of 10 to 1,000,000 objects headless with each render path of the camera
+* example: the per-draw loop through the sorted render queue and its backend, one instanced draw of the whole
+* field, and the batch renderer's multi-draw indirect (one draw call per cube without GL 4.6). Every run is a
+* fixed number of frames of a camera orbiting the field, after a few unmeasured warm-up frames.
+* CPU frame time covers building the frame's commands through the end of frame flush, GPU frame time comes
+* from timer queries read after the run so they never stall it. Reports mean, p50, p95 and p99 of both, draw
+* calls per frame and peak resident memory of the process so far, as a table and optionally as JSON for
+* regression tracking. Object counts run smallest first, so the peak is that of the largest field yet.
+* Needs EGL, see HeadlessContext.
+*
+* Usage: SceneBenchmark [--objects 10,100,...] [--methods per-draw,instanced,multi-draw] [--frames N] [--warmup N] [--json path]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "batch/batchrenderer.hpp"
+#include "benchmark/benchmark.hpp"
+#include "context/headlesscontext.hpp"
+#include "mesh/mesh.hpp"
+#include "render/glstatecache.hpp"
+#include "render/renderbackend.hpp"
+#include "render/renderqueue.hpp"
+#include "shader/shader.hpp"
+#include "transform/transformarray.hpp"
+#include "vertex/vertexformat.hpp"
+
+enum Method { METHOD_PER_DRAW, METHOD_INSTANCED, METHOD_MULTI_DRAW, METHOD_COUNT };
+const char *methodNames[METHOD_COUNT] = { "per-draw", "instanced", "multi-draw" };
+
+struct Options {
+	std::vector<size_t> objectCounts = { 10, 100, 1000, 10000, 100000, 1000000 };
+	std::vector<Method> methods = { METHOD_PER_DRAW, METHOD_INSTANCED, METHOD_MULTI_DRAW };
+	unsigned int frames = 100;
+	unsigned int warmupFrames = 10;
+	const char *jsonPath = nullptr;
+};
+
+struct RunResult {
+	size_t objects;
+	Method method;
+	SampleStats cpuMs;
+	SampleStats gpuMs;
+	unsigned int drawCalls; // Per frame.
+	size_t peakResidentBytes;
+};
+
+// GL objects shared by every run. Model matrices are static, as in the camera example, so the instanced
+// path uploads them once per scene while the per-draw and batch paths rebuild their commands every frame.
+class SceneRenderer {
+public:
+	SceneRenderer();
+	~SceneRenderer();
+	SceneRenderer(const SceneRenderer &) = delete;
+	SceneRenderer &operator=(const SceneRenderer &) = delete;
+
+	void setScene(const std::vector<glm::mat4> &models);
+	// Records one frame, returns its draw calls.
+	unsigned int drawFrame(Method method, const glm::mat4 &view, const glm::mat4 &projection, float farPlane);
+	bool multiDrawSupported() const;
+
+private:
+	Shader perDrawShader, instancedShader, batchShader;
+	QuantizedMesh cube;
+	BatchRenderer batch;
+	int cubeMesh;
+	unsigned int VAO, VBO, EBO, instanceVBO;
+	GlStateCache state;
+	RenderBackend backend;
+	unsigned int opaquePass, cubeProgram, cubeTextureSet, cubeVertexArray;
+	RenderQueue queue;
+	const std::vector<glm::mat4> *models;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+Mesh generateCube();
+std::vector<glm::mat4> generateScene(size_t count, float &extent);
+RunResult run(SceneRenderer &renderer, const std::vector<glm::mat4> &models, float extent, Method method, const Options &options);
+bool writeJson(const char *path, const std::vector<RunResult> &results, const Options &options, bool multiDraw);
+
+const int FRAMEBUFFER_WIDTH = 1280, FRAMEBUFFER_HEIGHT = 720;
+const unsigned int INSTANCE_MODEL_LOCATION = 3; // Locations 3 - 6, after the compact vertex attributes.
+const float CUBE_SPACING = 2.0f, ORBIT_SPEED = 0.01f; // Radians per frame.
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	// GL 4.6 for multi-draw indirect where the driver has it, debug builds log the attempt failing elsewhere.
+	// The batch then falls back to one draw per cube.
+	std::unique_ptr<HeadlessContext> context = std::make_unique<HeadlessContext>(FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT, 4, 6);
+	if (!context->valid())
+		context = std::make_unique<HeadlessContext>(FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+	if (!context->valid()) {
+		std::fprintf(stderr, "Failed to create headless GL context.\n");
+		return 1;
+	}
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+
+	SceneRenderer renderer;
+	std::printf(
+		"%s, %d x %d, %u frames after %u warm-up, multi-draw %s\n\n%10s %11s %6s %9s %9s %9s %9s %9s %9s %9s %9s %10s\n",
+		reinterpret_cast<const char *>(glGetString(GL_RENDERER)), FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT, options.frames,
+		options.warmupFrames, renderer.multiDrawSupported() ? "indirect" : "per draw fallback",
+		"objects", "method", "draws", "CPU mean", "CPU p50", "CPU p95", "CPU p99", "GPU mean", "GPU p50", "GPU p95", "GPU p99", "peak MB"
+	);
+
+	std::vector<RunResult> results;
+	for (size_t count : options.objectCounts) {
+		float extent;
+		std::vector<glm::mat4> models = generateScene(count, extent);
+		renderer.setScene(models);
+		for (Method method : options.methods) {
+			RunResult result = run(renderer, models, extent, method, options);
+			std::printf(
+				"%10zu %11s %6u %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %10.1f\n",
+				count, methodNames[method], result.drawCalls,
+				result.cpuMs.mean, result.cpuMs.p50, result.cpuMs.p95, result.cpuMs.p99,
+				result.gpuMs.mean, result.gpuMs.p50, result.gpuMs.p95, result.gpuMs.p99,
+				result.peakResidentBytes / (1024.0 * 1024.0)
+			);
+			std::fflush(stdout);
+			results.push_back(result);
+		}
+	}
+
+	// Scripts check the exit code.
+	if (options.jsonPath && !writeJson(options.jsonPath, results, options, renderer.multiDrawSupported())) {
+		std::fprintf(stderr, "Failed to write %s\n", options.jsonPath);
+		return 1;
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--objects") == 0 && value) {
+			options.objectCounts.clear();
+			for (const char *p = value; *p; ) {
+				char *end;
+				unsigned long long count = std::strtoull(p, &end, 10);
+				if (end == p || count < 1) {
+					std::fprintf(stderr, "Invalid object count list: %s\n", value);
+					return false;
+				}
+				options.objectCounts.push_back(static_cast<size_t>(count));
+				p = *end == ',' ? end + 1 : end;
+			}
+			std::sort(options.objectCounts.begin(), options.objectCounts.end());
+			i++;
+		}
+		else if (std::strcmp(arg, "--methods") == 0 && value) {
+			options.methods.clear();
+			for (const char *p = value; *p; ) {
+				size_t length = std::strcspn(p, ",");
+				int method = 0;
+				while (method < METHOD_COUNT && (std::strlen(methodNames[method]) != length || std::strncmp(p, methodNames[method], length) != 0))
+					method++;
+				if (method == METHOD_COUNT) {
+					std::fprintf(stderr, "Invalid method list: %s\n", value);
+					return false;
+				}
+				options.methods.push_back(static_cast<Method>(method));
+				p += p[length] == ',' ? length + 1 : length;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--warmup") == 0 && value) {
+			// At least one, the first frame of a run pays for deferred buffer uploads.
+			options.warmupFrames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--json") == 0 && value) {
+			options.jsonPath = value;
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--objects 10,100,...] [--methods per-draw,instanced,multi-draw] [--frames N] [--warmup N] [--json path]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Unit cube with a full texture on every face, 24 vertices of position and texture coords.
+Mesh generateCube() {
+	const glm::vec3 normals[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	Mesh mesh;
+	mesh.vertexSize = 5;
+	for (unsigned int face = 0; face < 6; face++) {
+		glm::vec3 normal = normals[face];
+		glm::vec3 u = face < 2 ? glm::vec3(0, 0, normal.x) : face < 4 ? glm::vec3(1, 0, 0) : glm::vec3(-normal.z, 0, 0);
+		glm::vec3 v = glm::cross(normal, u);
+		for (unsigned int corner = 0; corner < 4; corner++) {
+			float s = corner == 1 || corner == 2 ? 1.0f : 0.0f, t = corner >= 2 ? 1.0f : 0.0f;
+			glm::vec3 position = 0.5f * normal + (s - 0.5f) * u + (t - 0.5f) * v;
+			const float vertex[5] = { position.x, position.y, position.z, s, t };
+			mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + 5);
+		}
+		unsigned int base = face * 4;
+		const unsigned int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+		mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+	}
+
+	return mesh;
+}
+
+// Cubes on a grid centered on the origin, each turned about its own axis. extent is the grid's side length.
+std::vector<glm::mat4> generateScene(size_t count, float &extent) {
+	unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<double>(count))));
+	extent = side * CUBE_SPACING;
+	TransformArray transforms;
+	transforms.resize(count);
+	const glm::vec3 rotationAxis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+	for (size_t i = 0; i < count; i++) {
+		glm::vec3 cell(static_cast<float>(i % side), static_cast<float>(i / side % side), static_cast<float>(i / side / side));
+		transforms.setPosition(i, (cell - glm::vec3((side - 1) * 0.5f)) * CUBE_SPACING);
+		transforms.setRotation(i, glm::angleAxis(glm::radians(20.0f * i), rotationAxis));
+	}
+	std::vector<glm::mat4> models(count);
+	transforms.composeMatrices(0, count, &models[0][0][0]);
+
+	return models;
+}
+
+RunResult run(SceneRenderer &renderer, const std::vector<glm::mat4> &models, float extent, Method method, const Options &options) {
+	// One query per measured frame, all read once the run is over.
+	std::vector<unsigned int> queries(options.frames);
+	glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+
+	// The camera orbits outside the field, so every cube is in view and drawn.
+	float distance = extent * 1.5f + 5.0f, farPlane = distance + extent * 2.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(FRAMEBUFFER_WIDTH) / FRAMEBUFFER_HEIGHT, 0.1f, farPlane);
+	RunResult result = {};
+	result.objects = models.size();
+	result.method = method;
+	std::vector<double> cpuMs, gpuMs;
+	for (unsigned int frame = 0; frame < options.warmupFrames + options.frames; frame++) {
+		float angle = ORBIT_SPEED * frame;
+		glm::mat4 view = glm::lookAt(glm::vec3(std::cos(angle), 0.4f, std::sin(angle)) * distance, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		bool measured = frame >= options.warmupFrames;
+		Stopwatch frameTime;
+		if (measured)
+			glBeginQuery(GL_TIME_ELAPSED, queries[frame - options.warmupFrames]);
+		result.drawCalls = renderer.drawFrame(method, view, projection, farPlane);
+		// Nothing is presented, the flush stands in for the swap. The query ends after it, software renderers
+		// such as llvmpipe rasterize there.
+		glFlush();
+		if (measured)
+			glEndQuery(GL_TIME_ELAPSED);
+		if (measured)
+			cpuMs.push_back(frameTime.elapsedMs());
+	}
+
+	for (unsigned int query : queries) {
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		gpuMs.push_back(elapsed / 1.0e6);
+	}
+	glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+	result.cpuMs = summarize(cpuMs);
+	result.gpuMs = summarize(gpuMs);
+	result.peakResidentBytes = peakResidentBytes();
+
+	return result;
+}
+
+bool writeJson(const char *path, const std::vector<RunResult> &results, const Options &options, bool multiDraw) {
+	FILE *file = std::fopen(path, "w");
+	if (!file)
+		return false;
+
+	// Renderer strings are plain ASCII in practice, quotes and backslashes are all that need escaping.
+	std::string renderer;
+	for (const char *c = reinterpret_cast<const char *>(glGetString(GL_RENDERER)); c && *c; c++) {
+		if (*c == '"' || *c == '\\')
+			renderer += '\\';
+		if (static_cast<unsigned char>(*c) >= 0x20)
+			renderer += *c;
+	}
+	std::fprintf(
+		file, "{\n\t\"benchmark\": \"scene\",\n\t\"renderer\": \"%s\",\n\t\"width\": %d,\n\t\"height\": %d,\n"
+		"\t\"frames\": %u,\n\t\"warmupFrames\": %u,\n\t\"multiDrawIndirect\": %s,\n\t\"runs\": [",
+		renderer.c_str(), FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT, options.frames, options.warmupFrames, multiDraw ? "true" : "false"
+	);
+	for (size_t i = 0; i < results.size(); i++) {
+		const RunResult &result = results[i];
+		std::fprintf(
+			file, "%s\n\t\t{\n\t\t\t\"objects\": %zu,\n\t\t\t\"method\": \"%s\",\n\t\t\t\"drawCalls\": %u,\n"
+			"\t\t\t\"cpuMs\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f },\n"
+			"\t\t\t\"gpuMs\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f },\n"
+			"\t\t\t\"peakResidentBytes\": %zu\n\t\t}",
+			i > 0 ? "," : "", result.objects, methodNames[result.method], result.drawCalls,
+			result.cpuMs.mean, result.cpuMs.p50, result.cpuMs.p95, result.cpuMs.p99,
+			result.gpuMs.mean, result.gpuMs.p50, result.gpuMs.p95, result.gpuMs.p99,
+			result.peakResidentBytes
+		);
+	}
+	std::fprintf(file, "\n\t]\n}\n");
+
+	return std::fclose(file) == 0;
+}
+
+SceneRenderer::SceneRenderer() : batch(0), backend(state), models(nullptr) {
+	perDrawShader.compileProgram("resources/shaders/perDraw.vert", "resources/shaders/scene.frag");
+	instancedShader.compileProgram("resources/shaders/instanced.vert", "resources/shaders/scene.frag");
+	batchShader.compileProgram(
+		batch.multiDrawSupported() ? "resources/shaders/batch.vert" : "resources/shaders/batchFallback.vert",
+		"resources/shaders/scene.frag"
+	);
+
+	// Same compact format as the camera example's cubes, the batch packs its own copy.
+	cube = quantizeMesh(generateCube(), { 0, 3, -1 });
+	cubeMesh = batch.addMesh(cube);
+	batch.build();
+	for (Shader *shader : { &perDrawShader, &instancedShader }) {
+		shader->useProgram();
+		setDequantizationUniforms(*shader, cube);
+	}
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, cube.vertices.size(), cube.vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, cube.indices.size() * sizeof(unsigned int), cube.indices.data(), GL_STATIC_DRAW);
+	setVertexAttributes(cube);
+	// Per instance model matrices, ignored by the per-draw shader.
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	setInstanceMatrixAttribute(INSTANCE_MODEL_LOCATION);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	state.invalidate();
+
+	opaquePass = backend.addPass({ true, true, false });
+	cubeProgram = backend.addProgram(&perDrawShader);
+	cubeTextureSet = backend.addTextureSet({});
+	cubeVertexArray = backend.addVertexArray(VAO);
+}
+
+SceneRenderer::~SceneRenderer() {
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	glDeleteBuffers(1, &instanceVBO);
+	glDeleteVertexArrays(1, &VAO);
+}
+
+void SceneRenderer::setScene(const std::vector<glm::mat4> &models) {
+	this->models = &models;
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	state.invalidate();
+}
+
+unsigned int SceneRenderer::drawFrame(Method method, const glm::mat4 &view, const glm::mat4 &projection, float farPlane) {
+	const std::vector<glm::mat4> &models = *this->models;
+	unsigned int count = static_cast<unsigned int>(models.size());
+	state.setViewport(0, 0, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	unsigned int draws = 1;
+	if (method == METHOD_PER_DRAW) {
+		// One command per cube keyed by view depth, sorted front to back, as the camera example's simulation builds it.
+		queue.resize(count, count);
+		for (unsigned int i = 0; i < count; i++) {
+			float depth = -(view * models[i][3]).z / farPlane;
+			queue.setTransform(i, models[i]);
+			queue.setCommand(i, makeSortKey(opaquePass, cubeProgram, cubeTextureSet, cubeVertexArray, depth),
+				{ static_cast<unsigned int>(cube.indices.size()), 0, 0, 1, i });
+		}
+		queue.sort();
+		state.useProgram(perDrawShader.getProgram());
+		perDrawShader.setMat4("projection", projection);
+		perDrawShader.setMat4("view", view);
+		backend.execute(queue);
+		draws = backend.stats.draws;
+	}
+	else if (method == METHOD_INSTANCED) {
+		state.useProgram(instancedShader.getProgram());
+		instancedShader.setMat4("projection", projection);
+		instancedShader.setMat4("view", view);
+		state.bindVertexArray(VAO);
+		glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(cube.indices.size()), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count));
+	}
+	else {
+		state.useProgram(batchShader.getProgram());
+		batchShader.setMat4("projection", projection);
+		batchShader.setMat4("view", view);
+		batch.begin(count);
+		for (const glm::mat4 &model : models)
+			batch.draw(cubeMesh, model);
+		batch.submit(batchShader);
+		// The batch binds its own state.
+		state.invalidate();
+		draws = batch.stats.drawsSubmitted;
+	}
+
+	return draws;
+}
+
+bool SceneRenderer::multiDrawSupported() const {
+	return batch.multiDrawSupported();
+}
\ No newline at end of file
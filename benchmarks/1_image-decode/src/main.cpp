@@ -0,0 +1,229 @@
+﻿/*
+* Benchmark - stb_image decode throughput.
+* Decodes generated PNG and JPEG images single-threaded and across a thread pool.
+* Runs headless, no window or GL context is created.
+*
+* Usage: ImageDecodeBenchmark [--sizes 256,512,...] [--threads N] [--min-images N] [--formats png,jpeg]
+*/
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <latch>
+#include <thread>
+#include <vector>
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include "benchmark/benchmark.hpp"
+
+struct Options {
+	std::vector<int> sizes = { 256, 512, 1024, 2048, 4096, 8192 };
+	unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+	int minImages = 4;
+	bool png = true;
+	bool jpeg = true;
+};
+
+struct CorpusImage {
+	const char *format;
+	int size;
+	int numChannels;
+	std::vector<unsigned char> encoded;
+};
+
+struct RunResult {
+	double seconds;
+	size_t decodedBytes;
+	size_t failures;
+	std::vector<double> latenciesMs;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+std::vector<unsigned char> generateImage(int size, int numChannels);
+void appendEncoded(void *context, void *data, int size);
+RunResult decodeRun(const CorpusImage &image, size_t imageCount, unsigned int threadCount);
+void printResult(const CorpusImage &image, unsigned int threadCount, const RunResult &result);
+
+// Decode roughly this many pixels per run so small images get enough samples.
+const double PIXELS_PER_RUN = 64.0 * 1024.0 * 1024.0;
+// Cap concurrent decodes so 8192² RGBA across many cores stays within memory.
+const double DECODE_MEMORY_BUDGET = 4.0 * 1024.0 * 1024.0 * 1024.0;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const char *simd = "sse2";
+#elif defined(__ARM_NEON)
+	const char *simd = "neon";
+#else
+	const char *simd = "none";
+#endif
+	std::printf("stb_image decode benchmark, %u worker threads, SIMD: %s\n\n", options.threads, simd);
+	std::printf(
+		"%-6s %6s %3s %10s %7s %7s %10s %9s %9s %9s %9s\n",
+		"format", "size", "ch", "encoded", "threads", "images", "MB/s", "p50 ms", "p90 ms", "p99 ms", "peak RSS"
+	);
+
+	for (int size : options.sizes) {
+		// Corpus is generated per size so only one large image lives in memory at a time.
+		std::vector<CorpusImage> corpus;
+		for (int numChannels : { 3, 4 }) {
+			std::vector<unsigned char> pixels = generateImage(size, numChannels);
+			if (options.png) {
+				CorpusImage image = { "png", size, numChannels, {} };
+				stbi_write_png_to_func(appendEncoded, &image.encoded, size, size, numChannels, pixels.data(), size * numChannels);
+				corpus.push_back(std::move(image));
+			}
+			if (options.jpeg && numChannels == 3) {
+				CorpusImage image = { "jpeg", size, numChannels, {} };
+				stbi_write_jpg_to_func(appendEncoded, &image.encoded, size, size, numChannels, pixels.data(), 90);
+				corpus.push_back(std::move(image));
+			}
+		}
+
+		size_t imageCount = std::max<size_t>(options.minImages, static_cast<size_t>(PIXELS_PER_RUN / (static_cast<double>(size) * size)));
+		for (const CorpusImage &image : corpus) {
+			printResult(image, 1, decodeRun(image, imageCount, 1));
+			double decodedSize = static_cast<double>(size) * size * image.numChannels;
+			unsigned int threads = std::clamp(static_cast<unsigned int>(DECODE_MEMORY_BUDGET / decodedSize), 1u, options.threads);
+			if (threads > 1)
+				printResult(image, threads, decodeRun(image, imageCount * threads, threads));
+		}
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--sizes") == 0 && value) {
+			options.sizes.clear();
+			for (const char *p = value; *p; ) {
+				char *end;
+				long size = std::strtol(p, &end, 10);
+				if (end == p || size <= 0) {
+					std::fprintf(stderr, "Invalid size list: %s\n", value);
+					return false;
+				}
+				options.sizes.push_back(static_cast<int>(size));
+				p = *end == ',' ? end + 1 : end;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--threads") == 0 && value) {
+			options.threads = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+			i++;
+		}
+		else if (std::strcmp(arg, "--min-images") == 0 && value) {
+			options.minImages = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--formats") == 0 && value) {
+			options.png = std::strstr(value, "png") != nullptr;
+			options.jpeg = std::strstr(value, "jpeg") != nullptr || std::strstr(value, "jpg") != nullptr;
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--sizes 256,512,...] [--threads N] [--min-images N] [--formats png,jpeg]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Smooth gradients plus hashed noise, roughly as compressible as a photograph.
+std::vector<unsigned char> generateImage(int size, int numChannels) {
+	std::vector<unsigned char> pixels(static_cast<size_t>(size) * size * numChannels);
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u);
+			hash ^= hash >> 13;
+			hash *= 0x5BD1E995u;
+			hash ^= hash >> 15;
+			float u = static_cast<float>(x) / size, v = static_cast<float>(y) / size;
+			for (int c = 0; c < numChannels; c++) {
+				float value = c == 3
+					? 255.0f * u
+					: 128.0f + 90.0f * std::sin(6.0f * u + 2.0f * c) * std::cos(4.0f * v - c);
+				value += static_cast<float>((hash >> (c * 8)) & 0x07) - 4.0f;
+				pixels[(static_cast<size_t>(y) * size + x) * numChannels + c] = static_cast<unsigned char>(std::clamp(value, 0.0f, 255.0f));
+			}
+		}
+	}
+
+	return pixels;
+}
+
+// stb_image_write callback, context is the std::vector<unsigned char> being filled.
+void appendEncoded(void *context, void *data, int size) {
+	std::vector<unsigned char> &encoded = *static_cast<std::vector<unsigned char> *>(context);
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	encoded.insert(encoded.end(), bytes, bytes + size);
+}
+
+// Decode the same encoded image imageCount times, spread over threadCount workers.
+RunResult decodeRun(const CorpusImage &image, size_t imageCount, unsigned int threadCount) {
+	RunResult result = { 0.0, 0, 0, std::vector<double>(imageCount) };
+	std::atomic<size_t> nextImage(0), decodedBytes(0), failures(0);
+	std::latch ready(threadCount + 1);
+	std::latch start(1);
+
+	auto worker = [&]() {
+		ready.count_down();
+		start.wait();
+		for (size_t i = nextImage++; i < imageCount; i = nextImage++) {
+			Stopwatch latency;
+			int width, height, numChannels;
+			unsigned char *data = stbi_load_from_memory(
+				image.encoded.data(), static_cast<int>(image.encoded.size()),
+				&width, &height, &numChannels, 0
+			);
+			result.latenciesMs[i] = latency.elapsedMs();
+			if (data)
+				decodedBytes += static_cast<size_t>(width) * height * numChannels;
+			else
+				failures++;
+			stbi_image_free(data);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(worker);
+
+	// Time from release of all workers to completion of the last decode.
+	ready.arrive_and_wait();
+	Stopwatch wall;
+	start.count_down();
+	for (std::thread &thread : workers)
+		thread.join();
+	result.seconds = wall.elapsedSeconds();
+	result.decodedBytes = decodedBytes;
+	result.failures = failures;
+
+	return result;
+}
+
+void printResult(const CorpusImage &image, unsigned int threadCount, const RunResult &result) {
+	SampleStats latency = summarize(result.latenciesMs);
+	double megabytes = static_cast<double>(result.decodedBytes) / (1024.0 * 1024.0);
+	std::printf(
+		"%-6s %6d %3d %8.1fKB %7u %7zu %10.1f %9.3f %9.3f %9.3f %7.1fMB%s\n",
+		image.format, image.size, image.numChannels, image.encoded.size() / 1024.0,
+		threadCount, latency.count, megabytes / result.seconds,
+		latency.p50, latency.p90, latency.p99,
+		peakResidentBytes() / (1024.0 * 1024.0),
+		result.failures ? " (decode failures)" : ""
+	);
+	std::fflush(stdout);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vTexCoord;
+layout (location = 2) in vec3 vNormal;
+
+out vec3 fColor;
+
+uniform mat4 transform;
+// Identity for float vertices, mesh bounds for compact vertices.
+uniform vec3 positionScale;
+uniform vec3 positionOrigin;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOrigin;
+
+void main() {
+    vec2 texCoord = vTexCoord * texCoordScale + texCoordOrigin;
+    gl_Position = transform * vec4(vPos * positionScale + positionOrigin, 1.0);
+    // Consume every attribute so none of the fetches can be skipped.
+    fColor = vNormal * 0.5 + 0.5 + vec3(texCoord, 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+﻿/*
+* Benchmark - compact vertex formats.
+* Compares 32-byte float vertices (position, texture coords, normal) against the quantized
+* compact format on generated sphere meshes: memory footprint, quantization cost and error.
+* With --gpu, also measures GPU time per draw with timer queries on a hidden window, with
+* rasterization discarded so vertex fetch and shading dominate.
+*
+* Usage: VertexFormatBenchmark [--vertices 1000000,4000000,16000000] [--gpu] [--draws N]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "mesh/mesh.hpp"
+#include "shader/shader.hpp"
+#include "vertex/vertexformat.hpp"
+
+struct Options {
+	std::vector<size_t> vertexCounts = { 1000000, 4000000, 16000000 };
+	bool gpu = false;
+	int draws = 20;
+};
+
+struct QuantizationError {
+	double position; // Relative to the largest bounds extent.
+	double texCoord;
+	double normalDegrees;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+Mesh generateSphere(size_t targetVertexCount);
+QuantizationError measureError(const Mesh &mesh, const QuantizedMesh &quantized);
+double timeDraws(unsigned int VAO, size_t indexCount, int draws);
+
+const MeshAttributes SPHERE_ATTRIBUTES = { 0, 3, 5 };
+const unsigned int SPHERE_VERTEX_SIZE = 8;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	// Optional hidden window for GPU timing.
+	GLFWwindow *window = NULL;
+	if (options.gpu) {
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	#ifdef __APPLE__
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	#endif
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		window = glfwCreateWindow(64, 64, "VertexFormatBenchmark", NULL, NULL);
+		if (window)
+			glfwMakeContextCurrent(window);
+		if (window == NULL || !gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+			std::fprintf(stderr, "Failed to create GL context, skipping GPU timing.\n");
+			options.gpu = false;
+		}
+	}
+
+	std::printf(
+		"%10s %8s %10s %10s %7s %11s %10s %9s %9s%s\n",
+		"vertices", "format", "bytes/vtx", "vertex MB", "ratio", "quantize ms", "pos err", "uv err", "nrm deg",
+		options.gpu ? "   GPU ms/draw" : ""
+	);
+
+	for (size_t targetCount : options.vertexCounts) {
+		Mesh mesh = generateSphere(targetCount);
+		Stopwatch quantizeTime;
+		QuantizedMesh quantized = quantizeMesh(mesh, SPHERE_ATTRIBUTES);
+		double quantizeMs = quantizeTime.elapsedMs();
+		QuantizationError error = measureError(mesh, quantized);
+
+		double floatBytes = static_cast<double>(mesh.vertices.size() * sizeof(float));
+		double compactBytes = static_cast<double>(quantized.vertices.size());
+		double floatGpuMs = 0.0, compactGpuMs = 0.0;
+
+		if (options.gpu) {
+			Shader fetchShader("resources/shaders/fetch.vert", "resources/shaders/fetch.frag");
+			fetchShader.useProgram();
+			fetchShader.setMat4("transform", glm::mat4(1.0f));
+
+			unsigned int VAOs[2], VBOs[2], EBO;
+			glGenVertexArrays(2, VAOs);
+			glGenBuffers(2, VBOs);
+			glGenBuffers(1, &EBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+
+			// Float layout: position, texture coords, normal.
+			glBindVertexArray(VAOs[0]);
+			glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
+			glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			GLsizei stride = SPHERE_VERTEX_SIZE * sizeof(float);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(0));
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(3 * sizeof(float)));
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(5 * sizeof(float)));
+			glEnableVertexAttribArray(2);
+
+			glBindVertexArray(VAOs[1]);
+			glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
+			glBufferData(GL_ARRAY_BUFFER, quantized.vertices.size(), quantized.vertices.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			setVertexAttributes(quantized);
+			glBindVertexArray(0);
+
+			glEnable(GL_RASTERIZER_DISCARD);
+			fetchShader.setVec3("positionScale", glm::vec3(1.0f));
+			fetchShader.setVec3("positionOrigin", glm::vec3(0.0f));
+			fetchShader.setVec2("texCoordScale", glm::vec2(1.0f));
+			fetchShader.setVec2("texCoordOrigin", glm::vec2(0.0f));
+			floatGpuMs = timeDraws(VAOs[0], mesh.indices.size(), options.draws);
+			setDequantizationUniforms(fetchShader, quantized);
+			compactGpuMs = timeDraws(VAOs[1], quantized.indices.size(), options.draws);
+			glDisable(GL_RASTERIZER_DISCARD);
+
+			glDeleteBuffers(2, VBOs);
+			glDeleteBuffers(1, &EBO);
+			glDeleteVertexArrays(2, VAOs);
+		}
+
+		char gpuColumn[32] = "";
+		if (options.gpu)
+			std::snprintf(gpuColumn, sizeof(gpuColumn), " %13.3f", floatGpuMs);
+		std::printf(
+			"%10zu %8s %10u %10.1f %7.2f %11s %10s %9s %9s%s\n",
+			mesh.vertexCount(), "float", SPHERE_VERTEX_SIZE * static_cast<unsigned int>(sizeof(float)),
+			floatBytes / (1024.0 * 1024.0), 1.0, "-", "-", "-", "-", gpuColumn
+		);
+		if (options.gpu)
+			std::snprintf(gpuColumn, sizeof(gpuColumn), " %13.3f", compactGpuMs);
+		std::printf(
+			"%10zu %8s %10u %10.1f %7.2f %11.1f %10.2e %9.2e %9.3f%s\n",
+			quantized.vertexCount(), "compact", quantized.stride,
+			compactBytes / (1024.0 * 1024.0), compactBytes / floatBytes, quantizeMs,
+			error.position, error.texCoord, error.normalDegrees, gpuColumn
+		);
+		std::fflush(stdout);
+	}
+
+	if (window) {
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--vertices") == 0 && value) {
+			options.vertexCounts.clear();
+			for (const char *p = value; *p; ) {
+				char *end;
+				unsigned long long count = std::strtoull(p, &end, 10);
+				if (end == p || count < 16) {
+					std::fprintf(stderr, "Invalid vertex count list: %s\n", value);
+					return false;
+				}
+				options.vertexCounts.push_back(static_cast<size_t>(count));
+				p = *end == ',' ? end + 1 : end;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--gpu") == 0) {
+			options.gpu = true;
+		}
+		else if (std::strcmp(arg, "--draws") == 0 && value) {
+			options.draws = std::max(1, std::atoi(value));
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--vertices 1000000,4000000,...] [--gpu] [--draws N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// UV sphere of radius 10 with roughly the requested vertex count.
+Mesh generateSphere(size_t targetVertexCount) {
+	size_t rings = std::max<size_t>(2, static_cast<size_t>(std::sqrt(targetVertexCount / 2.0)));
+	size_t segments = std::max<size_t>(3, targetVertexCount / rings);
+	const float PI = 3.14159265358979f, RADIUS = 10.0f;
+
+	Mesh mesh;
+	mesh.vertexSize = SPHERE_VERTEX_SIZE;
+	mesh.vertices.reserve((rings + 1) * (segments + 1) * SPHERE_VERTEX_SIZE);
+	for (size_t ring = 0; ring <= rings; ring++) {
+		float v = static_cast<float>(ring) / rings;
+		float theta = v * PI;
+		for (size_t segment = 0; segment <= segments; segment++) {
+			float u = static_cast<float>(segment) / segments;
+			float phi = u * 2.0f * PI;
+			glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			const float vertex[SPHERE_VERTEX_SIZE] = {
+				normal.x * RADIUS, normal.y * RADIUS, normal.z * RADIUS,
+				u, v,
+				normal.x, normal.y, normal.z
+			};
+			mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + SPHERE_VERTEX_SIZE);
+		}
+	}
+
+	mesh.indices.reserve(rings * segments * 6);
+	for (size_t ring = 0; ring < rings; ring++) {
+		for (size_t segment = 0; segment < segments; segment++) {
+			unsigned int a = static_cast<unsigned int>(ring * (segments + 1) + segment);
+			unsigned int b = static_cast<unsigned int>(a + segments + 1);
+			const unsigned int quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+		}
+	}
+
+	return mesh;
+}
+
+QuantizationError measureError(const Mesh &mesh, const QuantizedMesh &quantized) {
+	QuantizationError error = { 0.0, 0.0, 0.0 };
+	float extent = 2.0f * std::max({ quantized.positionScale.x, quantized.positionScale.y, quantized.positionScale.z });
+
+	for (size_t i = 0; i < mesh.vertexCount(); i++) {
+		const float *vertex = &mesh.vertices[i * mesh.vertexSize];
+		glm::vec3 position, normal;
+		glm::vec2 texCoord;
+		dequantizeVertex(quantized, i, position, texCoord, normal);
+
+		glm::vec3 sourcePosition(vertex[0], vertex[1], vertex[2]);
+		glm::vec3 sourceNormal(vertex[5], vertex[6], vertex[7]);
+		error.position = std::max<double>(error.position, glm::length(position - sourcePosition) / extent);
+		error.texCoord = std::max<double>(error.texCoord, std::max(std::fabs(texCoord.x - vertex[3]), std::fabs(texCoord.y - vertex[4])));
+		float cosine = glm::clamp(glm::dot(glm::normalize(normal), sourceNormal), -1.0f, 1.0f);
+		error.normalDegrees = std::max<double>(error.normalDegrees, glm::degrees(std::acos(cosine)));
+	}
+
+	return error;
+}
+
+// Median GPU time of the draws, read back after each draw since this is not a frame loop.
+double timeDraws(unsigned int VAO, size_t indexCount, int draws) {
+	unsigned int query;
+	glGenQueries(1, &query);
+	glBindVertexArray(VAO);
+
+	std::vector<double> samples;
+	for (int i = -2; i < draws; i++) {
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+		glEndQuery(GL_TIME_ELAPSED);
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		if (i >= 0) // First two draws are warm-up.
+			samples.push_back(elapsed / 1.0e6);
+	}
+
+	glBindVertexArray(0);
+	glDeleteQueries(1, &query);
+
+	return summarize(samples).p50;
+}
\ No newline at end of file
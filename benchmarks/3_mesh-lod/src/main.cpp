@@ -0,0 +1,156 @@
+﻿/*
+* Benchmark - mesh LOD generation and selection.
+* Builds a quadric error LOD chain for a generated bumpy sphere and reports triangles, error and build time
+* per level. Then flies a Camera over a grid of instances, selecting LODs per frame from projected screen
+* space error, and reports triangles saved per frame and LOD switches per frame with and without hysteresis.
+*
+* Usage: MeshLodBenchmark [--triangles N] [--lods N] [--objects N] [--frames N] [--pixel-error PX]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "camera/camera.hpp"
+#include "mesh/mesh.hpp"
+#include "mesh/meshlod.hpp"
+#include "mesh/meshoptimizer.hpp"
+
+struct Options {
+	size_t triangles = 500000;
+	unsigned int lods = 6;
+	unsigned int objects = 4096;
+	unsigned int frames = 600;
+	float pixelError = DEFAULT_LOD_PIXEL_ERROR;
+};
+
+struct FlythroughResult {
+	double fullTriangles; // Per frame, everything at LOD 0.
+	double lodTriangles; // Per frame, with LOD selection.
+	double switches; // LOD changes per frame.
+	double selectMs; // Selection time per frame.
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+FlythroughResult flythrough(const std::vector<MeshLod> &lods, const Options &options, float hysteresis);
+
+const int VIEWPORT_HEIGHT = 1080;
+const float OBJECT_SPACING = 40.0f;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	Mesh mesh = generateBumpySphere(options.triangles, WINDING_CLOCKWISE);
+	optimizeMesh(mesh);
+	Stopwatch buildTime;
+	std::vector<MeshLod> lods = generateLods(mesh, options.lods);
+	double buildMs = buildTime.elapsedMs();
+
+	std::printf("LOD chain: %zu vertices, built in %.1f ms\n", mesh.vertexCount(), buildMs);
+	std::printf("%4s %10s %8s %12s\n", "lod", "triangles", "ratio", "error");
+	for (size_t i = 0; i < lods.size(); i++) {
+		std::printf(
+			"%4zu %10u %7.1f%% %12.5f\n",
+			i, lods[i].indexCount / 3, 100.0 * lods[i].indexCount / lods[0].indexCount, lods[i].error
+		);
+	}
+
+	std::printf(
+		"\nFlythrough: %u objects, %u frames, %.2f px error threshold\n",
+		options.objects, options.frames, options.pixelError
+	);
+	std::printf("%10s %14s %14s %14s %7s %12s %10s\n", "hysteresis", "full tris", "lod tris", "saved/frame", "saved", "switches/fr", "select ms");
+	for (float hysteresis : { 0.0f, DEFAULT_LOD_HYSTERESIS }) {
+		FlythroughResult result = flythrough(lods, options, hysteresis);
+		std::printf(
+			"%10.2f %14.0f %14.0f %14.0f %6.1f%% %12.1f %10.3f\n",
+			hysteresis, result.fullTriangles, result.lodTriangles, result.fullTriangles - result.lodTriangles,
+			100.0 * (1.0 - result.lodTriangles / result.fullTriangles), result.switches, result.selectMs
+		);
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--triangles") == 0 && value) {
+			options.triangles = std::max<size_t>(1000, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--lods") == 0 && value) {
+			options.lods = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--objects") == 0 && value) {
+			options.objects = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--pixel-error") == 0 && value) {
+			options.pixelError = std::max(0.01f, static_cast<float>(std::atof(value)));
+			i++;
+		}
+		else {
+			std::fprintf(
+				stderr, "Usage: %s [--triangles N] [--lods N] [--objects N] [--frames N] [--pixel-error PX]\n", argv[0]
+			);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Camera moves across a square grid of instances, bobbing back and forth along its path
+// the way a player does, which makes objects near a switch distance pop without hysteresis.
+FlythroughResult flythrough(const std::vector<MeshLod> &lods, const Options &options, float hysteresis) {
+	unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(options.objects))));
+	std::vector<glm::vec3> positions(options.objects);
+	for (unsigned int i = 0; i < options.objects; i++)
+		positions[i] = glm::vec3((i % side) * OBJECT_SPACING, 0.0f, -static_cast<float>(i / side) * OBJECT_SPACING);
+
+	Camera camera(glm::vec3(side * OBJECT_SPACING * 0.5f, 20.0f, 50.0f));
+	float pixelsPerUnit = lodPixelsPerUnit(camera.fovY, VIEWPORT_HEIGHT);
+	float pathLength = side * OBJECT_SPACING + 50.0f;
+	std::vector<unsigned int> currentLods(options.objects, 0);
+
+	FlythroughResult result = { 0.0, 0.0, 0.0, 0.0 };
+	double selectMs = 0.0;
+	for (unsigned int frame = 0; frame < options.frames; frame++) {
+		float progress = static_cast<float>(frame) / options.frames;
+		camera.position.z = 50.0f - progress * pathLength + 3.0f * std::sin(frame * 0.5f);
+
+		Stopwatch selectTime;
+		unsigned long long triangles = 0, switches = 0;
+		for (unsigned int i = 0; i < options.objects; i++) {
+			float distance = glm::length(positions[i] - camera.position);
+			unsigned int lod = selectLod(lods, currentLods[i], distance, pixelsPerUnit, options.pixelError, hysteresis);
+			switches += lod != currentLods[i];
+			currentLods[i] = lod;
+			triangles += lods[lod].indexCount / 3;
+		}
+		selectMs += selectTime.elapsedMs();
+
+		result.lodTriangles += static_cast<double>(triangles);
+		result.switches += static_cast<double>(switches);
+	}
+
+	result.fullTriangles = static_cast<double>(lods[0].indexCount / 3) * options.objects;
+	result.lodTriangles /= options.frames;
+	result.switches /= options.frames;
+	result.selectMs = selectMs / options.frames;
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,346 @@
+﻿/*
+* Benchmark - model loading.
+* Writes a generated terrain grid of roughly the requested size as Wavefront OBJ (quads with v/vt/vn)
+* and binary glTF, then loads both through the model loader. OBJ parse throughput is reported for
+* 1 thread up to every hardware thread, alongside welding and optimization time. Finally builds
+* the binary mesh cache from the OBJ once and reloads it, the path an application takes on start,
+* then uploads the mapped vertex and index sections to a headless context as they are and reads a
+* sample back to check it. Needs EGL for the upload, see HeadlessContext.
+*
+* Usage: ModelLoadBenchmark [--megabytes N] [--threads 1,2,4,...] [--keep]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "context/headlesscontext.hpp"
+#include "mesh/mesh.hpp"
+#include "model/meshcache.hpp"
+#include "model/modelloader.hpp"
+
+struct Options {
+	size_t megabytes = 256;
+	std::vector<unsigned int> threadCounts;
+	bool keep = false;
+};
+
+struct TerrainGrid {
+	size_t side; // Vertices per row and column.
+
+	glm::vec3 position(size_t x, size_t z) const;
+	glm::vec3 normal(size_t x, size_t z) const;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+bool writeObj(const char *path, const TerrainGrid &grid);
+bool writeGlb(const char *path, const TerrainGrid &grid);
+void printRow(const char *format, unsigned int threads, const ModelLoadStats &stats, const Mesh &mesh);
+bool uploadCache(const MeshCache &cache);
+bool bufferMatches(unsigned int buffer, const void *data, size_t size);
+
+const char *OBJ_PATH = "model-load-benchmark.obj";
+const char *GLB_PATH = "model-load-benchmark.glb";
+const char *CACHE_PATH = "model-load-benchmark.meshcache";
+const double OBJ_BYTES_PER_VERTEX = 175.0; // v, vt, vn lines plus one quad face per vertex.
+const size_t UPLOAD_CHECK_BYTES = 1 << 16; // Read back from each end of each buffer.
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	TerrainGrid grid;
+	grid.side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(options.megabytes * 1024.0 * 1024.0 / OBJ_BYTES_PER_VERTEX)));
+	Stopwatch writeTime;
+	if (!writeObj(OBJ_PATH, grid) || !writeGlb(GLB_PATH, grid)) {
+		std::fprintf(stderr, "Failed to write the generated models.\n");
+		return 1;
+	}
+	std::printf("Generated %zux%zu grid in %.1f s\n\n", grid.side, grid.side, writeTime.elapsedSeconds());
+
+	std::printf("%6s %8s %10s %10s %10s %10s %11s %11s\n", "format", "threads", "file MB", "parse ms", "MB/s", "index ms", "vertices", "triangles");
+	for (unsigned int threads : options.threadCounts) {
+		Mesh mesh;
+		ModelLoadStats stats;
+		if (!loadObj(OBJ_PATH, mesh, threads, &stats)) {
+			std::fprintf(stderr, "Failed to load %s\n", OBJ_PATH);
+			return 1;
+		}
+		printRow("obj", threads, stats, mesh);
+	}
+
+	Mesh mesh;
+	ModelLoadStats stats;
+	if (!loadGlb(GLB_PATH, mesh, &stats)) {
+		std::fprintf(stderr, "Failed to load %s\n", GLB_PATH);
+		return 1;
+	}
+	printRow("glb", 1, stats, mesh);
+
+	// First call misses and builds, second validates the hash and maps.
+	std::remove(CACHE_PATH);
+	std::printf("\n%6s %10s %10s %10s %6s\n", "cache", "ms", "file MB", "triangles", "lods");
+	MeshCache cache;
+	for (int pass = 0; pass < 2; pass++) {
+		bool rebuilt;
+		Stopwatch cacheTime;
+		if (!loadCachedModel(OBJ_PATH, CACHE_PATH, cache, {}, &rebuilt)) {
+			std::fprintf(stderr, "Failed to build %s\n", CACHE_PATH);
+			return 1;
+		}
+		std::printf(
+			"%6s %10.1f %10.1f %10u %6u\n",
+			rebuilt ? "build" : "hit", cacheTime.elapsedMs(), cache.header.fileSize / (1024.0 * 1024.0),
+			cache.lods()[0].indexCount / 3, cache.header.lodCount
+		);
+		std::fflush(stdout);
+	}
+	if (!uploadCache(cache))
+		return 1;
+	cache.close();
+
+	if (!options.keep) {
+		std::remove(OBJ_PATH);
+		std::remove(GLB_PATH);
+		std::remove(CACHE_PATH);
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--megabytes") == 0 && value) {
+			options.megabytes = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--threads") == 0 && value) {
+			for (const char *p = value; *p; ) {
+				char *end;
+				unsigned long count = std::strtoul(p, &end, 10);
+				if (end == p || count == 0) {
+					std::fprintf(stderr, "Invalid thread count list: %s\n", value);
+					return false;
+				}
+				options.threadCounts.push_back(static_cast<unsigned int>(count));
+				p = *end == ',' ? end + 1 : end;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--keep") == 0) {
+			options.keep = true;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--megabytes N] [--threads 1,2,4,...] [--keep]\n", argv[0]);
+			return false;
+		}
+	}
+
+	// Powers of two up to the hardware thread count.
+	if (options.threadCounts.empty()) {
+		unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+			options.threadCounts.push_back(threads);
+		options.threadCounts.push_back(hardwareThreads);
+	}
+
+	return true;
+}
+
+// Rolling hills over a 100 x 100 square.
+glm::vec3 TerrainGrid::position(size_t x, size_t z) const {
+	float u = static_cast<float>(x) / (side - 1), v = static_cast<float>(z) / (side - 1);
+	return glm::vec3(u * 100.0f, 4.0f * std::sin(u * 12.0f) * std::cos(v * 9.0f), v * 100.0f);
+}
+
+glm::vec3 TerrainGrid::normal(size_t x, size_t z) const {
+	float u = static_cast<float>(x) / (side - 1), v = static_cast<float>(z) / (side - 1);
+	float dx = 0.48f * std::cos(u * 12.0f) * std::cos(v * 9.0f);
+	float dz = -0.36f * std::sin(u * 12.0f) * std::sin(v * 9.0f);
+	return glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+}
+
+bool writeObj(const char *path, const TerrainGrid &grid) {
+	std::FILE *file = std::fopen(path, "wb");
+	if (!file)
+		return false;
+
+	std::vector<char> buffer;
+	buffer.reserve(1 << 22);
+	char line[160];
+	auto flush = [&](bool force) {
+		if (buffer.size() >= (1 << 22) - sizeof(line) || (force && !buffer.empty())) {
+			std::fwrite(buffer.data(), 1, buffer.size(), file);
+			buffer.clear();
+		}
+	};
+	auto append = [&](int length) {
+		buffer.insert(buffer.end(), line, line + length);
+		flush(false);
+	};
+
+	append(std::snprintf(line, sizeof(line), "# ModelLoadBenchmark terrain %zux%zu\no terrain\n", grid.side, grid.side));
+	for (size_t z = 0; z < grid.side; z++) {
+		for (size_t x = 0; x < grid.side; x++) {
+			glm::vec3 position = grid.position(x, z), normal = grid.normal(x, z);
+			float u = static_cast<float>(x) / (grid.side - 1), v = static_cast<float>(z) / (grid.side - 1);
+			append(std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", position.x, position.y, position.z));
+			append(std::snprintf(line, sizeof(line), "vt %.6f %.6f\n", u, v));
+			append(std::snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", normal.x, normal.y, normal.z));
+		}
+	}
+	for (size_t z = 0; z + 1 < grid.side; z++) {
+		for (size_t x = 0; x + 1 < grid.side; x++) {
+			// OBJ indices are 1-based, quads wind counter clockwise seen from above.
+			size_t a = z * grid.side + x + 1, b = a + grid.side;
+			append(std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, b + 1, b + 1, b + 1, a + 1, a + 1, a + 1));
+		}
+	}
+	flush(true);
+
+	return std::fclose(file) == 0;
+}
+
+bool writeGlb(const char *path, const TerrainGrid &grid) {
+	size_t vertexCount = grid.side * grid.side;
+	std::vector<float> positions, texCoords, normals;
+	std::vector<uint32_t> indices;
+	positions.reserve(vertexCount * 3);
+	texCoords.reserve(vertexCount * 2);
+	normals.reserve(vertexCount * 3);
+	for (size_t z = 0; z < grid.side; z++) {
+		for (size_t x = 0; x < grid.side; x++) {
+			glm::vec3 position = grid.position(x, z), normal = grid.normal(x, z);
+			positions.insert(positions.end(), { position.x, position.y, position.z });
+			texCoords.insert(texCoords.end(), { static_cast<float>(x) / (grid.side - 1), static_cast<float>(z) / (grid.side - 1) });
+			normals.insert(normals.end(), { normal.x, normal.y, normal.z });
+		}
+	}
+	for (size_t z = 0; z + 1 < grid.side; z++) {
+		for (size_t x = 0; x + 1 < grid.side; x++) {
+			uint32_t a = static_cast<uint32_t>(z * grid.side + x), b = a + static_cast<uint32_t>(grid.side);
+			indices.insert(indices.end(), { a, b, b + 1, a, b + 1, a + 1 });
+		}
+	}
+
+	size_t positionBytes = positions.size() * sizeof(float), texCoordBytes = texCoords.size() * sizeof(float);
+	size_t normalBytes = normals.size() * sizeof(float), indexBytes = indices.size() * sizeof(uint32_t);
+	size_t binBytes = positionBytes + texCoordBytes + normalBytes + indexBytes;
+	glm::vec3 minimum = grid.position(0, 0), maximum = grid.position(grid.side - 1, grid.side - 1);
+	char json[2048];
+	int jsonLength = std::snprintf(
+		json, sizeof(json),
+		"{\"asset\":{\"version\":\"2.0\",\"generator\":\"ModelLoadBenchmark\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+		"\"nodes\":[{\"mesh\":0}],\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"TEXCOORD_0\":1,\"NORMAL\":2},\"indices\":3}]}],"
+		"\"buffers\":[{\"byteLength\":%zu}],\"bufferViews\":["
+		"{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},"
+		"{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu},{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu}],\"accessors\":["
+		"{\"bufferView\":0,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\",\"min\":[%f,-4,%f],\"max\":[%f,4,%f]},"
+		"{\"bufferView\":1,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"},"
+		"{\"bufferView\":2,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"},"
+		"{\"bufferView\":3,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}]}",
+		binBytes, positionBytes, positionBytes, texCoordBytes, positionBytes + texCoordBytes, normalBytes,
+		positionBytes + texCoordBytes + normalBytes, indexBytes,
+		vertexCount, minimum.x, minimum.z, maximum.x, maximum.z, vertexCount, vertexCount, indices.size()
+	);
+	// Chunks are 4 byte aligned, JSON pads with spaces.
+	while (jsonLength % 4)
+		json[jsonLength++] = ' ';
+
+	std::vector<unsigned char> glb;
+	auto appendWord = [&glb](uint32_t word) {
+		glb.insert(glb.end(), reinterpret_cast<unsigned char *>(&word), reinterpret_cast<unsigned char *>(&word) + sizeof(word));
+	};
+	auto appendBytes = [&glb](const void *data, size_t size) {
+		glb.insert(glb.end(), static_cast<const unsigned char *>(data), static_cast<const unsigned char *>(data) + size);
+	};
+	glb.reserve(12 + 8 + jsonLength + 8 + binBytes);
+	appendWord(0x46546C67);
+	appendWord(2);
+	appendWord(static_cast<uint32_t>(12 + 8 + jsonLength + 8 + binBytes));
+	appendWord(static_cast<uint32_t>(jsonLength));
+	appendWord(0x4E4F534A);
+	appendBytes(json, jsonLength);
+	appendWord(static_cast<uint32_t>(binBytes));
+	appendWord(0x004E4942);
+	appendBytes(positions.data(), positionBytes);
+	appendBytes(texCoords.data(), texCoordBytes);
+	appendBytes(normals.data(), normalBytes);
+	appendBytes(indices.data(), indexBytes);
+
+	FILE *file = std::fopen(path, "wb");
+	if (!file)
+		return false;
+
+	bool written = std::fwrite(glb.data(), 1, glb.size(), file) == glb.size();
+	return std::fclose(file) == 0 && written;
+}
+
+void printRow(const char *format, unsigned int threads, const ModelLoadStats &stats, const Mesh &mesh) {
+	double megabytes = stats.fileBytes / (1024.0 * 1024.0);
+	std::printf(
+		"%6s %8u %10.1f %10.1f %10.1f %10.1f %11zu %11zu\n",
+		format, threads, megabytes, stats.parseMs, megabytes / (stats.parseMs / 1000.0), stats.indexMs,
+		mesh.vertexCount(), mesh.triangleCount()
+	);
+	std::fflush(stdout);
+}
+
+// Uploads the mapped sections with MeshCache::createBuffers. Missing EGL only skips the step, a mismatch fails it.
+bool uploadCache(const MeshCache &cache) {
+	std::unique_ptr<HeadlessContext> context = std::make_unique<HeadlessContext>(64, 64, 4, 6);
+	if (!context->valid())
+		context = std::make_unique<HeadlessContext>(64, 64);
+	if (!context->valid()) {
+		std::fprintf(stderr, "Failed to create headless GL context, skipping the cache upload.\n");
+		return true;
+	}
+
+	unsigned int vertexBuffer, indexBuffer;
+	Stopwatch uploadTime;
+	cache.createBuffers(vertexBuffer, indexBuffer);
+	glFinish();
+	double uploadMs = uploadTime.elapsedMs();
+	double megabytes = (cache.vertexBytes() + cache.indexBytes()) / (1024.0 * 1024.0);
+	bool matches = bufferMatches(vertexBuffer, cache.vertexData(), cache.vertexBytes())
+		&& bufferMatches(indexBuffer, cache.indexData(), cache.indexBytes());
+	glDeleteBuffers(1, &vertexBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+
+	std::printf(
+		"\n%10s %10s %10s %10s %10s\n%10s %10.1f %10.1f %10.1f %10s\n", "upload", "MB", "ms", "MB/s", "readback",
+		GLAD_GL_VERSION_4_4 ? "storage" : "data", megabytes, uploadMs, megabytes / (uploadMs / 1000.0), matches ? "ok" : "mismatch"
+	);
+	if (!matches)
+		std::fprintf(stderr, "Uploaded cache buffers differ from the mapped file.\n");
+
+	return matches;
+}
+
+// Compares the first and last UPLOAD_CHECK_BYTES of the buffer with the source.
+bool bufferMatches(unsigned int buffer, const void *data, size_t size) {
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	size_t checkSize = std::min(size, UPLOAD_CHECK_BYTES);
+	std::vector<unsigned char> readBack(checkSize);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	bool matches = true;
+	for (size_t offset : { size_t(0), size - checkSize }) {
+		glGetBufferSubData(GL_COPY_READ_BUFFER, offset, checkSize, readBack.data());
+		matches = matches && std::memcmp(readBack.data(), bytes + offset, checkSize) == 0;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	return matches;
+}
\ No newline at end of file
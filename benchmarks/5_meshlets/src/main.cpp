@@ -0,0 +1,266 @@
+﻿/*
+* Benchmark - meshlet cluster culling.
+* Splits a generated bumpy sphere into meshlets and reports cluster sizes and build time. Then orbits
+* a Camera around a grid of rotated instances, culling every instance's meshlets against the frustum
+* and normal cones each frame, and reports triangles rejected per frame, merged draw commands and
+* culling time with the scalar and SSE paths.
+* With --gpu, also draws the orbit on a headless context through the batch renderer, first every instance
+* whole and then only the merged visible ranges through drawRange, with back faces culled in both, and
+* reports draw calls and GPU time per frame. Needs EGL, see HeadlessContext.
+*
+* Usage: MeshletBenchmark [--triangles N] [--instances N] [--frames N] [--gpu]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "batch/batchrenderer.hpp"
+#include "benchmark/benchmark.hpp"
+#include "camera/camera.hpp"
+#include "context/headlesscontext.hpp"
+#include "culling/meshletculler.hpp"
+#include "mesh/mesh.hpp"
+#include "mesh/meshlet.hpp"
+#include "mesh/meshoptimizer.hpp"
+#include "shader/shader.hpp"
+#include "vertex/vertexformat.hpp"
+
+struct Options {
+	size_t triangles = 1000000;
+	unsigned int instances = 64;
+	unsigned int frames = 240;
+	bool gpu = false;
+};
+
+struct FrameTotals {
+	MeshletCullStats stats;
+	size_t commands;
+	double cullMs;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+Camera orbitCamera(unsigned int frame, const Options &options);
+FrameTotals runOrbit(const MeshletCuller &culler, const std::vector<glm::mat4> &models, const Options &options, bool simd);
+void runGpu(const Mesh &mesh, const MeshletMesh &meshlets, const MeshletCuller &culler, const std::vector<glm::mat4> &models, const Options &options);
+double drawOrbit(BatchRenderer &batch, Shader &shader, int mesh, const MeshletCuller *culler, const std::vector<glm::mat4> &models,
+	const Options &options, double &drawsPerFrame);
+
+const float INSTANCE_SPACING = 30.0f;
+const float ASPECT_RATIO = 16.0f / 9.0f;
+const int GPU_WIDTH = 1280, GPU_HEIGHT = 720;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	Mesh mesh = generateBumpySphere(options.triangles);
+	optimizeMesh(mesh);
+	Stopwatch buildTime;
+	MeshletMesh meshlets = buildMeshlets(mesh, mesh.indices);
+	double buildMs = buildTime.elapsedMs();
+
+	size_t cullable = 0;
+	double cutoffSum = 0.0;
+	for (const MeshletBounds &bounds : meshlets.bounds) {
+		cullable += bounds.coneCutoff < 1.0f;
+		cutoffSum += bounds.coneCutoff;
+	}
+	size_t meshletCount = meshlets.meshlets.size();
+	std::printf(
+		"%zu triangles -> %zu meshlets in %.1f ms, %.1f vertices and %.1f triangles per meshlet\n"
+		"%.1f%% have a usable normal cone, mean cutoff %.3f (sine of the cone half angle)\n\n",
+		meshlets.triangleCount(), meshletCount, buildMs,
+		static_cast<double>(meshlets.vertices.size()) / meshletCount, static_cast<double>(meshlets.triangleCount()) / meshletCount,
+		100.0 * cullable / meshletCount, cutoffSum / meshletCount
+	);
+
+	// Instances on a square grid with varied rotations, so cones face every direction.
+	unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(options.instances))));
+	std::vector<glm::mat4> models(options.instances);
+	for (unsigned int i = 0; i < options.instances; i++) {
+		glm::vec3 position((i % side) * INSTANCE_SPACING, 0.0f, (i / side) * INSTANCE_SPACING);
+		models[i] = glm::rotate(glm::translate(glm::mat4(1.0f), position), i * 0.7f, glm::normalize(glm::vec3(1.0f, 2.0f, 0.5f)));
+	}
+
+	MeshletCuller culler(meshlets);
+	std::printf(
+		"%u instances, %u frames, per frame:\n%6s %12s %12s %12s %12s %7s %10s %9s\n",
+		options.instances, options.frames, "path", "triangles", "frustum", "backfacing", "drawn", "culled", "commands", "cull ms"
+	);
+	for (bool simd : { false, true }) {
+		if (simd && !MeshletCuller::simdSupported())
+			continue;
+		FrameTotals totals = runOrbit(culler, models, options, simd);
+		double frames = options.frames;
+		double tested = totals.stats.trianglesTested / frames;
+		double outside = totals.stats.trianglesOutsideFrustum / frames;
+		double backfacing = totals.stats.trianglesBackfacing / frames;
+		std::printf(
+			"%6s %12.0f %12.0f %12.0f %12.0f %6.1f%% %10.0f %9.3f\n",
+			simd ? "sse" : "scalar", tested, outside, backfacing, tested - outside - backfacing,
+			100.0 * (outside + backfacing) / tested, totals.commands / frames, totals.cullMs / frames
+		);
+		std::fflush(stdout);
+	}
+
+	if (options.gpu)
+		runGpu(mesh, meshlets, culler, models, options);
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--triangles") == 0 && value) {
+			options.triangles = std::max<size_t>(1000, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--instances") == 0 && value) {
+			options.instances = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--gpu") == 0) {
+			options.gpu = true;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--triangles N] [--instances N] [--frames N] [--gpu]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Camera circles the grid at a fixed height, looking at its center.
+Camera orbitCamera(unsigned int frame, const Options &options) {
+	unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(options.instances))));
+	glm::vec3 center((side - 1) * INSTANCE_SPACING * 0.5f, 0.0f, (side - 1) * INSTANCE_SPACING * 0.5f);
+	float orbitRadius = side * INSTANCE_SPACING * 0.6f + 20.0f;
+	float angle = 2.0f * 3.14159265358979f * frame / options.frames;
+	glm::vec3 position = center + glm::vec3(std::cos(angle) * orbitRadius, 25.0f, std::sin(angle) * orbitRadius);
+	glm::vec3 front = glm::normalize(center - position);
+
+	return Camera(position, glm::degrees(std::atan2(front.z, front.x)), glm::degrees(std::asin(front.y)));
+}
+
+FrameTotals runOrbit(const MeshletCuller &culler, const std::vector<glm::mat4> &models, const Options &options, bool simd) {
+	FrameTotals totals = {};
+	std::vector<DrawElementsIndirectCommand> commands;
+	for (unsigned int frame = 0; frame < options.frames; frame++) {
+		Camera camera = orbitCamera(frame, options);
+		glm::mat4 viewProjection = glm::perspective(glm::radians(camera.fovY), ASPECT_RATIO, 0.1f, 1000.0f) * camera.getViewMatrix();
+
+		commands.clear();
+		Stopwatch cullTime;
+		for (const glm::mat4 &model : models)
+			culler.cull(model, viewProjection, camera.position, commands, totals.stats, simd);
+		totals.cullMs += cullTime.elapsedMs();
+		totals.commands += commands.size();
+	}
+
+	return totals;
+}
+
+void runGpu(const Mesh &mesh, const MeshletMesh &meshlets, const MeshletCuller &culler, const std::vector<glm::mat4> &models, const Options &options) {
+	std::unique_ptr<HeadlessContext> context = std::make_unique<HeadlessContext>(GPU_WIDTH, GPU_HEIGHT, 4, 6);
+	if (!context->valid())
+		context = std::make_unique<HeadlessContext>(GPU_WIDTH, GPU_HEIGHT);
+	if (!context->valid()) {
+		std::fprintf(stderr, "Failed to create headless GL context, skipping GPU timing.\n");
+		return;
+	}
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+
+	// Culler commands index MeshletMesh::indexBuffer(), so the batch gets the mesh with that index order.
+	BatchRenderer batch(0);
+	Mesh drawMesh = mesh;
+	drawMesh.indices = meshlets.indexBuffer();
+	int handle = batch.addMesh(quantizeMesh(drawMesh, { 0, 3, -1 }));
+	batch.build();
+	Shader shader(
+		batch.multiDrawSupported() ? "resources/shaders/batch.vert" : "resources/shaders/batchFallback.vert",
+		"resources/shaders/meshlet.frag"
+	);
+
+	std::printf("\n%s, multi-draw %s, per frame:\n%9s %10s %9s\n", reinterpret_cast<const char *>(glGetString(GL_RENDERER)),
+		batch.multiDrawSupported() ? "indirect" : "per draw fallback", "draw", "draws", "GPU ms");
+	for (bool culled : { false, true }) {
+		double draws;
+		double gpuMs = drawOrbit(batch, shader, handle, culled ? &culler : nullptr, models, options, draws);
+		std::printf("%9s %10.0f %9.3f\n", culled ? "meshlets" : "whole", draws, gpuMs);
+		std::fflush(stdout);
+	}
+}
+
+// Mean GPU time per frame of the orbit. Without a culler every instance is one draw of the whole mesh,
+// with one each instance draws its visible ranges. Queries are read after the orbit, the first frame is warm-up.
+double drawOrbit(BatchRenderer &batch, Shader &shader, int mesh, const MeshletCuller *culler, const std::vector<glm::mat4> &models,
+	const Options &options, double &drawsPerFrame) {
+	std::vector<unsigned int> queries(options.frames);
+	glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+	std::vector<DrawElementsIndirectCommand> commands;
+	std::vector<size_t> instanceCommands(models.size() + 1); // First command of each instance.
+	MeshletCullStats stats = {};
+	size_t draws = 0;
+	for (unsigned int frame = 0; frame <= options.frames; frame++) {
+		Camera camera = orbitCamera(frame % options.frames, options);
+		glm::mat4 view = camera.getViewMatrix();
+		glm::mat4 projection = glm::perspective(glm::radians(camera.fovY), ASPECT_RATIO, 0.1f, 1000.0f);
+		if (frame > 0)
+			glBeginQuery(GL_TIME_ELAPSED, queries[frame - 1]);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		shader.useProgram();
+		shader.setMat4("view", view);
+		shader.setMat4("projection", projection);
+		if (culler) {
+			commands.clear();
+			for (size_t i = 0; i < models.size(); i++) {
+				instanceCommands[i] = commands.size();
+				culler->cull(models[i], projection * view, camera.position, commands, stats);
+			}
+			instanceCommands[models.size()] = commands.size();
+			batch.begin(static_cast<unsigned int>(commands.size()));
+			for (size_t i = 0; i < models.size(); i++)
+				for (size_t c = instanceCommands[i]; c < instanceCommands[i + 1]; c++)
+					batch.drawRange(mesh, models[i], commands[c].firstIndex, commands[c].count);
+		}
+		else {
+			batch.begin(static_cast<unsigned int>(models.size()));
+			for (const glm::mat4 &model : models)
+				batch.draw(mesh, model);
+		}
+		batch.submit(shader);
+		// Software renderers such as llvmpipe rasterize at the flush, so the query ends after it.
+		glFlush();
+		if (frame > 0) {
+			glEndQuery(GL_TIME_ELAPSED);
+			draws += batch.stats.drawsSubmitted;
+		}
+	}
+
+	double totalMs = 0.0;
+	for (unsigned int query : queries) {
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+		totalMs += elapsed / 1.0e6;
+	}
+	glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+	drawsPerFrame = static_cast<double>(draws) / options.frames;
+
+	return totalMs / options.frames;
+}
\ No newline at end of file
@@ -0,0 +1,293 @@
+﻿/*
+* Benchmark - bounding volume hierarchy.
+* Scatters rotated boxes over a wide slab and builds the BVH over their bounds with 1 thread up to
+* every hardware thread. Then flies a Camera over the scene, comparing frustum queries and picking
+* rays against a linear scan of every object, and finally moves the objects every frame to compare
+* refitting with rebuilding, including how much query time the refit tree loses.
+*
+* Usage: BvhBenchmark [--objects N] [--threads 1,2,4,...] [--frames N] [--rays N]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "camera/camera.hpp"
+#include "culling/frustum.hpp"
+#include "spatial/aabb.hpp"
+#include "spatial/bvh.hpp"
+
+struct Options {
+	size_t objects = 1000000;
+	std::vector<unsigned int> threadCounts;
+	unsigned int frames = 120;
+	unsigned int rays = 10000;
+};
+
+struct Scene {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> velocities;
+	std::vector<glm::mat4> rotations;
+	std::vector<Aabb> bounds;
+
+	void updateBounds();
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+Scene generateScene(size_t objectCount);
+Camera flythroughCamera(unsigned int frame, unsigned int frameCount);
+glm::mat4 viewProjection(Camera &camera);
+size_t linearFrustum(const std::vector<Aabb> &bounds, const glm::mat4 &viewProjection);
+bool linearRaycast(const std::vector<Aabb> &bounds, const glm::vec3 &origin, const glm::vec3 &direction, BvhRayHit &hit);
+double frustumQueryMs(const Bvh &bvh, const Options &options, size_t &visible);
+
+const float SCENE_SIZE = 2000.0f, SCENE_HEIGHT = 100.0f;
+const float ASPECT_RATIO = 16.0f / 9.0f, FAR_PLANE = 1000.0f;
+const unsigned int LINEAR_RAYS = 50; // Every ray tests every object, keep this run short.
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	Scene scene = generateScene(options.objects);
+	std::printf("%zu objects\n\n%8s %10s %10s %10s\n", options.objects, "threads", "build ms", "nodes", "SAH cost");
+	Bvh bvh;
+	for (unsigned int threads : options.threadCounts) {
+		Stopwatch buildTime;
+		bvh.build(scene.bounds, threads);
+		double buildMs = buildTime.elapsedMs();
+		std::printf("%8u %10.1f %10zu %10.1f\n", threads, buildMs, bvh.nodeList().size(), bvh.sahCost());
+		std::fflush(stdout);
+	}
+
+	// Frustum queries, the linear scan uses the same box against plane test.
+	size_t visible = 0, linearVisible = 0;
+	double bvhMs = frustumQueryMs(bvh, options, visible);
+	Stopwatch linearTime;
+	for (unsigned int frame = 0; frame < options.frames; frame++) {
+		Camera camera = flythroughCamera(frame, options.frames);
+		linearVisible += linearFrustum(scene.bounds, viewProjection(camera));
+	}
+	double linearMs = linearTime.elapsedMs() / options.frames;
+	std::printf(
+		"\n%8s %12s %12s %12s %9s\n%8s %12.3f %12.3f %12.0f %8.1fx\n",
+		"frustum", "bvh ms", "linear ms", "visible", "speedup",
+		"", bvhMs, linearMs, static_cast<double>(visible) / options.frames, linearMs / bvhMs
+	);
+	if (visible != linearVisible)
+		std::printf("Mismatch: %zu visible through the BVH, %zu linearly\n", visible, linearVisible);
+
+	// Picking rays through random points on screen, checked against the scan for the first few.
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> ndc(-1.0f, 1.0f);
+	std::vector<glm::vec3> origins(options.rays), directions(options.rays);
+	for (unsigned int i = 0; i < options.rays; i++) {
+		Camera camera = flythroughCamera(i % options.frames, options.frames);
+		origins[i] = camera.position;
+		directions[i] = camera.getRayDirection(ndc(random), ndc(random), ASPECT_RATIO);
+	}
+	size_t hits = 0, mismatches = 0;
+	Stopwatch rayTime;
+	for (unsigned int i = 0; i < options.rays; i++) {
+		BvhRayHit hit;
+		hits += bvh.raycast(origins[i], directions[i], FAR_PLANE, hit);
+	}
+	double rayUs = rayTime.elapsedMs() * 1000.0 / options.rays;
+	unsigned int linearRays = std::min(options.rays, LINEAR_RAYS);
+	linearTime.reset();
+	for (unsigned int i = 0; i < linearRays; i++) {
+		BvhRayHit hit, linearHit;
+		bool found = bvh.raycast(origins[i], directions[i], FAR_PLANE, hit);
+		bool linearFound = linearRaycast(scene.bounds, origins[i], directions[i], linearHit);
+		mismatches += found != linearFound || (found && hit.distance != linearHit.distance);
+	}
+	double linearRayUs = linearTime.elapsedMs() * 1000.0 / linearRays;
+	std::printf(
+		"\n%8s %12s %12s %12s %9s\n%8s %12.2f %12.1f %11.1f%% %8.0fx\n",
+		"rays", "bvh us", "linear us", "hit", "speedup",
+		"", rayUs, linearRayUs, 100.0 * hits / options.rays, linearRayUs / rayUs
+	);
+	if (mismatches)
+		std::printf("Mismatch: %zu of %u rays differ from the linear scan\n", mismatches, linearRays);
+
+	// Objects drift every frame. Refit keeps the original topology, rebuild starts over.
+	std::printf("\n%8s %10s %10s %10s %12s\n", "moved", "update", "ms", "SAH cost", "frustum ms");
+	for (unsigned int step = 1; step <= 3; step++) {
+		for (size_t i = 0; i < scene.positions.size(); i++)
+			scene.positions[i] += scene.velocities[i];
+		scene.updateBounds();
+
+		Stopwatch refitTime;
+		bvh.refit(scene.bounds);
+		double refitMs = refitTime.elapsedMs();
+		double refitQueryMs = frustumQueryMs(bvh, options, visible);
+		std::printf("%8u %10s %10.1f %10.1f %12.3f\n", step, "refit", refitMs, bvh.sahCost(), refitQueryMs);
+
+		Bvh rebuilt;
+		Stopwatch rebuildTime;
+		rebuilt.build(scene.bounds);
+		double rebuildMs = rebuildTime.elapsedMs();
+		double rebuiltQueryMs = frustumQueryMs(rebuilt, options, visible);
+		std::printf("%8u %10s %10.1f %10.1f %12.3f\n", step, "rebuild", rebuildMs, rebuilt.sahCost(), rebuiltQueryMs);
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--objects") == 0 && value) {
+			options.objects = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--threads") == 0 && value) {
+			for (const char *p = value; *p; ) {
+				char *end;
+				unsigned long count = std::strtoul(p, &end, 10);
+				if (end == p || count == 0) {
+					std::fprintf(stderr, "Invalid thread count list: %s\n", value);
+					return false;
+				}
+				options.threadCounts.push_back(static_cast<unsigned int>(count));
+				p = *end == ',' ? end + 1 : end;
+			}
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--rays") == 0 && value) {
+			options.rays = std::max(1, std::atoi(value));
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--objects N] [--threads 1,2,4,...] [--frames N] [--rays N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	// Default to powers of two up to every hardware thread.
+	if (options.threadCounts.empty()) {
+		unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		for (unsigned int threads = 1; threads < hardwareThreads; threads *= 2)
+			options.threadCounts.push_back(threads);
+		options.threadCounts.push_back(hardwareThreads);
+	}
+
+	return true;
+}
+
+void Scene::updateBounds() {
+	const Aabb unitBox = { glm::vec3(-0.5f), glm::vec3(0.5f) };
+	for (size_t i = 0; i < positions.size(); i++) {
+		glm::mat4 model = rotations[i];
+		model[3] = glm::vec4(positions[i], 1.0f);
+		bounds[i] = transformAabb(unitBox, model);
+	}
+}
+
+// Boxes of varied size and rotation, denser toward the middle like a town around its center.
+Scene generateScene(size_t objectCount) {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> spread(0.0f, SCENE_SIZE * 0.2f);
+	Scene scene;
+	scene.positions.resize(objectCount);
+	scene.velocities.resize(objectCount);
+	scene.rotations.resize(objectCount);
+	scene.bounds.resize(objectCount);
+	for (size_t i = 0; i < objectCount; i++) {
+		scene.positions[i] = glm::vec3(
+			std::clamp(spread(random), -SCENE_SIZE * 0.5f, SCENE_SIZE * 0.5f),
+			unit(random) * SCENE_HEIGHT,
+			std::clamp(spread(random), -SCENE_SIZE * 0.5f, SCENE_SIZE * 0.5f)
+		);
+		scene.velocities[i] = (glm::vec3(unit(random), unit(random), unit(random)) - glm::vec3(0.5f)) * 2.0f;
+		float size = 0.5f + 2.5f * unit(random) * unit(random);
+		glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), unit(random) * 6.2831853f, glm::normalize(glm::vec3(unit(random), 1.0f, unit(random))));
+		scene.rotations[i] = glm::scale(rotation, glm::vec3(size));
+	}
+	scene.updateBounds();
+
+	return scene;
+}
+
+// Camera circles the center at low altitude, looking slightly down and ahead of its path.
+Camera flythroughCamera(unsigned int frame, unsigned int frameCount) {
+	float angle = 2.0f * 3.14159265358979f * frame / frameCount;
+	glm::vec3 position(std::cos(angle) * SCENE_SIZE * 0.3f, SCENE_HEIGHT * 1.2f, std::sin(angle) * SCENE_SIZE * 0.3f);
+	float yaw = glm::degrees(angle) + 135.0f;
+	return Camera(position, yaw, -15.0f);
+}
+
+glm::mat4 viewProjection(Camera &camera) {
+	return glm::perspective(glm::radians(camera.fovY), ASPECT_RATIO, 0.1f, FAR_PLANE) * camera.getViewMatrix();
+}
+
+size_t linearFrustum(const std::vector<Aabb> &bounds, const glm::mat4 &viewProjection) {
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+	size_t visible = 0;
+	for (const Aabb &box : bounds) {
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++) {
+			const glm::vec4 &plane = planes[p];
+			inside = plane.w
+				+ plane.x * (plane.x > 0.0f ? box.max.x : box.min.x)
+				+ plane.y * (plane.y > 0.0f ? box.max.y : box.min.y)
+				+ plane.z * (plane.z > 0.0f ? box.max.z : box.min.z) >= 0.0f;
+		}
+		visible += inside;
+	}
+
+	return visible;
+}
+
+bool linearRaycast(const std::vector<Aabb> &bounds, const glm::vec3 &origin, const glm::vec3 &direction, BvhRayHit &hit) {
+	glm::vec3 inverseDirection = 1.0f / direction;
+	bool found = false;
+	float closest = FAR_PLANE;
+	for (size_t i = 0; i < bounds.size(); i++) {
+		glm::vec3 t0 = (bounds[i].min - origin) * inverseDirection;
+		glm::vec3 t1 = (bounds[i].max - origin) * inverseDirection;
+		float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), std::max(std::min(t0.z, t1.z), 0.0f));
+		float tFar = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), std::min(std::max(t0.z, t1.z), closest));
+		if (tNear <= tFar && (!found || tNear < closest)) {
+			closest = tNear;
+			hit = { static_cast<unsigned int>(i), tNear };
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+// Mean milliseconds per frame of the flythrough, visible counts the objects returned over all frames.
+double frustumQueryMs(const Bvh &bvh, const Options &options, size_t &visible) {
+	std::vector<unsigned int> objects;
+	visible = 0;
+	double totalMs = 0.0;
+	for (unsigned int frame = 0; frame < options.frames; frame++) {
+		Camera camera = flythroughCamera(frame, options.frames);
+		glm::mat4 matrix = viewProjection(camera);
+		objects.clear();
+		Stopwatch queryTime;
+		bvh.queryFrustum(matrix, objects);
+		totalMs += queryTime.elapsedMs();
+		visible += objects.size();
+	}
+
+	return totalMs / options.frames;
+}
\ No newline at end of file
@@ -0,0 +1,245 @@
+﻿/*
+* Benchmark - dynamic spatial index.
+* Every object orbits its own anchor, like the rotating cubes of the coordinate systems exercises,
+* so all of them move every frame. Each frame updates the index, then runs one frustum query from a
+* circling Camera plus a batch of sphere and ray queries. The loose octree moves objects in place,
+* the BVH is either refit or rebuilt. Reports update and query time per frame, and checks the
+* octree's frustum results against a linear scan on the last frame.
+*
+* Usage: LooseOctreeBenchmark [--objects N] [--frames N] [--queries N]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "camera/camera.hpp"
+#include "culling/frustum.hpp"
+#include "spatial/aabb.hpp"
+#include "spatial/bvh.hpp"
+#include "spatial/looseoctree.hpp"
+
+struct Options {
+	size_t objects = 100000;
+	unsigned int frames = 120;
+	unsigned int queries = 256; // Sphere and ray queries per frame, each.
+};
+
+struct Orbiter {
+	glm::vec3 anchor;
+	glm::vec3 axisX;
+	glm::vec3 axisY;
+	float orbitRadius;
+	float angularSpeed; // Radians per frame.
+	float radius;
+
+	glm::vec3 position(unsigned int frame) const;
+};
+
+enum Method { METHOD_OCTREE, METHOD_BVH_REFIT, METHOD_BVH_REBUILD, METHOD_COUNT };
+const char *methodNames[METHOD_COUNT] = { "octree", "bvh refit", "bvh rebuild" };
+
+struct FrameTotals {
+	double updateMs;
+	double queryMs;
+	size_t results;
+	size_t relocations;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+std::vector<Orbiter> generateOrbiters(size_t count);
+glm::mat4 frameViewProjection(unsigned int frame);
+FrameTotals run(Method method, const std::vector<Orbiter> &orbiters, const Options &options);
+size_t linearFrustum(const std::vector<Orbiter> &orbiters, unsigned int frame, const glm::mat4 &viewProjection);
+
+const float REGION_HALF_SIZE = 500.0f;
+const float ASPECT_RATIO = 16.0f / 9.0f, FAR_PLANE = 600.0f;
+const float QUERY_RADIUS = 10.0f;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	std::vector<Orbiter> orbiters = generateOrbiters(options.objects);
+	std::printf(
+		"%zu moving objects, %u frames, 1 frustum + %u sphere + %u ray queries per frame\n\n%12s %10s %10s %10s %12s %12s\n",
+		options.objects, options.frames, options.queries, options.queries,
+		"method", "update ms", "query ms", "total ms", "results", "relocations"
+	);
+	for (int method = 0; method < METHOD_COUNT; method++) {
+		FrameTotals totals = run(static_cast<Method>(method), orbiters, options);
+		double frames = options.frames;
+		std::printf(
+			"%12s %10.3f %10.3f %10.3f %12.0f %12.0f\n",
+			methodNames[method], totals.updateMs / frames, totals.queryMs / frames, (totals.updateMs + totals.queryMs) / frames,
+			totals.results / frames, totals.relocations / frames
+		);
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--objects") == 0 && value) {
+			options.objects = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else if (std::strcmp(arg, "--queries") == 0 && value) {
+			options.queries = std::max(0, std::atoi(value));
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--objects N] [--frames N] [--queries N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+glm::vec3 Orbiter::position(unsigned int frame) const {
+	float angle = angularSpeed * frame;
+	return anchor + (axisX * std::cos(angle) + axisY * std::sin(angle)) * orbitRadius;
+}
+
+std::vector<Orbiter> generateOrbiters(size_t count) {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<Orbiter> orbiters(count);
+	for (Orbiter &orbiter : orbiters) {
+		orbiter.anchor = (glm::vec3(unit(random), unit(random) * 0.2f, unit(random)) * 2.0f - glm::vec3(1.0f, 0.2f, 1.0f)) * REGION_HALF_SIZE * 0.9f;
+		glm::vec3 axis = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - glm::vec3(0.5f));
+		orbiter.axisX = glm::normalize(glm::cross(axis, glm::vec3(0.0f, 1.0f, 0.0f)));
+		orbiter.axisY = glm::cross(axis, orbiter.axisX);
+		orbiter.orbitRadius = 2.0f + 18.0f * unit(random);
+		orbiter.angularSpeed = 0.01f + 0.05f * unit(random);
+		// Unit cubes scaled 0.5 - 3, bounded by the sphere through their corners.
+		orbiter.radius = (0.5f + 2.5f * unit(random) * unit(random)) * 0.8660254f;
+	}
+
+	return orbiters;
+}
+
+// Camera circles inside the region at low altitude, looking along its path and slightly down.
+glm::mat4 frameViewProjection(unsigned int frame) {
+	float angle = 0.02f * frame;
+	glm::vec3 position(std::cos(angle) * REGION_HALF_SIZE * 0.5f, 60.0f, std::sin(angle) * REGION_HALF_SIZE * 0.5f);
+	Camera camera(position, glm::degrees(angle) + 90.0f, -10.0f);
+	return glm::perspective(glm::radians(camera.fovY), ASPECT_RATIO, 0.1f, FAR_PLANE) * camera.getViewMatrix();
+}
+
+FrameTotals run(Method method, const std::vector<Orbiter> &orbiters, const Options &options) {
+	size_t count = orbiters.size();
+	LooseOctree octree(glm::vec3(0.0f), REGION_HALF_SIZE);
+	std::vector<unsigned int> ids(count);
+	std::vector<Aabb> bounds(count);
+	Bvh bvh;
+	auto boundsAt = [&](size_t i, unsigned int frame) {
+		glm::vec3 center = orbiters[i].position(frame);
+		return Aabb{ center - glm::vec3(orbiters[i].radius), center + glm::vec3(orbiters[i].radius) };
+	};
+	if (method == METHOD_OCTREE) {
+		for (size_t i = 0; i < count; i++)
+			ids[i] = octree.insert(orbiters[i].position(0), orbiters[i].radius);
+		octree.takeRelocationCount();
+	}
+	else {
+		for (size_t i = 0; i < count; i++)
+			bounds[i] = boundsAt(i, 0);
+		bvh.build(bounds);
+	}
+
+	// Query points are fixed, so every method answers the same questions.
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> coordinate(-REGION_HALF_SIZE, REGION_HALF_SIZE);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<glm::vec3> queryPoints(options.queries), queryDirections(options.queries);
+	for (unsigned int q = 0; q < options.queries; q++) {
+		queryPoints[q] = glm::vec3(coordinate(random), coordinate(random) * 0.2f, coordinate(random));
+		queryDirections[q] = glm::normalize(glm::vec3(unit(random), unit(random) * 0.2f, unit(random)));
+	}
+
+	FrameTotals totals = {};
+	std::vector<unsigned int> results;
+	for (unsigned int frame = 1; frame <= options.frames; frame++) {
+		Stopwatch updateTime;
+		if (method == METHOD_OCTREE) {
+			for (size_t i = 0; i < count; i++)
+				octree.move(ids[i], orbiters[i].position(frame), orbiters[i].radius);
+			totals.relocations += octree.takeRelocationCount();
+		}
+		else {
+			for (size_t i = 0; i < count; i++)
+				bounds[i] = boundsAt(i, frame);
+			if (method == METHOD_BVH_REFIT)
+				bvh.refit(bounds);
+			else
+				bvh.build(bounds);
+		}
+		totals.updateMs += updateTime.elapsedMs();
+
+		glm::mat4 viewProjection = frameViewProjection(frame);
+		results.clear();
+		Stopwatch queryTime;
+		if (method == METHOD_OCTREE) {
+			octree.queryFrustum(viewProjection, results);
+			for (unsigned int q = 0; q < options.queries; q++) {
+				octree.querySphere(queryPoints[q], QUERY_RADIUS, results);
+				OctreeRayHit hit;
+				totals.results += octree.raycast(queryPoints[q], queryDirections[q], FAR_PLANE, hit);
+			}
+		}
+		else {
+			bvh.queryFrustum(viewProjection, results);
+			for (unsigned int q = 0; q < options.queries; q++) {
+				bvh.queryBox({ queryPoints[q] - glm::vec3(QUERY_RADIUS), queryPoints[q] + glm::vec3(QUERY_RADIUS) }, results);
+				BvhRayHit hit;
+				totals.results += bvh.raycast(queryPoints[q], queryDirections[q], FAR_PLANE, hit);
+			}
+		}
+		totals.queryMs += queryTime.elapsedMs();
+		totals.results += results.size();
+	}
+
+	// Culling must be conservative and exact on the spheres, the same count as testing every object.
+	if (method == METHOD_OCTREE) {
+		glm::mat4 viewProjection = frameViewProjection(options.frames);
+		results.clear();
+		octree.queryFrustum(viewProjection, results);
+		size_t expected = linearFrustum(orbiters, options.frames, viewProjection);
+		if (results.size() != expected)
+			std::printf("Mismatch: %zu visible in the octree, %zu linearly\n", results.size(), expected);
+	}
+
+	return totals;
+}
+
+size_t linearFrustum(const std::vector<Orbiter> &orbiters, unsigned int frame, const glm::mat4 &viewProjection) {
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+	size_t visible = 0;
+	for (const Orbiter &orbiter : orbiters) {
+		glm::vec3 center = orbiter.position(frame);
+		bool inside = true;
+		for (int p = 0; p < 6 && inside; p++)
+			inside = glm::dot(glm::vec3(planes[p]), center) + planes[p].w >= -orbiter.radius;
+		visible += inside;
+	}
+
+	return visible;
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+﻿/*
+* Benchmark - sort-keyed render command queue.
+* A multi-material scene: every object draws one of a set of meshes with a random program and texture set,
+* submitted in declaration order like the straight-line draw loops. Each frame builds the queue from the
+* objects' view depths and sorts it, with the queue's radix sort and with std::sort over the same entries.
+* Reports sort time per frame and the program, texture and vertex array changes a backend would issue for
+* the submission order and for the sorted order. No GL context, the state changes are counted.
+*
+* Usage: RenderQueueBenchmark [--draws N] [--programs N] [--textures N] [--meshes N] [--frames N]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "render/renderqueue.hpp"
+
+struct Options {
+	unsigned int draws = 100000;
+	unsigned int programs = 8;
+	unsigned int textures = 64; // Texture sets.
+	unsigned int meshes = 32; // One vertex array each.
+	unsigned int frames = 60;
+};
+
+struct SceneObject {
+	glm::mat4 model;
+	unsigned int program;
+	unsigned int textureSet;
+	unsigned int mesh;
+	bool transparent;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+std::vector<SceneObject> generateScene(const Options &options);
+void fillQueue(RenderQueue &queue, const std::vector<SceneObject> &objects, const glm::mat4 &view);
+void printStats(const char *order, const RenderStateStats &stats);
+
+const float SCENE_HALF_SIZE = 200.0f, FAR_PLANE = 500.0f;
+const float TRANSPARENT_FRACTION = 0.1f;
+const unsigned int OPAQUE_PASS = 0, TRANSPARENT_PASS = 1;
+const unsigned int MESH_INDEX_COUNT = 36;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	std::vector<SceneObject> objects = generateScene(options);
+	RenderQueue queue;
+	std::vector<RenderQueue::Entry> reference;
+	std::vector<double> fillTimes, radixTimes, stdTimes;
+	RenderStateStats unsortedStats = {}, sortedStats = {};
+	bool ordersMatch = true;
+	for (unsigned int frame = 0; frame < options.frames; frame++) {
+		// Camera circles the scene, so depths and the sorted order change every frame.
+		float angle = 0.05f * frame;
+		glm::vec3 eye(std::cos(angle) * SCENE_HALF_SIZE, 20.0f, std::sin(angle) * SCENE_HALF_SIZE);
+		glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		Stopwatch fillTime;
+		fillQueue(queue, objects, view);
+		fillTimes.push_back(fillTime.elapsedMs());
+		unsortedStats = countStateChanges(queue);
+
+		reference = queue.entryList();
+		Stopwatch stdTime;
+		std::sort(reference.begin(), reference.end(), [](const RenderQueue::Entry &a, const RenderQueue::Entry &b) {
+			return a.key < b.key;
+		});
+		stdTimes.push_back(stdTime.elapsedMs());
+
+		Stopwatch radixTime;
+		queue.sort();
+		radixTimes.push_back(radixTime.elapsedMs());
+		sortedStats = countStateChanges(queue);
+
+		// Keys must come out in the same order, equal keys may differ in command order since std::sort is unstable.
+		const std::vector<RenderQueue::Entry> &sorted = queue.entryList();
+		for (size_t i = 0; i < sorted.size() && ordersMatch; i++)
+			ordersMatch = sorted[i].key == reference[i].key;
+	}
+
+	std::printf(
+		"%u draws, %u programs, %u texture sets, %u meshes, %.0f%% transparent, %u frames\n\n",
+		options.draws, options.programs, options.textures, options.meshes, TRANSPARENT_FRACTION * 100.0f, options.frames
+	);
+	std::printf("%12s %10s %10s %10s\n", "ms/frame", "mean", "p50", "p95");
+	const char *names[3] = { "fill", "radix sort", "std::sort" };
+	const std::vector<double> *times[3] = { &fillTimes, &radixTimes, &stdTimes };
+	for (int i = 0; i < 3; i++) {
+		SampleStats summary = summarize(*times[i]);
+		std::printf("%12s %10.3f %10.3f %10.3f\n", names[i], summary.mean, summary.p50, summary.p95);
+	}
+	std::printf("\n%12s %10s %10s %10s %10s %10s\n", "order", "passes", "programs", "textures", "vaos", "draws");
+	printStats("submitted", unsortedStats);
+	printStats("sorted", sortedStats);
+	if (!ordersMatch)
+		std::printf("Mismatch: radix sort and std::sort disagree on key order\n");
+	std::fflush(stdout);
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		unsigned int *target = nullptr;
+		if (std::strcmp(arg, "--draws") == 0)
+			target = &options.draws;
+		else if (std::strcmp(arg, "--programs") == 0)
+			target = &options.programs;
+		else if (std::strcmp(arg, "--textures") == 0)
+			target = &options.textures;
+		else if (std::strcmp(arg, "--meshes") == 0)
+			target = &options.meshes;
+		else if (std::strcmp(arg, "--frames") == 0)
+			target = &options.frames;
+		if (!target || !value) {
+			std::fprintf(stderr, "Usage: %s [--draws N] [--programs N] [--textures N] [--meshes N] [--frames N]\n", argv[0]);
+			return false;
+		}
+		*target = static_cast<unsigned int>(std::max(1, std::atoi(value)));
+		i++;
+	}
+	// Handles must fit their key fields.
+	options.programs = std::min(options.programs, 1u << SORT_KEY_PROGRAM_BITS);
+	options.textures = std::min(options.textures, 1u << SORT_KEY_TEXTURE_SET_BITS);
+	options.meshes = std::min(options.meshes, 1u << SORT_KEY_VERTEX_ARRAY_BITS);
+
+	return true;
+}
+
+std::vector<SceneObject> generateScene(const Options &options) {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> coordinate(-SCENE_HALF_SIZE, SCENE_HALF_SIZE);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<SceneObject> objects(options.draws);
+	for (SceneObject &object : objects) {
+		object.model = glm::translate(glm::mat4(1.0f), glm::vec3(coordinate(random), coordinate(random) * 0.1f, coordinate(random)));
+		// Materials tie a texture set to a program, as they would in a real scene.
+		object.textureSet = random() % options.textures;
+		object.program = object.textureSet % options.programs;
+		object.mesh = random() % options.meshes;
+		object.transparent = unit(random) < TRANSPARENT_FRACTION;
+	}
+
+	return objects;
+}
+
+void fillQueue(RenderQueue &queue, const std::vector<SceneObject> &objects, const glm::mat4 &view) {
+	queue.clear();
+	for (const SceneObject &object : objects) {
+		float depth = -(view * object.model[3]).z / FAR_PLANE;
+		// Transparent objects draw after opaque ones, back to front.
+		uint64_t key = object.transparent
+			? makeSortKey(TRANSPARENT_PASS, object.program, object.textureSet, object.mesh, 1.0f - depth)
+			: makeSortKey(OPAQUE_PASS, object.program, object.textureSet, object.mesh, depth);
+		DrawCommand command = { MESH_INDEX_COUNT, 0, 0, 1, queue.addTransform(object.model) };
+		queue.submit(key, command);
+	}
+}
+
+void printStats(const char *order, const RenderStateStats &stats) {
+	std::printf(
+		"%12s %10u %10u %10u %10u %10u\n",
+		order, stats.passChanges, stats.programChanges, stats.textureSetChanges, stats.vertexArrayChanges, stats.draws
+	);
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+﻿/*
+* Benchmark - work-stealing job system.
+* Per-frame CPU work of a large scene of spinning cubes, split over the job system at 1, 2, 4 and every
+* hardware thread: model matrices from glm::translate and glm::rotate, frustum culling of their bounding
+* spheres from a circling Camera, and building sort-keyed draw commands for the visible ones. Culling
+* counts visible objects per chunk, command building writes each chunk at its prefix offset, so the two
+* stages depend on each other through the counts. Reports ms per stage and speedup over one thread.
+*
+* Usage: JobSystemBenchmark [--objects N] [--frames N]
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "benchmark/benchmark.hpp"
+#include "camera/camera.hpp"
+#include "culling/frustum.hpp"
+#include "render/renderqueue.hpp"
+#include "thread/jobsystem.hpp"
+
+struct Options {
+	size_t objects = 1000000;
+	unsigned int frames = 30;
+};
+
+struct Scene {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> axes;
+	std::vector<float> angularSpeeds; // Radians per frame.
+};
+
+enum Stage { STAGE_TRANSFORMS, STAGE_CULLING, STAGE_COMMANDS, STAGE_COUNT };
+const char *stageNames[STAGE_COUNT] = { "transforms", "culling", "commands" };
+
+struct RunResult {
+	double stageMs[STAGE_COUNT];
+	size_t visible; // On the last frame.
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+Scene generateScene(size_t count);
+RunResult run(const Scene &scene, unsigned int threadCount, const Options &options);
+
+const float SCENE_HALF_SIZE = 300.0f, FAR_PLANE = 400.0f, ASPECT_RATIO = 16.0f / 9.0f;
+const float CUBE_RADIUS = 0.8660254f; // Unit cube corners.
+const size_t CHUNK_SIZE = 8192; // Objects per culling and command chunk.
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<unsigned int> threadCounts = { 1, 2, 4, hardwareThreads };
+	std::sort(threadCounts.begin(), threadCounts.end());
+	threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+	Scene scene = generateScene(options.objects);
+	std::printf("%zu objects, %u frames, %u hardware threads\n\n%8s", options.objects, options.frames, hardwareThreads, "threads");
+	for (const char *name : stageNames)
+		std::printf(" %12s", name);
+	std::printf(" %12s %8s %10s\n", "total ms", "speedup", "visible");
+
+	double baseline = 0.0;
+	size_t baselineVisible = 0;
+	for (unsigned int threadCount : threadCounts) {
+		RunResult result = run(scene, threadCount, options);
+		double total = 0.0;
+		std::printf("%8u", threadCount);
+		for (double ms : result.stageMs) {
+			std::printf(" %12.3f", ms);
+			total += ms;
+		}
+		if (threadCount == 1) {
+			baseline = total;
+			baselineVisible = result.visible;
+		}
+		std::printf(" %12.3f %7.2fx %10zu\n", total, baseline / total, result.visible);
+		if (result.visible != baselineVisible)
+			std::printf("Mismatch: %zu visible with %u threads, %zu with 1\n", result.visible, threadCount, baselineVisible);
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (std::strcmp(arg, "--objects") == 0 && value) {
+			options.objects = std::max<size_t>(1, std::strtoull(value, nullptr, 10));
+			i++;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value) {
+			options.frames = std::max(1, std::atoi(value));
+			i++;
+		}
+		else {
+			std::fprintf(stderr, "Usage: %s [--objects N] [--frames N]\n", argv[0]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+Scene generateScene(size_t count) {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> coordinate(-SCENE_HALF_SIZE, SCENE_HALF_SIZE);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	Scene scene;
+	scene.positions.resize(count);
+	scene.axes.resize(count);
+	scene.angularSpeeds.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		scene.positions[i] = glm::vec3(coordinate(random), coordinate(random) * 0.2f, coordinate(random));
+		scene.axes[i] = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(0.1f));
+		scene.angularSpeeds[i] = 0.01f + 0.05f * unit(random);
+	}
+
+	return scene;
+}
+
+RunResult run(const Scene &scene, unsigned int threadCount, const Options &options) {
+	JobSystem jobs(threadCount);
+	size_t count = scene.positions.size();
+	size_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	std::vector<glm::mat4> models(count);
+	std::vector<unsigned char> visible(count);
+	std::vector<size_t> chunkOffsets(chunkCount + 1);
+	RenderQueue queue;
+
+	RunResult result = {};
+	for (unsigned int frame = 0; frame < options.frames; frame++) {
+		Stopwatch transformTime;
+		jobs.parallelFor(0, count, 4096, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), scene.positions[i]);
+				models[i] = glm::rotate(model, scene.angularSpeeds[i] * frame, scene.axes[i]);
+			}
+		});
+		result.stageMs[STAGE_TRANSFORMS] += transformTime.elapsedMs();
+
+		// Camera circles the scene at low altitude.
+		float angle = 0.02f * frame;
+		Camera camera(glm::vec3(std::cos(angle), 0.1f, std::sin(angle)) * SCENE_HALF_SIZE * 0.5f, glm::degrees(angle) + 90.0f, -5.0f);
+		glm::mat4 view = camera.getViewMatrix();
+		glm::vec4 planes[6];
+		extractFrustumPlanes(glm::perspective(glm::radians(camera.fovY), ASPECT_RATIO, 0.1f, FAR_PLANE) * view, planes);
+
+		Stopwatch cullingTime;
+		jobs.parallelFor(0, chunkCount, 1, [&](size_t firstChunk, size_t lastChunk) {
+			for (size_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+				size_t visibleInChunk = 0;
+				for (size_t i = chunk * CHUNK_SIZE, end = std::min(count, i + CHUNK_SIZE); i < end; i++) {
+					glm::vec3 center(models[i][3]);
+					bool inside = true;
+					for (int p = 0; p < 6 && inside; p++)
+						inside = glm::dot(glm::vec3(planes[p]), center) + planes[p].w >= -CUBE_RADIUS;
+					visible[i] = inside;
+					visibleInChunk += inside;
+				}
+				chunkOffsets[chunk + 1] = visibleInChunk;
+			}
+		});
+		result.stageMs[STAGE_CULLING] += cullingTime.elapsedMs();
+
+		Stopwatch commandTime;
+		// Chunk counts to offsets, then each chunk writes its visible objects from its offset.
+		chunkOffsets[0] = 0;
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+			chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+		size_t visibleCount = chunkOffsets[chunkCount];
+		queue.resize(visibleCount, visibleCount);
+		jobs.parallelFor(0, chunkCount, 1, [&](size_t firstChunk, size_t lastChunk) {
+			for (size_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+				size_t command = chunkOffsets[chunk];
+				for (size_t i = chunk * CHUNK_SIZE, end = std::min(count, i + CHUNK_SIZE); i < end; i++) {
+					if (!visible[i])
+						continue;
+					float depth = -(view * models[i][3]).z / FAR_PLANE;
+					unsigned int transform = static_cast<unsigned int>(command);
+					queue.setTransform(transform, models[i]);
+					queue.setCommand(command, makeSortKey(0, 0, 0, 0, depth), { 36, 0, 0, 1, transform });
+					command++;
+				}
+			}
+		});
+		result.stageMs[STAGE_COMMANDS] += commandTime.elapsedMs();
+		result.visible = visibleCount;
+	}
+
+	for (double &ms : result.stageMs)
+		ms /= options.frames;
+
+	return result;
+}
\ No newline at end of file
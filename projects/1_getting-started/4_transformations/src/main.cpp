@@ -5,7 +5,6 @@
 #include <cstdio>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <stb_image.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -14,6 +13,8 @@
 #endif
 
 #include "shader/shader.hpp"
+#include "texture/texture.hpp"
+#include "sampler/sampler.hpp"
 
 void processInput(GLFWwindow *window);
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
@@ -94,44 +95,19 @@ int main(int argc, char *argv[]) {
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	// Create texture objects.
-	unsigned int textures[TEXTURE_COUNT];
-	glGenTextures(TEXTURE_COUNT, textures);
+	// Create textures. Sampling state lives in a shared sampler object.
+	const SamplerState samplerState = { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT };
+	SamplerCache samplerCache;
+	Texture textures[TEXTURE_COUNT];
 	for (int i = 0; i < TEXTURE_COUNT; i++) {
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		int width, height, numChannels;
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char *data = stbi_load(texturePaths[i], &width, &height, &numChannels, 0);
-		if (data) {
-			switch (numChannels) {
-				case 3:
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-					break;
-				case 4:
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-					break;
-				default:
-				#ifndef NDEBUG
-					DEBUG_OUT << "Unsupported number of texture channels. Index: " << i << std::endl;
-				#endif
-					break;
-			}
-			glGenerateMipmap(GL_TEXTURE_2D);
+		if (textures[i].load(texturePaths[i])) {
+			// Bind texture and sampler to texture unit, assign unit to sampler uniform.
+			textures[i].bind(i);
+			samplerCache.bind(i, samplerState);
 			char uniformName[16];
 			std::snprintf(uniformName, sizeof(uniformName), "textures[%d]", i);
 			myShader.setInt(uniformName, i);
 		}
-		else {
-		#ifndef NDEBUG
-			DEBUG_OUT << "Failed to load texture." << std::endl;
-		#endif
-		}
-		stbi_image_free(data);
 	}
 
 	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -157,7 +133,6 @@ int main(int argc, char *argv[]) {
 	// Cleanup.
 	glDeleteBuffers(1, &VBO);
 	glDeleteVertexArrays(1, &VAO);
-	glDeleteTextures(2, textures);
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
@@ -0,0 +1,32 @@
+#version 330 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vTexCoord;
+
+out vec2 fTexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+// Per draw data: model matrix columns, position scale, position origin, texture coord scale (xy) and origin (zw).
+uniform samplerBuffer drawData;
+// First texel of the current frame's region in the stream buffer.
+uniform int drawDataOffset;
+// Index of the current draw, set per draw call without gl_DrawID.
+uniform int drawID;
+
+void main() {
+    int base = drawDataOffset + drawID * 7;
+    mat4 model = mat4(
+        texelFetch(drawData, base),
+        texelFetch(drawData, base + 1),
+        texelFetch(drawData, base + 2),
+        texelFetch(drawData, base + 3)
+    );
+    vec3 positionScale = texelFetch(drawData, base + 4).xyz;
+    vec3 positionOrigin = texelFetch(drawData, base + 5).xyz;
+    vec4 texCoordTransform = texelFetch(drawData, base + 6);
+
+    // Matrix multiplication is performed right to left.
+    gl_Position = projection * view * model * vec4(vPos * positionScale + positionOrigin, 1.0);
+    fTexCoord = vTexCoord * texCoordTransform.xy + texCoordTransform.zw;
+}
\ No newline at end of file
@@ -5,7 +5,6 @@
 #include <cstdio>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <stb_image.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #ifndef NDEBUG
@@ -13,12 +12,18 @@
 #endif
 
 #include "shader/shader.hpp"
+#include "texture/texture.hpp"
+#include "sampler/sampler.hpp"
+#include "mesh/mesh.hpp"
+#include "mesh/meshoptimizer.hpp"
+#include "vertex/vertexformat.hpp"
+#include "batch/batchrenderer.hpp"
 
 void processInput(GLFWwindow *window);
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
 const unsigned int WINDOW_WIDTH = 800, WINDOW_HEIGHT = 600;
-const unsigned int TEXTURE_COUNT = 2, CUBE_COUNT = 10;
+const unsigned int TEXTURE_COUNT = 2, CUBE_COUNT = 10, CUBE_VERTEX_COUNT = 36;
 
 const char *texturePaths[TEXTURE_COUNT] = {
 	"resources/textures/container.jpg",
@@ -121,104 +126,95 @@ int main(int argc, char *argv[]) {
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
-	// Create and use shader program.
-	Shader myShader("resources/shaders/myShader.vert", "resources/shaders/myShader.frag");
-	myShader.useProgram();
-
-	// Generate buffers and set vertex attributes.
-	unsigned int VAO, VBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(0));
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	// Unbind buffers.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	// Create textures.
-	unsigned int textures[TEXTURE_COUNT];
-	glGenTextures(TEXTURE_COUNT, textures);
-	for (int i = 0; i < TEXTURE_COUNT; i++) {
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		int width, height, numChannels;
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char *data = stbi_load(texturePaths[i], &width, &height, &numChannels, 0);
-		if (data) {
-			switch (numChannels) {
-				case 3:
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-					break;
-				case 4:
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-					break;
-				default:
-				#ifndef NDEBUG
-					DEBUG_OUT << "Unsupported number of texture channels. Index: " << i << std::endl;
-				#endif
-					break;
+	// GL objects live in this scope so they are destroyed before the context.
+	{
+		// Create batch renderer, per draw data goes to the texture unit after the textures.
+		BatchRenderer batch(TEXTURE_COUNT);
+		// Create and use shader program matching the batch submit path.
+		Shader myShader(
+			batch.multiDrawSupported() ? "resources/shaders/batch.vert" : "resources/shaders/batchFallback.vert",
+			"resources/shaders/myShader.frag"
+		);
+		myShader.useProgram();
+
+		// Weld duplicate cube vertices into an indexed mesh, then optimize for vertex cache and fetch.
+		Mesh cube = buildIndexedMesh(vertexData, CUBE_VERTEX_COUNT, 5);
+		[[maybe_unused]] MeshOptimizationReport report = optimizeMesh(cube);
+#ifndef NDEBUG
+		DEBUG_OUT << "Cube mesh: " << CUBE_VERTEX_COUNT << " -> " << cube.vertexCount() << " vertices"
+			<< ", ACMR " << report.before.acmr << " -> " << report.after.acmr
+			<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+#endif
+		// Quantize to the compact vertex format, 20 -> 12 bytes per vertex.
+		QuantizedMesh compactCube = quantizeMesh(cube, { 0, 3, -1 });
+
+		// Pack the cube into the batch's shared vertex and index buffers.
+		int cubeMesh = batch.addMesh(compactCube);
+		batch.build();
+
+		// Create textures. Sampling state lives in a shared sampler object.
+		const SamplerState samplerState = { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT };
+		SamplerCache samplerCache;
+		Texture textures[TEXTURE_COUNT];
+		for (int i = 0; i < TEXTURE_COUNT; i++) {
+			if (textures[i].load(texturePaths[i])) {
+				// Bind texture and sampler to texture unit, assign unit to sampler uniform.
+				textures[i].bind(i);
+				samplerCache.bind(i, samplerState);
+				char uniformName[16];
+				std::snprintf(uniformName, sizeof(uniformName), "textures[%d]", i);
+				myShader.setInt(uniformName, i);
 			}
-			glGenerateMipmap(GL_TEXTURE_2D);
-			char uniformName[16];
-			std::snprintf(uniformName, sizeof(uniformName), "textures[%d]", i);
-			myShader.setInt(uniformName, i);
 		}
-		else {
+
+		// Initialize coordinate system matrices.
+		glm::mat4 model = glm::mat4(1.0f);
+		glm::mat4 view = glm::mat4(1.0f);
+		glm::mat4 projection = glm::mat4(1.0f);
+		// Translate and set view matrix.
+		view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
+		myShader.setMat4("view", view);
+		// Set projection (perspective) matrix.
+		projection = glm::perspective(
+			glm::radians(45.0f),
+			static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT),
+			0.1f, 100.0f
+		);
+		myShader.setMat4("projection", projection);
+
+#ifndef NDEBUG
+		bool batchReported = false;
+#endif
+
+		// Render loop.
+		while (!glfwWindowShouldClose(window)) {
+			processInput(window);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// Record cubes and render them in one batch.
+			batch.begin(CUBE_COUNT);
+			for (int i = 0; i < CUBE_COUNT; i++) {
+				// Translate and rotate each cube's model matrix.
+				model = glm::mat4(1.0f);
+				model = glm::translate(model, cubePositions[i]);
+				model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+				batch.draw(cubeMesh, model);
+			}
+			batch.submit(myShader);
 		#ifndef NDEBUG
-			DEBUG_OUT << "Failed to load texture." << std::endl;
+			if (!batchReported) {
+				DEBUG_OUT << "Batch: " << batch.stats.drawsSubmitted << " draw calls submitted for "
+					<< batch.stats.drawsRecorded << " draws" << std::endl;
+				batchReported = true;
+			}
 		#endif
-		}
-		stbi_image_free(data);
-	}
 
-	// Initialize coordinate system matrices.
-	glm::mat4 model = glm::mat4(1.0f);
-	glm::mat4 view = glm::mat4(1.0f);
-	glm::mat4 projection = glm::mat4(1.0f);
-	// Translate and set view matrix.
-	view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
-	myShader.setMat4("view", view);
-	// Set projection (perspective) matrix.
-	projection = glm::perspective(
-		glm::radians(45.0f),
-		static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT),
-		0.1f, 100.0f
-	);
-	myShader.setMat4("projection", projection);
-
-	// Render loop.
-	while (!glfwWindowShouldClose(window)) {
-		processInput(window);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Render cubes.
-		glBindVertexArray(VAO);
-		for (int i = 0; i < CUBE_COUNT; i++) {
-			// Translate and rotate each cube's model matrix.
-			model = glm::mat4(1.0f);
-			model = glm::translate(model, cubePositions[i]);
-			model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
-			myShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			glfwSwapBuffers(window);
+			glfwPollEvents();
 		}
-
-		glfwSwapBuffers(window);
-		glfwPollEvents();
 	}
 
 	// Cleanup.
-	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteTextures(2, textures);
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
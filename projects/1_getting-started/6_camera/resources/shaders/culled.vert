@@ -0,0 +1,24 @@
+#version 430 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vTexCoord;
+layout (location = 7) in uint iInstance; // Visible instance index, per instance.
+
+out vec2 fTexCoord;
+
+// Model matrices of all instances, indexed by the culling output.
+layout (std430, binding = 4) readonly buffer Models { mat4 models[]; };
+
+uniform mat4 view;
+uniform mat4 projection;
+// Compact vertex format dequantization.
+uniform vec3 positionScale;
+uniform vec3 positionOrigin;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOrigin;
+
+void main() {
+    // Matrix multiplication is performed right to left.
+    gl_Position = projection * view * models[iInstance] * vec4(vPos * positionScale + positionOrigin, 1.0);
+    fTexCoord = vTexCoord * texCoordScale + texCoordOrigin;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vTexCoord;
+layout (location = 3) in mat4 iModel; // Per instance, locations 3 - 6.
+
+out vec2 fTexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+// Compact vertex format dequantization.
+uniform vec3 positionScale;
+uniform vec3 positionOrigin;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOrigin;
+
+void main() {
+    // Matrix multiplication is performed right to left.
+    gl_Position = projection * view * iModel * vec4(vPos * positionScale + positionOrigin, 1.0);
+    fTexCoord = vTexCoord * texCoordScale + texCoordOrigin;
+}
\ No newline at end of file
@@ -8,9 +8,14 @@ out vec2 fTexCoord;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// Compact vertex format dequantization.
+uniform vec3 positionScale;
+uniform vec3 positionOrigin;
+uniform vec2 texCoordScale;
+uniform vec2 texCoordOrigin;
 
 void main() {
     // Matrix multiplication is performed right to left.
-    gl_Position = projection * view * model * vec4(vPos, 1.0);
-    fTexCoord = vTexCoord;
+    gl_Position = projection * view * model * vec4(vPos * positionScale + positionOrigin, 1.0);
+    fTexCoord = vTexCoord * texCoordScale + texCoordOrigin;
 }
\ No newline at end of file
@@ -2,26 +2,66 @@
 * LearnOpenGL Tutorial - Getting Started > Camera
 * https://learnopengl.com/Getting-started/Camera
 */
+#include <atomic>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <vector>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <stb_image.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <stb_image_write.h>
 #ifndef NDEBUG
 #include <debugout.hpp>
 #endif
 
 #include "shader/shader.hpp"
+#include "texture/texture.hpp"
+#include "sampler/sampler.hpp"
+#include "mesh/mesh.hpp"
+#include "mesh/meshoptimizer.hpp"
+#include "vertex/vertexformat.hpp"
+#include "batch/batchrenderer.hpp"
+#include "culling/gpuculler.hpp"
+#include "spatial/aabb.hpp"
+#include "spatial/bvh.hpp"
+#include "render/renderqueue.hpp"
+#include "render/renderbackend.hpp"
+#include "render/glstatecache.hpp"
+#include "thread/triplebuffer.hpp"
+#include "thread/jobsystem.hpp"
+#include "transform/transformarray.hpp"
+#include "memory/framearena.hpp"
+#include "context/headlesscontext.hpp"
+#include "capture/framecapture.hpp"
+#include "profile/profiler.hpp"
 #include "camera/camera.hpp"
+#include "timing/framepacer.hpp"
+#include "benchmark/benchmark.hpp"
 
 void processInput(GLFWwindow *window);
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow *window, double xPosIn, double yPosIn);
 void scroll_callback(GLFWwindow *window, double xOffset, double yOffset);
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+std::vector<glm::mat4> buildCubeModels(unsigned int cubeCount, JobSystem &jobs);
+glm::vec3 cubePosition(unsigned int i, unsigned int side);
+bool writePng(const char *path, const std::vector<unsigned char> &pixels, int width, int height);
 
 const unsigned int WINDOW_WIDTH = 800, WINDOW_HEIGHT = 600;
-const unsigned int TEXTURE_COUNT = 2, CUBE_COUNT = 10;
+const unsigned int TEXTURE_COUNT = 2, CUBE_COUNT = 10, CUBE_VERTEX_COUNT = 36;
+const unsigned int MAX_CUBE_COUNT = 1000000;
+const unsigned int INSTANCE_MODEL_LOCATION = 3; // Locations 3 - 6, after the compact vertex attributes.
+const unsigned int CULLED_INSTANCE_LOCATION = 7, MODEL_STORAGE_BINDING = 4;
+const float STRESS_SPACING = 2.0f, STRESS_DEPTH = 20.0f;
+const size_t FRAME_ARENA_CAPACITY = 1 << 20; // Grows to the largest frame seen.
+const unsigned int HEADLESS_FRAME_COUNT = 100; // Headless runs without --frames.
 
 const char *texturePaths[TEXTURE_COUNT] = {
 	"resources/textures/container.jpg",
@@ -89,8 +129,7 @@ const glm::vec3 cubePositions[CUBE_COUNT] = {
 };
 
 // Timing.
-float deltaTime = 0.0f; // Time between current frame and last frame.
-float lastFrame = 0.0f;
+float deltaTime = 0.0f; // Smoothed time between frames, so one slow frame does not jerk the camera.
 
 // Input variables.
 float lastX = WINDOW_WIDTH / 2, lastY = WINDOW_HEIGHT / 2;
@@ -99,148 +138,594 @@ bool firstMouse = true;
 // Camera.
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 
+// Render mode, cycled with I.
+enum RenderMode { RENDER_BATCHED, RENDER_INSTANCED, RENDER_PER_DRAW, RENDER_GPU_CULLED, RENDER_MODE_COUNT };
+const char *renderModeNames[RENDER_MODE_COUNT] = { "batched", "instanced", "per-draw", "gpu-culled" };
+RenderMode renderMode = RENDER_BATCHED;
+
+// Picking, a click selects the cube under the crosshair.
+bool pickRequested = false;
+int pickedCube = -1;
+
+// Framebuffer size, recorded by the resize callback and applied by the render thread.
+int framebufferWidth = WINDOW_WIDTH, framebufferHeight = WINDOW_HEIGHT;
+
+// Everything the render thread needs for one frame. Written by the simulation thread, read only once published.
+struct FramePacket {
+	RenderMode renderMode;
+	int framebufferWidth;
+	int framebufferHeight;
+	glm::mat4 projection;
+	glm::mat4 view;
+	// Batched path, from the BVH frustum query. Lives in the frame arena, which keeps it until the
+	// simulation is two frames further, and the render thread is never more than one behind.
+	const std::pmr::vector<unsigned int> *visibleCubes;
+	RenderQueue renderQueue; // Per-draw path, already sorted. Reuses its capacity, so it stays off the heap too.
+};
+
 int main(int argc, char *argv[]) {
-	// Initialize GLFW.
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	// Stress mode arguments: --cubes <10 - 1000000> scales the cube field,
+	// --instanced, --per-draw and --gpu-culled start in another render path instead of the batch.
+	// Pacing arguments: --vsync (default), --adaptive or --uncapped pick the swap interval,
+	// --fps <N> limits the frame rate on the CPU, which saves power when uncapped.
+	// Headless arguments: --headless renders offscreen through EGL, for machines without a display,
+	// --frames <N> exits after N frames, --output <path> saves the last headless frame as a PNG.
+	// --profile <path> records CPU and GPU scopes and writes them as a Chrome trace on exit.
+	// --capture <pattern> saves every frame in the background, such as capture/frame_%05u.png, raw RGBA if it ends in .raw.
+	unsigned int cubeCount = CUBE_COUNT;
+	SwapMode swapMode = SWAP_VSYNC;
+	double targetFrameRate = 0.0;
+	bool headless = false;
+	unsigned int frameLimit = 0; // 0 runs until the window is closed.
+	const char *outputPath = nullptr;
+	const char *profilePath = nullptr;
+	const char *capturePattern = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--cubes") == 0 && i + 1 < argc) {
+			unsigned long value = std::strtoul(argv[++i], nullptr, 10);
+			cubeCount = static_cast<unsigned int>(value < CUBE_COUNT ? CUBE_COUNT : value > MAX_CUBE_COUNT ? MAX_CUBE_COUNT : value);
+		}
+		else if (std::strcmp(argv[i], "--instanced") == 0)
+			renderMode = RENDER_INSTANCED;
+		else if (std::strcmp(argv[i], "--per-draw") == 0)
+			renderMode = RENDER_PER_DRAW;
+		else if (std::strcmp(argv[i], "--gpu-culled") == 0)
+			renderMode = RENDER_GPU_CULLED;
+		else if (std::strcmp(argv[i], "--vsync") == 0)
+			swapMode = SWAP_VSYNC;
+		else if (std::strcmp(argv[i], "--adaptive") == 0)
+			swapMode = SWAP_ADAPTIVE;
+		else if (std::strcmp(argv[i], "--uncapped") == 0)
+			swapMode = SWAP_UNCAPPED;
+		else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+			targetFrameRate = std::strtod(argv[++i], nullptr);
+		else if (std::strcmp(argv[i], "--headless") == 0)
+			headless = true;
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frameLimit = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+		else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+			outputPath = argv[++i];
+		else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+			profilePath = argv[++i];
+		else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+			capturePattern = argv[++i];
+	}
+	if (capturePattern && !FrameCapture::validPathFormat(capturePattern)) {
+		std::fprintf(stderr, "--capture needs one %%u for the frame number, such as capture/frame_%%05u.png\n");
+
+		return -1;
+	}
+	// Enabled before any loading, so shader compiles and texture loads are in the trace.
+	Profiler::setEnabled(profilePath != nullptr);
+	Profiler::setThreadName("simulation");
+
+	GLFWwindow *window = NULL;
+	std::unique_ptr<HeadlessContext> headlessContext;
+	if (headless) {
+		// Offscreen context, it loads glad itself.
+		headlessContext = std::make_unique<HeadlessContext>(WINDOW_WIDTH, WINDOW_HEIGHT);
+		if (!headlessContext->valid()) {
+		#ifndef NDEBUG
+			DEBUG_OUT << "Failed to create headless context." << std::endl;
+		#endif
+
+			return -1;
+		}
+		if (frameLimit == 0)
+			frameLimit = HEADLESS_FRAME_COUNT;
+	}
+	else {
+		// Initialize GLFW.
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-	// Create GLFW window.
-	GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "LearnOpenGL", NULL, NULL);
-	if (window == NULL) {
-	#ifndef NDEBUG
-		DEBUG_OUT << "Failed to create GLFW window." << std::endl;
-	#endif
-		glfwTerminate();
+		// Create GLFW window.
+		window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "LearnOpenGL", NULL, NULL);
+		if (window == NULL) {
+		#ifndef NDEBUG
+			DEBUG_OUT << "Failed to create GLFW window." << std::endl;
+		#endif
+			glfwTerminate();
 
-		return -1;
-	}
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Disable cursor and capture it.
-
-	// Initialize glad.
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-	#ifndef NDEBUG
-		DEBUG_OUT << "Failed to initialize GLAD." << std::endl;
-	#endif
+			return -1;
+		}
+		glfwMakeContextCurrent(window);
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSetCursorPosCallback(window, mouse_callback);
+		glfwSetScrollCallback(window, scroll_callback);
+		glfwSetKeyCallback(window, key_callback);
+		glfwSetMouseButtonCallback(window, mouse_button_callback);
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Disable cursor and capture it.
+
+		// Initialize glad.
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		#ifndef NDEBUG
+			DEBUG_OUT << "Failed to initialize GLAD." << std::endl;
+		#endif
 
-		return -1;
+			return -1;
+		}
 	}
 
 	// Configure OpenGL.
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 
-	// Create and use shader program.
-	Shader myShader("resources/shaders/myShader.vert", "resources/shaders/myShader.frag");
-	myShader.useProgram();
-
-	// Generate buffers and set vertex attributes.
-	unsigned int VAO, VBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(0));
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	// Unbind buffers.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	// Create textures.
-	unsigned int textures[TEXTURE_COUNT];
-	glGenTextures(TEXTURE_COUNT, textures);
-	for (int i = 0; i < TEXTURE_COUNT; i++) {
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, textures[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		int width, height, numChannels;
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char *data = stbi_load(texturePaths[i], &width, &height, &numChannels, 0);
-		if (data) {
-			switch (numChannels) {
-				case 3:
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-					break;
-				case 4:
-					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-					break;
-				default:
-				#ifndef NDEBUG
-					DEBUG_OUT << "Unsupported number of texture channels. Index: " << i << std::endl;
-				#endif
-					break;
+	int exitCode = 0;
+	// GL objects live in this scope so they are destroyed before the context.
+	{
+		// Create batch renderer, per draw data goes to the texture unit after the textures.
+		BatchRenderer batch(TEXTURE_COUNT);
+		// GPU culling needs GL 4.3, its depth pyramid goes to the next texture unit.
+		GpuCuller culler("resources/shaders/cull.comp", "resources/shaders/depthReduce.comp", TEXTURE_COUNT + 1);
+		if (headlessContext)
+			culler.setOutputFramebuffer(headlessContext->framebuffer());
+		if (renderMode == RENDER_GPU_CULLED && !GpuCuller::supported())
+			renderMode = RENDER_BATCHED;
+
+		// Create shader programs for the per-draw loop, the instanced path and the batch.
+		Shader myShader("resources/shaders/myShader.vert", "resources/shaders/myShader.frag");
+		Shader instancedShader("resources/shaders/instanced.vert", "resources/shaders/myShader.frag");
+		Shader batchShader(
+			batch.multiDrawSupported() ? "resources/shaders/batch.vert" : "resources/shaders/batchFallback.vert",
+			"resources/shaders/myShader.frag"
+		);
+		Shader culledShader;
+		if (GpuCuller::supported())
+			culledShader.compileProgram("resources/shaders/culled.vert", "resources/shaders/myShader.frag");
+		Shader *shaders[RENDER_MODE_COUNT] = { &batchShader, &instancedShader, &myShader, &culledShader };
+
+		// Weld duplicate cube vertices into an indexed mesh, then optimize for vertex cache and fetch.
+		Mesh cube = buildIndexedMesh(vertexData, CUBE_VERTEX_COUNT, 5);
+		[[maybe_unused]] MeshOptimizationReport report = optimizeMesh(cube);
+#ifndef NDEBUG
+		DEBUG_OUT << "Cube mesh: " << CUBE_VERTEX_COUNT << " -> " << cube.vertexCount() << " vertices"
+			<< ", ACMR " << report.before.acmr << " -> " << report.after.acmr
+			<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+#endif
+		// Quantize to the compact vertex format, 20 -> 12 bytes per vertex.
+		QuantizedMesh compactCube = quantizeMesh(cube, { 0, 3, -1 });
+
+		// Pack the cube into the batch's shared vertex and index buffers.
+		int cubeMesh = batch.addMesh(compactCube);
+		batch.build();
+
+		// Per-object work of the simulation thread is spread over every core.
+		JobSystem jobs;
+
+		// Model matrices are static, build them once for all render paths.
+		std::vector<glm::mat4> cubeModels = buildCubeModels(cubeCount, jobs);
+		// World bounds of every cube in a BVH, the batched path draws only what the frustum query returns.
+		const Aabb cubeBox = { compactCube.positionOrigin - compactCube.positionScale, compactCube.positionOrigin + compactCube.positionScale };
+		std::vector<Aabb> cubeBounds(cubeCount);
+		for (unsigned int i = 0; i < cubeCount; i++)
+			cubeBounds[i] = transformAabb(cubeBox, cubeModels[i]);
+		Bvh cubeBvh;
+		cubeBvh.build(cubeBounds);
+
+		// Generate buffers and set vertex attributes.
+		unsigned int VAO, VBO, EBO, instanceVBO;
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		glGenBuffers(1, &instanceVBO);
+		glBindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, compactCube.vertices.size(), compactCube.vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, compactCube.indices.size() * sizeof(unsigned int), compactCube.indices.data(), GL_STATIC_DRAW);
+		setVertexAttributes(compactCube);
+		// Per instance model matrices, ignored by the per-draw shader.
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, cubeModels.size() * sizeof(glm::mat4), cubeModels.data(), GL_STATIC_DRAW);
+		setInstanceMatrixAttribute(INSTANCE_MODEL_LOCATION);
+		// Unbind buffers. The element buffer binding stays recorded in the VAO.
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+
+		// GPU culled path: bounding spheres per cube, the vertex shader reads model matrices from the instance buffer
+		// through a storage buffer, indexed by the visible instance attribute.
+		unsigned int culledVAO = 0;
+		if (GpuCuller::supported()) {
+			std::vector<glm::vec4> cubeBounds(cubeCount);
+			std::vector<unsigned int> cubeMeshIds(cubeCount, 0);
+			for (unsigned int i = 0; i < cubeCount; i++) {
+				// Cube models are rigid, the radius is the same in world space.
+				glm::vec4 center = cubeModels[i] * glm::vec4(compactCube.positionOrigin, 1.0f);
+				cubeBounds[i] = glm::vec4(center.x, center.y, center.z, glm::length(compactCube.positionScale));
 			}
-			glGenerateMipmap(GL_TEXTURE_2D);
-			char uniformName[16];
-			std::snprintf(uniformName, sizeof(uniformName), "textures[%d]", i);
-			myShader.setInt(uniformName, i);
+			culler.setInstances(cubeBounds, cubeMeshIds, { { static_cast<unsigned int>(compactCube.indices.size()), 0, 0, 0, 0 } });
+
+			glGenVertexArrays(1, &culledVAO);
+			glBindVertexArray(culledVAO);
+			glBindBuffer(GL_ARRAY_BUFFER, VBO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+			setVertexAttributes(compactCube);
+			culler.setVisibleInstanceAttribute(CULLED_INSTANCE_LOCATION);
+			glBindVertexArray(0);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_STORAGE_BINDING, instanceVBO);
 		}
-		else {
-		#ifndef NDEBUG
-			DEBUG_OUT << "Failed to load texture." << std::endl;
-		#endif
+
+		// Create textures. Sampling state lives in a shared sampler object.
+		const SamplerState samplerState = { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_REPEAT, GL_REPEAT };
+		SamplerCache samplerCache;
+		Texture textures[TEXTURE_COUNT];
+		bool textureLoaded[TEXTURE_COUNT] = {};
+		for (int i = 0; i < TEXTURE_COUNT; i++) {
+			if (textures[i].load(texturePaths[i])) {
+				// Bind texture and sampler to texture unit.
+				textures[i].bind(i);
+				samplerCache.bind(i, samplerState);
+				textureLoaded[i] = true;
+			}
+		}
+		// Assign texture units to all programs, dequantization uniforms to the non batched ones.
+		for (Shader *shader : shaders) {
+			if (shader == &culledShader && !GpuCuller::supported())
+				continue;
+			shader->useProgram();
+			for (int i = 0; i < TEXTURE_COUNT; i++) {
+				if (textureLoaded[i]) {
+					char uniformName[16];
+					std::snprintf(uniformName, sizeof(uniformName), "textures[%d]", i);
+					shader->setInt(uniformName, i);
+				}
+			}
+			if (shader != &batchShader)
+				setDequantizationUniforms(*shader, compactCube);
 		}
-		stbi_image_free(data);
-	}
 
-	// Render loop.
-	while (!glfwWindowShouldClose(window)) {
-		// Calculate delta time.
-		float currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-
-		processInput(window);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Update projection matrix.
-		glm::mat4 projection = glm::perspective(
-			glm::radians(camera.fovY),
-			static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT),
-			0.1f, 100.0f
-		);
-		myShader.setMat4("projection", projection);
-		// Update view matrix based on camera state.
-		glm::mat4 view = camera.getViewMatrix();
-		myShader.setMat4("view", view);
+		// Program, vertex array and texture binds in the render loop go through a state cache, which skips the ones
+		// already current. The batch and the culler bind their own state, the cache forgets everything after them.
+		GlStateCache glState;
+
+		// The per-draw path submits through a sort-keyed command queue. Its backend binds each program,
+		// texture set and vertex array once per run of commands sharing them, here that is once per frame
+		// and the depth field orders the cubes front to back. The queue itself travels in the frame packet.
+		RenderBackend renderBackend(glState);
+		std::vector<unsigned int> cubeTextureIds(TEXTURE_COUNT, 0);
+		for (int i = 0; i < TEXTURE_COUNT; i++)
+			cubeTextureIds[i] = textureLoaded[i] ? textures[i].id : 0;
+		const unsigned int opaquePass = renderBackend.addPass({ true, true, false });
+		const unsigned int cubeProgram = renderBackend.addProgram(&myShader);
+		const unsigned int cubeTextureSet = renderBackend.addTextureSet(cubeTextureIds);
+		const unsigned int cubeVertexArray = renderBackend.addVertexArray(VAO);
+
+		// The stress field extends past the default far plane.
+		float farPlane = 100.0f;
+		if (cubeCount > CUBE_COUNT)
+			farPlane += STRESS_DEPTH + std::cbrt(static_cast<float>(cubeCount - CUBE_COUNT)) * STRESS_SPACING;
+
+		// GPU time per frame, measured by the render thread and read a few frames late.
+		GpuTimer gpuTimer;
+		// Frames are read back a few frames late and written by the capture's own thread, at the size the run starts with.
+		std::unique_ptr<FrameCapture> frameCapture;
+		if (capturePattern) {
+			size_t length = std::strlen(capturePattern);
+			bool raw = length >= 4 && std::strcmp(capturePattern + length - 4, ".raw") == 0;
+			frameCapture = std::make_unique<FrameCapture>(framebufferWidth, framebufferHeight, capturePattern,
+				raw ? FrameCapture::FORMAT_RAW : FrameCapture::FORMAT_PNG);
+		}
 
-		// Render cubes.
-		glBindVertexArray(VAO);
-		for (int i = 0; i < CUBE_COUNT; i++) {
-			// Translate and rotate each cube's model matrix.
-			glm::mat4 model = glm::mat4(1.0f);
-			model = glm::translate(model, cubePositions[i]);
-			model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
-			myShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+		// Threads meet only at the frame packet triple buffer and the frame counters below. The simulation
+		// thread stays at most one frame ahead, so one frame is built while the previous one is drawn.
+		TripleBuffer<FramePacket> framePackets;
+		std::atomic<unsigned int> publishedFrames(0), renderedFrames(0);
+		std::atomic<unsigned int> lastRenderedFrame(0); // Published frame number, unlike the count above it skips.
+		std::atomic<bool> running(true);
+		// Render thread statistics for the window title.
+		std::atomic<unsigned int> drawsSubmitted(0), bindsSkipped(0);
+		std::atomic<double> renderTimeSum(0.0), gpuFrameMs(0.0);
+
+		// The render thread owns the GL context until the simulation loop ends.
+		auto makeContextCurrent = [&](bool current) {
+			if (headlessContext) {
+				if (current)
+					headlessContext->makeCurrent();
+				else
+					headlessContext->releaseCurrent();
+			}
+			else
+				glfwMakeContextCurrent(current ? window : NULL);
+		};
+		makeContextCurrent(false);
+		std::thread renderThread([&]() {
+			makeContextCurrent(true);
+			Profiler::setThreadName("render");
+			// The swap interval belongs to the context, so it is set where the context is current.
+			if (window)
+				applySwapMode(swapMode);
+			unsigned int framesSeen = 0;
+			while (true) {
+				unsigned int published;
+				while ((published = publishedFrames.load(std::memory_order_acquire)) == framesSeen)
+					publishedFrames.wait(published);
+				if (!running.load(std::memory_order_acquire))
+					break;
+				framesSeen = published;
+				framePackets.acquire();
+				const FramePacket &packet = framePackets.readSlot();
+				ProfileScope frameScope("render frame");
+				Stopwatch renderTimer;
+				glState.resetStats();
+				gpuTimer.beginFrame();
+				// The frame scope is begun first, so it leads the results.
+				if (!gpuTimer.frameResults().empty())
+					gpuFrameMs.store(gpuTimer.frameResults()[0].ms, std::memory_order_relaxed);
+				gpuTimer.begin("frame");
+
+				// Cull on the GPU before clearing, the culled path renders into the culler's framebuffer.
+				if (packet.renderMode == RENDER_GPU_CULLED) {
+					gpuTimer.begin("GPU cull");
+					culler.resize(packet.framebufferWidth, packet.framebufferHeight);
+					culler.beginFrame(packet.projection * packet.view);
+					glState.invalidate();
+					gpuTimer.end();
+				}
+				glState.setViewport(0, 0, packet.framebufferWidth, packet.framebufferHeight);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				Shader &shader = *shaders[packet.renderMode];
+				glState.useProgram(shader.getProgram());
+				shader.setMat4("projection", packet.projection);
+				shader.setMat4("view", packet.view);
+
+				// Render cubes.
+				gpuTimer.begin("draw cubes");
+				unsigned int draws = 1;
+				if (packet.renderMode == RENDER_BATCHED) {
+					// One indirect command per visible cube, submitted as a single multi-draw.
+					batch.begin(static_cast<unsigned int>(packet.visibleCubes->size()));
+					for (unsigned int i : *packet.visibleCubes)
+						batch.draw(cubeMesh, cubeModels[i]);
+					batch.submit(shader);
+					glState.invalidate();
+					draws = batch.stats.drawsSubmitted;
+				}
+				else if (packet.renderMode == RENDER_INSTANCED) {
+					// Whole field in one draw, model matrices come from the instance buffer.
+					glState.bindVertexArray(VAO);
+					glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(compactCube.indices.size()), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(cubeCount));
+				}
+				else if (packet.renderMode == RENDER_GPU_CULLED) {
+					// Instance count was written by the cull pass, the CPU never sees it.
+					glState.bindVertexArray(culledVAO);
+					culler.draw();
+					glState.bindVertexArray(0);
+					culler.endFrame();
+					glState.invalidate();
+				}
+				else {
+					// The queue was built and sorted by the simulation thread.
+					renderBackend.execute(packet.renderQueue);
+					draws = renderBackend.stats.draws;
+				}
+				gpuTimer.end();
+				gpuTimer.end();
+
+				if (frameCapture) {
+					PROFILE_SCOPE("frame capture");
+					frameCapture->capture(headlessContext ? headlessContext->framebuffer() : 0, framesSeen);
+					frameCapture->poll();
+				}
+
+#ifndef NDEBUG
+				// Shadow state must match GL, a mismatch means some code bound state without telling the cache.
+				glState.verify();
+#endif
+
+				// CPU time spent on the frame, excluding the swap which waits on vsync.
+				renderTimeSum.fetch_add(renderTimer.elapsedMs(), std::memory_order_relaxed);
+				drawsSubmitted.store(draws, std::memory_order_relaxed);
+				bindsSkipped.store(glState.stats.skipped, std::memory_order_relaxed);
+				{
+					PROFILE_SCOPE("swap buffers");
+					if (headlessContext)
+						headlessContext->swapBuffers();
+					else
+						glfwSwapBuffers(window);
+				}
+				renderedFrames.fetch_add(1, std::memory_order_release);
+				renderedFrames.notify_one();
+				lastRenderedFrame.store(framesSeen, std::memory_order_release);
+				lastRenderedFrame.notify_one();
+			}
+			// Write out the frames still in flight while the context is current here.
+			if (frameCapture)
+				frameCapture->finish();
+			makeContextCurrent(false);
+		});
+
+		// Simulation time, averaged with the render thread's and shown in the window title once per second.
+		Stopwatch simulationTimer;
+		double simulationTimeSum = 0.0;
+		unsigned int simulationFrames = 0, titleRenderedFrames = 0;
+		double lastTitleUpdate = 0.0;
+		// The render thread waits on the simulation, so limiting this loop limits both.
+		FramePacer pacer(targetFrameRate);
+		// Transient per-frame data, so the loop makes no heap allocations once warmed up.
+		FrameArena frameArena(FRAME_ARENA_CAPACITY);
+
+		// Simulation loop. GLFW events and input must stay on the main thread.
+		while ((frameLimit == 0 || publishedFrames.load(std::memory_order_relaxed) < frameLimit) && (headless || !glfwWindowShouldClose(window))) {
+			pacer.beginFrame();
+			ProfileScope frameScope("simulation frame");
+			if (window)
+				glfwPollEvents();
+
+			deltaTime = pacer.smoothedDeltaSeconds();
+			simulationTimer.reset();
+			frameArena.beginFrame();
+
+			if (window)
+				processInput(window);
+
+			FramePacket &packet = framePackets.writeSlot();
+			packet.renderMode = renderMode;
+			packet.framebufferWidth = framebufferWidth;
+			packet.framebufferHeight = framebufferHeight;
+			// Update projection matrix.
+			packet.projection = glm::perspective(
+				glm::radians(camera.fovY),
+				static_cast<float>(WINDOW_WIDTH) / static_cast<float>(WINDOW_HEIGHT),
+				0.1f, farPlane
+			);
+			// Update view matrix based on camera state.
+			packet.view = camera.getViewMatrix();
+
+			// Pick along the view direction, the cursor is captured at the center of the window.
+			if (pickRequested) {
+				BvhRayHit hit;
+				pickedCube = cubeBvh.raycast(camera.position, camera.zAxis, farPlane, hit) ? static_cast<int>(hit.object) : -1;
+				pickRequested = false;
+			}
+
+			packet.visibleCubes = nullptr;
+			if (renderMode == RENDER_BATCHED) {
+				PROFILE_SCOPE("BVH frustum query");
+				// The batch draws only what the frustum query returns. Reserving every cube keeps the list in one block.
+				std::pmr::vector<unsigned int> *visibleCubes = frameArena.current().create<std::pmr::vector<unsigned int>>(frameArena.resource());
+				visibleCubes->reserve(cubeCount);
+				cubeBvh.queryFrustum(packet.projection * packet.view, *visibleCubes);
+				packet.visibleCubes = visibleCubes;
+			}
+			else if (renderMode == RENDER_PER_DRAW) {
+				PROFILE_SCOPE("build render queue");
+				// One command per cube, keyed by view depth. Each job fills its own range of the queue.
+				RenderQueue &renderQueue = packet.renderQueue;
+				const glm::mat4 &view = packet.view;
+				renderQueue.resize(cubeCount, cubeCount);
+				jobs.parallelFor(0, cubeCount, 4096, [&](size_t begin, size_t end) {
+					for (size_t i = begin; i < end; i++) {
+						float depth = -(view * cubeModels[i][3]).z / farPlane;
+						DrawCommand command = { static_cast<unsigned int>(compactCube.indices.size()), 0, 0, 1, static_cast<unsigned int>(i) };
+						renderQueue.setTransform(static_cast<unsigned int>(i), cubeModels[i]);
+						renderQueue.setCommand(i, makeSortKey(opaquePass, cubeProgram, cubeTextureSet, cubeVertexArray, depth), command);
+					}
+				});
+				renderQueue.sort();
+			}
+			simulationTimeSum += simulationTimer.elapsedMs();
+			simulationFrames++;
+
+			framePackets.publish();
+			unsigned int frame = publishedFrames.fetch_add(1, std::memory_order_release) + 1;
+			publishedFrames.notify_one();
+			// Wait for the renderer to take the previous frame before building the next one.
+			unsigned int rendered;
+			{
+				PROFILE_SCOPE("wait for render thread");
+				while ((rendered = renderedFrames.load(std::memory_order_acquire)) + 1 < frame)
+					renderedFrames.wait(rendered);
+			}
+
+			double currentTime = pacer.elapsedSeconds();
+			if (window && currentTime - lastTitleUpdate >= 1.0) {
+				unsigned int renderFrames = rendered - titleRenderedFrames;
+				double renderMs = renderTimeSum.exchange(0.0, std::memory_order_relaxed) / (renderFrames ? renderFrames : 1);
+				char title[256];
+				int length = std::snprintf(title, sizeof(title),
+					"LearnOpenGL - %u cubes, %s, %u draw calls, %u redundant binds skipped, CPU sim %.3f ms, render %.3f ms, GPU %.3f ms/frame, %.1f fps",
+					cubeCount, renderModeNames[renderMode], drawsSubmitted.load(std::memory_order_relaxed), bindsSkipped.load(std::memory_order_relaxed),
+					simulationTimeSum / simulationFrames, renderMs, gpuFrameMs.load(std::memory_order_relaxed), simulationFrames / (currentTime - lastTitleUpdate));
+				if (pickedCube >= 0)
+					std::snprintf(title + length, sizeof(title) - length, ", picked cube %d", pickedCube);
+				glfwSetWindowTitle(window, title);
+				simulationTimeSum = 0.0;
+				simulationFrames = 0;
+				titleRenderedFrames = rendered;
+				lastTitleUpdate = currentTime;
+			}
+
+			if (profilePath)
+				Profiler::collect();
+			PROFILE_SCOPE("frame limiter");
+			pacer.waitForNextFrame();
 		}
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
-	}
+		// Let the render thread finish the last frame, it is the one measured and saved.
+		unsigned int lastPublished = publishedFrames.load(std::memory_order_relaxed), lastRendered;
+		while ((lastRendered = lastRenderedFrame.load(std::memory_order_acquire)) < lastPublished)
+			lastRenderedFrame.wait(lastRendered);
+		// Stop the render thread and take the context back for cleanup. The counter bump wakes it.
+		running.store(false, std::memory_order_release);
+		publishedFrames.fetch_add(1, std::memory_order_release);
+		publishedFrames.notify_one();
+		renderThread.join();
+		makeContextCurrent(true);
+
+		if (profilePath) {
+			Profiler::collect();
+			if (!Profiler::writeChromeTrace(profilePath)) {
+				std::fprintf(stderr, "Failed to write %s\n", profilePath);
+				exitCode = 1;
+			}
+		}
+		if (frameCapture) {
+			FrameCapture::Stats captureStats = frameCapture->stats();
+			std::printf("Captured %u frames, %u written, %u skipped, %u failed\n",
+				captureStats.captured, captureStats.written, captureStats.skipped, captureStats.failed);
+			if (captureStats.failed)
+				exitCode = 1;
+			frameCapture.reset();
+		}
+		if (headlessContext) {
+			// No title to show statistics in, they cover the whole run instead.
+			unsigned int renderFrames = renderedFrames.load(std::memory_order_relaxed);
+			std::printf("%u cubes, %s, %u frames, %u draw calls, CPU sim %.3f ms, render %.3f ms, last GPU %.3f ms/frame\n",
+				cubeCount, renderModeNames[renderMode], lastPublished, drawsSubmitted.load(std::memory_order_relaxed),
+				simulationTimeSum / (simulationFrames ? simulationFrames : 1), renderTimeSum.load(std::memory_order_relaxed) / (renderFrames ? renderFrames : 1),
+				gpuFrameMs.load(std::memory_order_relaxed));
+			if (outputPath) {
+				std::vector<unsigned char> pixels;
+				headlessContext->readPixels(pixels);
+				// Scripts check the exit code, so this is reported in release builds too.
+				if (!writePng(outputPath, pixels, headlessContext->width(), headlessContext->height())) {
+					std::fprintf(stderr, "Failed to write %s\n", outputPath);
+					exitCode = 1;
+				}
+			}
+		}
 
-	// Cleanup.
-	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteTextures(2, textures);
-	glfwDestroyWindow(window);
-	glfwTerminate();
+		// Cleanup.
+		glDeleteVertexArrays(1, &culledVAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		glDeleteBuffers(1, &instanceVBO);
+		glDeleteVertexArrays(1, &VAO);
+	}
+	if (window) {
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
 
-	return 0;
+	return exitCode;
 }
 
 // Input handling.
@@ -268,7 +753,9 @@ void processInput(GLFWwindow *window) {
 
 // Callback function for GLFW window resize.
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
-	glViewport(0, 0, width, height);
+	// The GL context lives on the render thread, the viewport follows the next frame packet.
+	framebufferWidth = width;
+	framebufferHeight = height;
 }
 
 // Callback function for mouse movement.
@@ -294,4 +781,66 @@ void mouse_callback(GLFWwindow *window, double xPosIn, double yPosIn) {
 // Callback function for mouse scroll.
 void scroll_callback(GLFWwindow *window, double xOffset, double yOffset) {
 	camera.zoom(static_cast<float>(yOffset));
+}
+
+// Callback function for key presses.
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+	// Cycle between batched, instanced, per-draw and GPU culled rendering.
+	if (key == GLFW_KEY_I && action == GLFW_PRESS) {
+		do
+			renderMode = static_cast<RenderMode>((renderMode + 1) % RENDER_MODE_COUNT);
+		while (renderMode == RENDER_GPU_CULLED && !GpuCuller::supported());
+	}
+}
+
+// Callback function for mouse buttons.
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+	// Picking needs the BVH, the render loop handles the request.
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+		pickRequested = true;
+}
+
+// Model matrices of the cube field. The first CUBE_COUNT cubes keep their positions,
+// stress mode cubes fill a grid behind them. Positions and rotations go into structure of arrays
+// storage, each job composes its range's matrices a SIMD group at a time.
+std::vector<glm::mat4> buildCubeModels(unsigned int cubeCount, JobSystem &jobs) {
+	std::vector<glm::mat4> models(cubeCount);
+	TransformArray transforms;
+	transforms.resize(cubeCount);
+	unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<double>(cubeCount - CUBE_COUNT))));
+	const glm::vec3 rotationAxis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+	jobs.parallelFor(0, cubeCount, 4096, [&](size_t begin, size_t end) {
+		for (unsigned int i = static_cast<unsigned int>(begin); i < end; i++) {
+			transforms.setPosition(i, cubePosition(i, side));
+			transforms.setRotation(i, glm::angleAxis(glm::radians(20.0f * i), rotationAxis));
+		}
+		transforms.composeMatrices(begin, end - begin, &models[begin][0][0]);
+	});
+
+	return models;
+}
+
+glm::vec3 cubePosition(unsigned int i, unsigned int side) {
+	if (i < CUBE_COUNT)
+		return cubePositions[i];
+
+	unsigned int j = i - CUBE_COUNT;
+	return glm::vec3(
+		(static_cast<float>(j % side) - side * 0.5f) * STRESS_SPACING,
+		(static_cast<float>(j / side % side) - side * 0.5f) * STRESS_SPACING,
+		-STRESS_DEPTH - static_cast<float>(j / (side * side)) * STRESS_SPACING
+	);
+}
+
+// RGBA rows top to bottom, streamed straight to the file.
+bool writePng(const char *path, const std::vector<unsigned char> &pixels, int width, int height) {
+	FILE *file = std::fopen(path, "wb");
+	if (!file)
+		return false;
+
+	bool written = stbi_write_png_to_func([](void *context, void *data, int size) {
+		std::fwrite(data, 1, static_cast<size_t>(size), static_cast<FILE *>(context));
+	}, file, width, height, 4, pixels.data(), width * 4) != 0;
+	written = !std::ferror(file) && written;
+	return std::fclose(file) == 0 && written;
 }
\ No newline at end of file
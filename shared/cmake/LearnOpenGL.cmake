@@ -56,6 +56,7 @@ add_library(
 	"${LIBRARY_SOURCE_DIR}/glad/src/glad.c"
 )
 add_library(stb INTERFACE EXCLUDE_FROM_ALL)
+find_package(Threads REQUIRED)
 add_library(excd INTERFACE EXCLUDE_FROM_ALL)
 
 # Include library directories.
@@ -75,8 +76,18 @@ target_link_libraries(
         glad
 		stb
 		excd
+		Threads::Threads
 )
 
+# Headless contexts through EGL where the system provides it, for machines without a display.
+if(UNIX AND NOT APPLE)
+	find_package(OpenGL COMPONENTS EGL)
+	if(OpenGL_EGL_FOUND)
+		target_link_libraries(${EXECUTABLE_NAME} PRIVATE OpenGL::EGL)
+		target_compile_definitions(${EXECUTABLE_NAME} PRIVATE HEADLESS_EGL)
+	endif()
+endif()
+
 # Set C and C++ standard.
 set_target_properties(
 	${EXECUTABLE_NAME}
@@ -87,8 +98,18 @@ set_target_properties(
 		CMAKE_CXX_STANDARD_REQUIRED True
 )
 
-# Use Windows subsystem with main entry.
-if(WIN32)
+# Opt-in AVX code paths, projects set ENABLE_AVX before loading this module. Needs an x86 CPU from 2011 on.
+option(ENABLE_AVX "Compile with AVX instructions" OFF)
+if(ENABLE_AVX AND CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64|i.86")
+	if(MSVC)
+		target_compile_options(${EXECUTABLE_NAME} PRIVATE /arch:AVX)
+	else()
+		target_compile_options(${EXECUTABLE_NAME} PRIVATE -mavx)
+	endif()
+endif()
+
+# Use Windows subsystem with main entry, console tools keep the console subsystem.
+if(WIN32 AND NOT CONSOLE_APPLICATION)
 	set_property(
 		TARGET ${EXECUTABLE_NAME}
 		PROPERTY LINK_FLAGS "/ENTRY:mainCRTStartup /SUBSYSTEM:WINDOWS"
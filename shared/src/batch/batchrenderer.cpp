@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cstdint>
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "batchrenderer.hpp"
+
+namespace {
+	const size_t INITIAL_STREAM_FRAME_SIZE = 64 * 1024;
+	const size_t DRAW_DATA_SIZE = BatchRenderer::DRAW_DATA_TEXELS * sizeof(glm::vec4);
+}
+
+BatchRenderer::BatchRenderer(unsigned int drawDataUnit) : stats{ 0, 0 }, stream(INITIAL_STREAM_FRAME_SIZE),
+	commandAllocation{}, drawDataAllocation{}, drawCount(0), maxDraws(0), drawDataUnit(drawDataUnit), attachedBuffer(0) {
+	layout.stride = 0;
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glGenTextures(1, &drawDataTexture);
+}
+
+BatchRenderer::~BatchRenderer() {
+	glDeleteTextures(1, &drawDataTexture);
+	glDeleteBuffers(1, &EBO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteVertexArrays(1, &VAO);
+}
+
+int BatchRenderer::addMesh(const QuantizedMesh &mesh) {
+	return addMesh(mesh, { { 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f } });
+}
+
+int BatchRenderer::addMesh(const QuantizedMesh &mesh, const std::vector<MeshLod> &lods) {
+	if (meshes.empty()) {
+		layout.stride = mesh.stride;
+		layout.texCoordOffset = mesh.texCoordOffset;
+		layout.normalOffset = mesh.normalOffset;
+	}
+	else if (mesh.stride != layout.stride || mesh.texCoordOffset != layout.texCoordOffset || mesh.normalOffset != layout.normalOffset) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::BATCH_RENDERER::VERTEX_LAYOUT_MISMATCH\n" << "Stride " << mesh.stride << ", expected " << layout.stride << std::endl;
+	#endif
+		return -1;
+	}
+
+	MeshRange range;
+	range.lods = lods;
+	for (MeshLod &lod : range.lods)
+		lod.firstIndex += static_cast<unsigned int>(indices.size());
+	range.firstIndex = static_cast<unsigned int>(indices.size());
+	range.baseVertex = static_cast<int>(vertices.size() / layout.stride);
+	range.positionScale = glm::vec4(mesh.positionScale, 0.0f);
+	range.positionOrigin = glm::vec4(mesh.positionOrigin, 0.0f);
+	range.texCoordTransform = glm::vec4(mesh.texCoordScale, mesh.texCoordOrigin);
+	meshes.push_back(range);
+
+	// Indices stay mesh relative, baseVertex offsets them into the shared vertex buffer.
+	vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+	indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+	return static_cast<int>(meshes.size() - 1);
+}
+
+void BatchRenderer::build() {
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	setVertexAttributes(layout);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BatchRenderer::begin(unsigned int maxDraws) {
+	bool multiDraw = multiDrawSupported();
+	size_t commandSize = multiDraw ? maxDraws * sizeof(DrawElementsIndirectCommand) : 0;
+	size_t drawDataSize = maxDraws * DRAW_DATA_SIZE;
+	stream.reserve(commandSize + drawDataSize + 2 * StreamBuffer::ALIGNMENT);
+	stream.beginFrame();
+	commandAllocation = stream.allocate(commandSize);
+	drawDataAllocation = stream.allocate(drawDataSize);
+	fallbackCommands.clear();
+	drawCount = 0;
+	this->maxDraws = drawDataAllocation.data && (!multiDraw || commandAllocation.data) ? maxDraws : 0;
+}
+
+void BatchRenderer::draw(int mesh, const glm::mat4 &model, unsigned int lod) {
+	if (!validMesh(mesh))
+		return;
+	const MeshRange &range = meshes[mesh];
+	const MeshLod &level = range.lods[std::min(lod, static_cast<unsigned int>(range.lods.size() - 1))];
+	drawRange(mesh, model, level.firstIndex - range.firstIndex, level.indexCount);
+}
+
+void BatchRenderer::drawRange(int mesh, const glm::mat4 &model, unsigned int firstIndex, unsigned int indexCount) {
+	if (!validMesh(mesh))
+		return;
+	if (drawCount >= maxDraws) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::BATCH_RENDERER::TOO_MANY_DRAWS\n" << "Frame was begun with " << maxDraws << " draws" << std::endl;
+	#endif
+		return;
+	}
+
+	// Written once, straight into the mapped stream buffer.
+	const MeshRange &range = meshes[mesh];
+	DrawElementsIndirectCommand command = { indexCount, 1, range.firstIndex + firstIndex, range.baseVertex, 0 };
+	if (commandAllocation.size)
+		static_cast<DrawElementsIndirectCommand *>(commandAllocation.data)[drawCount] = command;
+	else
+		fallbackCommands.push_back(command);
+	glm::vec4 *drawData = static_cast<glm::vec4 *>(drawDataAllocation.data) + drawCount * DRAW_DATA_TEXELS;
+	for (int column = 0; column < 4; column++)
+		drawData[column] = model[column];
+	drawData[4] = range.positionScale;
+	drawData[5] = range.positionOrigin;
+	drawData[6] = range.texCoordTransform;
+	drawCount++;
+}
+
+void BatchRenderer::submit(const Shader &shader) {
+	stats.drawsRecorded = drawCount;
+	stats.drawsSubmitted = 0;
+	if (drawCount == 0) {
+		stream.endFrame();
+		return;
+	}
+
+	stream.finishWrites();
+	glActiveTexture(GL_TEXTURE0 + drawDataUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, drawDataTexture);
+	// The stream buffer object changes when it grows, reattach it to the texture buffer.
+	if (attachedBuffer != stream.id) {
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stream.id);
+		attachedBuffer = stream.id;
+	}
+	shader.setInt("drawData", drawDataUnit);
+	shader.setInt("drawDataOffset", static_cast<int>(drawDataAllocation.offset / sizeof(glm::vec4)));
+
+	glBindVertexArray(VAO);
+	if (multiDrawSupported()) {
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stream.id);
+		glMultiDrawElementsIndirect(
+			GL_TRIANGLES, GL_UNSIGNED_INT,
+			reinterpret_cast<void *>(static_cast<uintptr_t>(commandAllocation.offset)), static_cast<GLsizei>(drawCount), 0
+		);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		stats.drawsSubmitted = 1;
+	}
+	else {
+		for (size_t i = 0; i < fallbackCommands.size(); i++) {
+			const DrawElementsIndirectCommand &command = fallbackCommands[i];
+			shader.setInt("drawID", static_cast<int>(i));
+			glDrawElementsBaseVertex(
+				GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+				reinterpret_cast<void *>(static_cast<uintptr_t>(command.firstIndex) * sizeof(unsigned int)), command.baseVertex
+			);
+		}
+		stats.drawsSubmitted = stats.drawsRecorded;
+	}
+	glBindVertexArray(0);
+	stream.endFrame();
+}
+
+bool BatchRenderer::validMesh(int mesh) const {
+	// Handles of meshes that failed to add are -1.
+	if (mesh < 0 || static_cast<size_t>(mesh) >= meshes.size()) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::BATCH_RENDERER::INVALID_MESH\n" << "Mesh handle " << mesh << ", " << meshes.size() << " meshes" << std::endl;
+	#endif
+		return false;
+	}
+
+	return true;
+}
+
+bool BatchRenderer::multiDrawSupported() const {
+	// gl_DrawID is core in GL 4.6, glMultiDrawElementsIndirect in 4.3.
+	return GLAD_GL_VERSION_4_6;
+}
\ No newline at end of file
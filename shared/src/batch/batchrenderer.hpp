@@ -0,0 +1,86 @@
+#pragma once
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "shader/shader.hpp"
+#include "vertex/vertexformat.hpp"
+#include "mesh/meshlod.hpp"
+#include "stream/streambuffer.hpp"
+
+// Command layout read by glMultiDrawElementsIndirect from GL_DRAW_INDIRECT_BUFFER.
+struct DrawElementsIndirectCommand {
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
+struct BatchStats {
+	unsigned int drawsRecorded; // Draws a per-object loop would have issued.
+	unsigned int drawsSubmitted; // Draw calls actually issued.
+};
+
+// Packs compact meshes into shared vertex and index buffers and draws every recorded object with one
+// glMultiDrawElementsIndirect (GL 4.6), the vertex shader indexes per draw data with gl_DrawID.
+// Without GL 4.6 the same commands are issued one glDrawElementsBaseVertex at a time with a drawID uniform.
+// Per draw data is a texture buffer of DRAW_DATA_TEXELS RGBA32F texels per draw in both paths:
+// model matrix columns, position scale, position origin, texture coord scale (xy) and origin (zw).
+// Commands and per draw data are written straight into a persistently mapped stream buffer,
+// the shader adds the drawDataOffset uniform (in texels) to find the current frame's region.
+class BatchRenderer {
+public:
+	static const unsigned int DRAW_DATA_TEXELS = 7;
+
+	BatchStats stats;
+
+	BatchRenderer(unsigned int drawDataUnit);
+	~BatchRenderer();
+	BatchRenderer(const BatchRenderer &) = delete;
+	BatchRenderer &operator=(const BatchRenderer &) = delete;
+
+	// Append mesh geometry, meshes must share the vertex layout of the first. Returns the mesh handle, -1 on mismatch.
+	int addMesh(const QuantizedMesh &mesh);
+	// Same, with LOD index ranges relative to mesh.indices.
+	int addMesh(const QuantizedMesh &mesh, const std::vector<MeshLod> &lods);
+	// Upload the shared geometry once all meshes are added.
+	void build();
+	// Record up to maxDraws draws for the frame, then submit with the batch shader in use. One batch per frame.
+	void begin(unsigned int maxDraws);
+	void draw(int mesh, const glm::mat4 &model, unsigned int lod = 0);
+	// Draw part of a mesh, firstIndex is relative to the mesh's indices. Used for meshlet ranges.
+	void drawRange(int mesh, const glm::mat4 &model, unsigned int firstIndex, unsigned int indexCount);
+	void submit(const Shader &shader);
+
+	bool multiDrawSupported() const;
+
+private:
+	struct MeshRange {
+		std::vector<MeshLod> lods; // Index ranges in the shared index buffer.
+		unsigned int firstIndex; // Start of the mesh's indices in the shared index buffer.
+		int baseVertex;
+		glm::vec4 positionScale;
+		glm::vec4 positionOrigin;
+		glm::vec4 texCoordTransform;
+	};
+
+	QuantizedMesh layout; // Stride and attribute offsets shared by all meshes, no geometry.
+	std::vector<MeshRange> meshes;
+	std::vector<unsigned char> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<DrawElementsIndirectCommand> fallbackCommands; // Read back by the CPU loop, kept out of the write-only mapping.
+	StreamBuffer stream;
+	StreamAllocation commandAllocation;
+	StreamAllocation drawDataAllocation;
+	unsigned int drawCount;
+	unsigned int maxDraws;
+	unsigned int drawDataUnit;
+	unsigned int attachedBuffer; // Stream buffer currently attached to the texture buffer.
+	unsigned int VAO, VBO, EBO, drawDataTexture;
+
+	bool validMesh(int mesh) const;
+};
+#endif
\ No newline at end of file
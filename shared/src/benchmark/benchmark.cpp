@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "benchmark.hpp"
+
+Stopwatch::Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+void Stopwatch::reset() {
+	start = std::chrono::steady_clock::now();
+}
+
+double Stopwatch::elapsedMs() const {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double Stopwatch::elapsedSeconds() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+SampleStats summarize(std::vector<double> samples) {
+	SampleStats stats = {};
+	if (samples.empty())
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+	stats.count = samples.size();
+	stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+	stats.min = samples.front();
+	stats.max = samples.back();
+	stats.p50 = percentile(samples, 50.0);
+	stats.p90 = percentile(samples, 90.0);
+	stats.p95 = percentile(samples, 95.0);
+	stats.p99 = percentile(samples, 99.0);
+
+	return stats;
+}
+
+double percentile(const std::vector<double> &sortedSamples, double p) {
+	if (sortedSamples.empty())
+		return 0.0;
+
+	size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sortedSamples.size()));
+	return sortedSamples[std::clamp<size_t>(rank, 1, sortedSamples.size()) - 1];
+}
+
+size_t peakResidentBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss); // Bytes on macOS.
+#else
+	return static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux.
+#endif
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Wall clock timer on the monotonic steady clock.
+class Stopwatch {
+public:
+	Stopwatch();
+
+	void reset();
+	double elapsedMs() const;
+	double elapsedSeconds() const;
+
+private:
+	std::chrono::steady_clock::time_point start;
+};
+
+// Summary of a set of timing samples, percentiles use nearest rank.
+struct SampleStats {
+	size_t count;
+	double mean;
+	double min;
+	double max;
+	double p50;
+	double p90;
+	double p95;
+	double p99;
+};
+
+SampleStats summarize(std::vector<double> samples);
+double percentile(const std::vector<double> &sortedSamples, double p);
+// Peak resident set size of the process so far, 0 where unsupported.
+size_t peakResidentBytes();
+#endif
\ No newline at end of file
@@ -85,6 +85,12 @@ glm::mat4 Camera::getViewMatrix() {
 	return rotation * translation;
 }
 
+glm::vec3 Camera::getRayDirection(float ndcX, float ndcY, float aspectRatio) {
+	// Offsets on the image plane one unit in front of the camera.
+	float halfHeight = tan(glm::radians(fovY) * 0.5f);
+	return glm::normalize(zAxis + xAxis * (ndcX * halfHeight * aspectRatio) + yAxis * (ndcY * halfHeight));
+}
+
 void Camera::update() {
 	zAxis = glm::normalize(glm::vec3(
 		cos(glm::radians(yaw)) * cos(glm::radians(pitch)),
@@ -26,6 +26,8 @@ public:
 	void zoom(float yOffset);
 	void accelerate(float factor = 2.0f);
 	glm::mat4 getViewMatrix();
+	// World space direction through a point in normalized device coordinates, for picking.
+	glm::vec3 getRayDirection(float ndcX, float ndcY, float aspectRatio);
 
 private:
 	void update();
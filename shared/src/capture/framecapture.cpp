@@ -0,0 +1,237 @@
+#include <cstdio>
+#include <cstring>
+#include <glad/glad.h>
+#include <stb_image_write.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "framecapture.hpp"
+#include "profile/profiler.hpp"
+
+namespace {
+	const GLuint64 FINISH_TIMEOUT_NS = 1000000000;
+
+	void writeToFile(void *context, void *data, int size) {
+		std::fwrite(data, 1, static_cast<size_t>(size), static_cast<FILE *>(context));
+	}
+}
+
+FrameCapture::FrameCapture(int width, int height, const char *pathFormat, Format format) : width(width), height(height),
+	pathFormat(pathFormat), format(format), pathValid(validPathFormat(pathFormat)), nextSlot(0), buffers(MAX_QUEUED_WRITES),
+	queueHead(0), queueCount(0), writing(false), stopping(false), counters() {
+#ifndef NDEBUG
+	if (!pathValid)
+		DEBUG_OUT << "ERROR::FRAME_CAPTURE::INVALID_PATH_FORMAT\n" << pathFormat << std::endl;
+#endif
+	size_t size = static_cast<size_t>(width) * height * 4;
+	for (Slot &slot : slots) {
+		glGenBuffers(1, &slot.pixelBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+		// Written by GL, read by the CPU.
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		slot.fence = nullptr;
+		slot.frame = 0;
+		slot.pending = false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	for (unsigned int i = 0; i < MAX_QUEUED_WRITES; i++) {
+		buffers[i].resize(size);
+		freeBuffers.push_back(i);
+	}
+
+	writer = std::thread(&FrameCapture::writerLoop, this);
+}
+
+FrameCapture::~FrameCapture() {
+	finish();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_one();
+	writer.join();
+	// Readbacks that outlasted finish's timeout still hold their fence.
+	for (Slot &slot : slots) {
+		if (slot.pending)
+			glDeleteSync(static_cast<GLsync>(slot.fence));
+		glDeleteBuffers(1, &slot.pixelBuffer);
+	}
+}
+
+void FrameCapture::capture(unsigned int framebuffer, unsigned int frame) {
+	PROFILE_SCOPE("FrameCapture::capture");
+	if (!pathValid)
+		return;
+	Slot &slot = slots[nextSlot];
+	if (slot.pending)
+		poll();
+	if (slot.pending) {
+		std::lock_guard<std::mutex> lock(mutex);
+		counters.skipped++;
+		return;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+	// Into the buffer, so this only queues the copy.
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frame;
+	slot.pending = true;
+	nextSlot = (nextSlot + 1) % RING_SIZE;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	counters.captured++;
+}
+
+void FrameCapture::poll() {
+	PROFILE_SCOPE("FrameCapture::poll");
+	handOff(false);
+}
+
+void FrameCapture::finish() {
+	for (unsigned int i = 0; i < RING_SIZE; i++) {
+		Slot &slot = slots[(nextSlot + i) % RING_SIZE];
+		if (slot.pending)
+			glClientWaitSync(static_cast<GLsync>(slot.fence), GL_SYNC_FLUSH_COMMANDS_BIT, FINISH_TIMEOUT_NS);
+	}
+	handOff(true);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [this]() { return queueCount == 0 && !writing; });
+}
+
+FrameCapture::Stats FrameCapture::stats() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+bool FrameCapture::valid() const {
+	return pathValid;
+}
+
+bool FrameCapture::validPathFormat(const char *pathFormat) {
+	unsigned int conversions = 0;
+	for (const char *c = pathFormat; *c; c++) {
+		if (*c != '%')
+			continue;
+		c++;
+		if (*c == '%')
+			continue;
+		while (*c == '0' || *c == '-' || *c == '+' || *c == ' ' || *c == '#')
+			c++;
+		while (*c >= '0' && *c <= '9')
+			c++;
+		if (*c != 'u')
+			return false;
+		conversions++;
+	}
+
+	return conversions == 1;
+}
+
+void FrameCapture::handOff(bool wait) {
+	// Oldest first, a readback still running means the newer ones are too.
+	for (unsigned int i = 0; i < RING_SIZE; i++) {
+		Slot &slot = slots[(nextSlot + i) % RING_SIZE];
+		if (!slot.pending)
+			continue;
+		GLsync fence = static_cast<GLsync>(slot.fence);
+		GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+			break;
+
+		glDeleteSync(fence);
+		slot.fence = nullptr;
+		slot.pending = false;
+		std::unique_lock<std::mutex> lock(mutex);
+		if (status == GL_WAIT_FAILED) {
+		#ifndef NDEBUG
+			DEBUG_OUT << "ERROR::FRAME_CAPTURE::FENCE_WAIT_FAILED\n" << "Frame " << slot.frame << std::endl;
+		#endif
+			counters.failed++;
+			continue;
+		}
+		if (wait)
+			workDone.wait(lock, [this]() { return !freeBuffers.empty() && queueCount < MAX_QUEUED_WRITES; });
+		else if (freeBuffers.empty() || queueCount == MAX_QUEUED_WRITES) {
+			counters.skipped++;
+			continue;
+		}
+		unsigned int buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+		lock.unlock();
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+		const void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, buffers[buffer].size(), GL_MAP_READ_BIT);
+		bool mapped = pixels != nullptr;
+		if (mapped) {
+			// GL rows start at the bottom, files at the top, so rows are flipped on the way out.
+			size_t rowSize = static_cast<size_t>(width) * 4;
+			for (int y = 0; y < height; y++)
+				std::memcpy(buffers[buffer].data() + (height - 1 - y) * rowSize, static_cast<const unsigned char *>(pixels) + y * rowSize, rowSize);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		lock.lock();
+		if (!mapped) {
+			freeBuffers.push_back(buffer);
+			counters.failed++;
+			continue;
+		}
+		queue[(queueHead + queueCount) % MAX_QUEUED_WRITES] = { buffer, slot.frame };
+		queueCount++;
+		lock.unlock();
+		workAvailable.notify_one();
+	}
+}
+
+void FrameCapture::writerLoop() {
+	Profiler::setThreadName("frame capture writer");
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		workAvailable.wait(lock, [this]() { return queueCount > 0 || stopping; });
+		if (queueCount == 0)
+			break;
+
+		WriteRequest request = queue[queueHead];
+		queueHead = (queueHead + 1) % MAX_QUEUED_WRITES;
+		queueCount--;
+		writing = true;
+		lock.unlock();
+		bool written = write(buffers[request.buffer], request.frame);
+		lock.lock();
+		freeBuffers.push_back(request.buffer);
+		if (written)
+			counters.written++;
+		else
+			counters.failed++;
+		writing = false;
+		workDone.notify_all();
+	}
+}
+
+bool FrameCapture::write(const std::vector<unsigned char> &pixels, unsigned int frame) const {
+	PROFILE_SCOPE("FrameCapture::write");
+	char path[512];
+	std::snprintf(path, sizeof(path), pathFormat.c_str(), frame);
+	bool written = false;
+	if (FILE *file = std::fopen(path, "wb")) {
+		if (format == FORMAT_PNG)
+			written = stbi_write_png_to_func(writeToFile, file, width, height, 4, pixels.data(), width * 4) != 0;
+		else
+			written = std::fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+		written = !std::ferror(file) && written;
+		written = std::fclose(file) == 0 && written;
+	}
+#ifndef NDEBUG
+	if (!written)
+		DEBUG_OUT << "ERROR::FRAME_CAPTURE::FILE_NOT_SUCCESFULLY_WRITTEN\n" << path << std::endl;
+#endif
+
+	return written;
+}
\ No newline at end of file
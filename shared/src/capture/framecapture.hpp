@@ -0,0 +1,92 @@
+#pragma once
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads frames back without stalling the pipeline. glReadPixels into one of RING_SIZE pixel pack buffers
+// returns at once, a fence marks when the copy has landed, and poll picks finished buffers up frames later.
+// Their pixels are copied out and a writer thread encodes them to disk, so the render thread only pays for
+// issuing the read and one memcpy per frame. When every buffer is still in flight or the writer is
+// MAX_QUEUED_WRITES frames behind, the frame is skipped and counted rather than waited for.
+// Create, use and destroy on the thread that owns the context.
+class FrameCapture {
+public:
+	static const unsigned int RING_SIZE = 3;
+	static const unsigned int MAX_QUEUED_WRITES = 8;
+
+	enum Format {
+		FORMAT_PNG,
+		FORMAT_RAW // RGBA, 8 bits per channel, rows top to bottom, no header.
+	};
+
+	struct Stats {
+		unsigned int captured; // Readbacks issued.
+		unsigned int written;
+		unsigned int skipped; // Ring or write queue full.
+		unsigned int failed; // Fence or file errors.
+	};
+
+	// Captures the bottom left width x height of the framebuffer. pathFormat is a printf format with one
+	// unsigned int for the frame number, such as "capture/frame_%05u.png", its directory must exist.
+	// With any other format nothing is captured, see validPathFormat.
+	FrameCapture(int width, int height, const char *pathFormat, Format format = FORMAT_PNG);
+	// Finishes outstanding readbacks and writes first.
+	~FrameCapture();
+	FrameCapture(const FrameCapture &) = delete;
+	FrameCapture &operator=(const FrameCapture &) = delete;
+
+	// Starts reading framebuffer's first color buffer, the back buffer for framebuffer 0. Leaves it bound
+	// as the read framebuffer.
+	void capture(unsigned int framebuffer, unsigned int frame);
+	// Hands finished readbacks to the writer, call once per frame.
+	void poll();
+	// Waits for every readback and file, such as before exit. Nothing is skipped for a full write queue here.
+	void finish();
+	Stats stats();
+	bool valid() const;
+
+	// True when pathFormat has exactly one conversion and it is %u, flags and width allowed, %% aside.
+	static bool validPathFormat(const char *pathFormat);
+
+private:
+	struct Slot {
+		unsigned int pixelBuffer;
+		void *fence; // GLsync, kept opaque so GL stays out of this header.
+		unsigned int frame;
+		bool pending;
+	};
+	struct WriteRequest {
+		unsigned int buffer; // Index into buffers.
+		unsigned int frame;
+	};
+
+	int width, height;
+	std::string pathFormat;
+	Format format;
+	bool pathValid;
+	Slot slots[RING_SIZE];
+	unsigned int nextSlot; // Oldest slot, reused next.
+
+	// Guarded by mutex. Buffers move from freeBuffers to the queue and back, so none are allocated after construction.
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	std::vector<std::vector<unsigned char>> buffers;
+	std::vector<unsigned int> freeBuffers;
+	WriteRequest queue[MAX_QUEUED_WRITES];
+	unsigned int queueHead, queueCount;
+	bool writing, stopping;
+	Stats counters;
+	std::thread writer;
+
+	// With wait, blocks for a free write buffer instead of skipping the frame.
+	void handOff(bool wait);
+	void writerLoop();
+	bool write(const std::vector<unsigned char> &pixels, unsigned int frame) const;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <cstring>
+#include <glad/glad.h>
+#ifdef HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "headlesscontext.hpp"
+
+#ifdef HEADLESS_EGL
+namespace {
+	bool hasExtension(const char *extensions, const char *name) {
+		if (!extensions)
+			return false;
+		size_t length = std::strlen(name);
+		for (const char *found = std::strstr(extensions, name); found; found = std::strstr(found + length, name))
+			if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+				return true;
+
+		return false;
+	}
+
+	EGLDisplay openDisplay() {
+		// Client extensions are queried without a display.
+		const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+				reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+			if (getPlatformDisplay) {
+				EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+				if (display != EGL_NO_DISPLAY)
+					return display;
+			}
+		}
+
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+}
+#endif
+
+HeadlessContext::HeadlessContext(int width, int height, int majorVersion, int minorVersion) : display(nullptr), context(nullptr),
+	fbo(0), colorBuffer(0), depthBuffer(0), framebufferWidth(width), framebufferHeight(height), initialized(false) {
+#ifdef HEADLESS_EGL
+	EGLDisplay eglDisplay = openDisplay();
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr)) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::HEADLESS_CONTEXT::NO_DISPLAY\n" << "EGL error 0x" << std::hex << eglGetError() << std::endl;
+	#endif
+		return;
+	}
+	display = eglDisplay;
+	if (!hasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::HEADLESS_CONTEXT::NO_SURFACELESS_OPENGL" << std::endl;
+	#endif
+		destroy();
+		return;
+	}
+
+	// Surface type defaults to window, which surfaceless displays have no configs for.
+	const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config;
+	EGLint configCount = 0;
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+		EGL_CONTEXT_MINOR_VERSION, minorVersion,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	if (eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) && configCount > 0)
+		context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+	if (!context || context == EGL_NO_CONTEXT) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::HEADLESS_CONTEXT::CONTEXT_CREATION_FAILED\n" << "EGL error 0x" << std::hex << eglGetError() << std::endl;
+	#endif
+		context = nullptr;
+		destroy();
+		return;
+	}
+	eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+	if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::HEADLESS_CONTEXT::GLAD_LOAD_FAILED" << std::endl;
+	#endif
+		destroy();
+		return;
+	}
+
+	// Stands in for the default framebuffer.
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::HEADLESS_CONTEXT::FRAMEBUFFER_INCOMPLETE" << std::endl;
+	#endif
+		destroy();
+		return;
+	}
+	glViewport(0, 0, width, height);
+	initialized = true;
+#else
+	(void)majorVersion;
+	(void)minorVersion;
+#ifndef NDEBUG
+	DEBUG_OUT << "ERROR::HEADLESS_CONTEXT::NOT_SUPPORTED\n" << "Built without EGL." << std::endl;
+#endif
+#endif
+}
+
+HeadlessContext::~HeadlessContext() {
+	destroy();
+}
+
+bool HeadlessContext::supported() {
+#ifdef HEADLESS_EGL
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool HeadlessContext::valid() const {
+	return initialized;
+}
+
+void HeadlessContext::makeCurrent() {
+#ifdef HEADLESS_EGL
+	if (!context)
+		return;
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+#endif
+}
+
+void HeadlessContext::releaseCurrent() {
+#ifdef HEADLESS_EGL
+	if (display)
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#endif
+}
+
+void HeadlessContext::swapBuffers() {
+	if (initialized)
+		glFlush();
+}
+
+unsigned int HeadlessContext::framebuffer() const {
+	return fbo;
+}
+
+int HeadlessContext::width() const {
+	return framebufferWidth;
+}
+
+int HeadlessContext::height() const {
+	return framebufferHeight;
+}
+
+void HeadlessContext::readPixels(std::vector<unsigned char> &pixels) const {
+	pixels.resize(static_cast<size_t>(framebufferWidth) * framebufferHeight * 4);
+	if (!initialized)
+		return;
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, framebufferWidth, framebufferHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	// GL rows start at the bottom.
+	size_t rowSize = static_cast<size_t>(framebufferWidth) * 4;
+	std::vector<unsigned char> row(rowSize);
+	for (int y = 0; y < framebufferHeight / 2; y++) {
+		unsigned char *top = pixels.data() + y * rowSize, *bottom = pixels.data() + (framebufferHeight - 1 - y) * rowSize;
+		std::memcpy(row.data(), top, rowSize);
+		std::memcpy(top, bottom, rowSize);
+		std::memcpy(bottom, row.data(), rowSize);
+	}
+}
+
+void HeadlessContext::destroy() {
+#ifdef HEADLESS_EGL
+	if (context) {
+		// GL objects go with the context, but only if it is current here.
+		if (eglGetCurrentContext() == context) {
+			glDeleteFramebuffers(1, &fbo);
+			glDeleteRenderbuffers(1, &depthBuffer);
+			glDeleteRenderbuffers(1, &colorBuffer);
+		}
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display, context);
+	}
+	if (display)
+		eglTerminate(display);
+#endif
+	display = nullptr;
+	context = nullptr;
+	fbo = colorBuffer = depthBuffer = 0;
+	initialized = false;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <vector>
+
+// OpenGL context without a window or display server, for CI machines and benchmarks. Uses EGL with
+// EGL_MESA_platform_surfaceless when available, the default EGL display otherwise, so it runs on llvmpipe.
+// There is no default framebuffer: everything renders into an offscreen framebuffer object that is bound
+// whenever the context is made current, and code that would bind framebuffer 0 binds framebuffer() instead.
+// Only compiled in where the build found EGL (HEADLESS_EGL), elsewhere the context is never valid.
+class HeadlessContext {
+public:
+	// Created current on the calling thread, with glad loaded.
+	HeadlessContext(int width, int height, int majorVersion = 3, int minorVersion = 3);
+	~HeadlessContext();
+	HeadlessContext(const HeadlessContext &) = delete;
+	HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+	static bool supported();
+	bool valid() const;
+
+	// Same rules as glfwMakeContextCurrent, current on one thread at a time.
+	void makeCurrent();
+	void releaseCurrent();
+	// Ends the frame. Nothing is presented, so this only flushes, the image stays for readPixels.
+	void swapBuffers();
+
+	unsigned int framebuffer() const;
+	int width() const;
+	int height() const;
+	// RGBA, 8 bits per channel, rows top to bottom as the image writer expects.
+	void readPixels(std::vector<unsigned char> &pixels) const;
+
+private:
+	void *display; // EGLDisplay and EGLContext, kept opaque so EGL stays out of this header.
+	void *context;
+	unsigned int fbo, colorBuffer, depthBuffer;
+	int framebufferWidth, framebufferHeight;
+	bool initialized;
+
+	void destroy();
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#include "frustum.hpp"
+
+void extractFrustumPlanes(const glm::mat4 &m, glm::vec4 planes[6]) {
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++)
+		row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+	planes[0] = row[3] + row[0]; // Left.
+	planes[1] = row[3] - row[0]; // Right.
+	planes[2] = row[3] + row[1]; // Bottom.
+	planes[3] = row[3] - row[1]; // Top.
+	planes[4] = row[3] + row[2]; // Near.
+	planes[5] = row[3] - row[2]; // Far.
+	for (int i = 0; i < 6; i++)
+		planes[i] = planes[i] / glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// Gribb-Hartmann plane extraction from a (model) view projection matrix: left, right, bottom, top, near, far.
+// Planes face inwards and are normalized, so dot(plane.xyz, p) + plane.w is a signed distance.
+void extractFrustumPlanes(const glm::mat4 &m, glm::vec4 planes[6]);
+#endif
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "frustum.hpp"
+#include "gpuculler.hpp"
+
+namespace {
+	const unsigned int CULL_GROUP_SIZE = 64;
+	const unsigned int REDUCE_GROUP_SIZE = 8;
+	// Storage buffer bindings used by the cull shader.
+	const unsigned int BOUNDS_BINDING = 0, MESH_ID_BINDING = 1, COMMAND_BINDING = 2, VISIBLE_BINDING = 3;
+
+	unsigned int groupCount(int size, unsigned int groupSize) {
+		return (static_cast<unsigned int>(size) + groupSize - 1) / groupSize;
+	}
+}
+
+GpuCuller::GpuCuller(const char *cullShaderPath, const char *depthReduceShaderPath, unsigned int pyramidUnit) :
+	visibleBuffer(0), occlusionCulling(true), boundsBuffer(0), meshIdBuffer(0), commandTemplateBuffer(0), commandBuffer(0),
+	sceneFramebuffer(0), colorTexture(0), depthTexture(0), pyramidTexture(0), outputFramebuffer(0), instanceCount(0), meshCount(0),
+	pyramidUnit(pyramidUnit), width(0), height(0), pyramidLevels(0), pyramidValid(false),
+	frustumPlanesLocation(-1), occlusionCullingLocation(-1), previousViewProjectionLocation(-1), viewProjection(1.0f), previousViewProjection(1.0f) {
+	// Compute shaders would fail to compile on older contexts, the culler stays inert there.
+	if (!supported())
+		return;
+
+	cullShader.compileComputeProgram(cullShaderPath);
+	depthReduceShader.compileComputeProgram(depthReduceShaderPath);
+	frustumPlanesLocation = cullShader.getUniformLocation("frustumPlanes");
+	occlusionCullingLocation = cullShader.getUniformLocation("occlusionCulling");
+	previousViewProjectionLocation = cullShader.getUniformLocation("previousViewProjection");
+	glGenBuffers(1, &boundsBuffer);
+	glGenBuffers(1, &meshIdBuffer);
+	glGenBuffers(1, &commandTemplateBuffer);
+	glGenBuffers(1, &commandBuffer);
+	glGenBuffers(1, &visibleBuffer);
+}
+
+GpuCuller::~GpuCuller() {
+	destroyTargets();
+	glDeleteBuffers(1, &visibleBuffer);
+	glDeleteBuffers(1, &commandBuffer);
+	glDeleteBuffers(1, &commandTemplateBuffer);
+	glDeleteBuffers(1, &meshIdBuffer);
+	glDeleteBuffers(1, &boundsBuffer);
+}
+
+bool GpuCuller::supported() {
+	// Compute shaders, storage buffers and glMultiDrawElementsIndirect are core in GL 4.3.
+	return GLAD_GL_VERSION_4_3;
+}
+
+void GpuCuller::setInstances(const std::vector<glm::vec4> &bounds, const std::vector<unsigned int> &meshIds, std::vector<DrawElementsIndirectCommand> meshCommands) {
+	if (!supported())
+		return;
+
+	instanceCount = static_cast<unsigned int>(bounds.size());
+	meshCount = static_cast<unsigned int>(meshCommands.size());
+
+	// Reserve a range of the visible buffer per mesh, big enough for all of its instances.
+	for (DrawElementsIndirectCommand &command : meshCommands)
+		command.instanceCount = 0;
+	for (unsigned int mesh : meshIds)
+		meshCommands[mesh].instanceCount++;
+	unsigned int baseInstance = 0;
+	for (DrawElementsIndirectCommand &command : meshCommands) {
+		command.baseInstance = baseInstance;
+		baseInstance += command.instanceCount;
+		command.instanceCount = 0;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, bounds.size() * sizeof(glm::vec4), bounds.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshIdBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, meshIds.size() * sizeof(unsigned int), meshIds.data(), GL_STATIC_DRAW);
+	// The template resets instance counts on the GPU each frame.
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandTemplateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, meshCommands.size() * sizeof(DrawElementsIndirectCommand), meshCommands.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, meshCommands.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(instanceCount, 1u) * sizeof(unsigned int), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuCuller::resize(int width, int height) {
+	if (!supported() || (width == this->width && height == this->height) || width <= 0 || height <= 0)
+		return;
+
+	destroyTargets();
+	this->width = width;
+	this->height = height;
+	pyramidLevels = static_cast<int>(std::floor(std::log2(static_cast<float>(std::max(width, height))))) + 1;
+	pyramidValid = false;
+
+	// Scene color and a sampleable depth texture.
+	glGenTextures(1, &colorTexture);
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	// Max depth pyramid, each texel holds the farthest depth of the texels it covers.
+	glGenTextures(1, &pyramidTexture);
+	glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+	glTexStorage2D(GL_TEXTURE_2D, pyramidLevels, GL_R32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &sceneFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+#ifndef NDEBUG
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		DEBUG_OUT << "ERROR::GPU_CULLER::FRAMEBUFFER_INCOMPLETE\n" << width << "x" << height << std::endl;
+#endif
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+}
+
+void GpuCuller::beginFrame(const glm::mat4 &viewProjection) {
+	if (!supported() || !sceneFramebuffer)
+		return;
+
+	this->viewProjection = viewProjection;
+
+	// Reset instance counts from the template, no CPU round trip.
+	glBindBuffer(GL_COPY_READ_BUFFER, commandTemplateBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, meshCount * sizeof(DrawElementsIndirectCommand));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (instanceCount > 0) {
+		glm::vec4 planes[6];
+		extractFrustumPlanes(viewProjection, planes);
+
+		cullShader.useProgram();
+		cullShader.setInt("instanceCount", static_cast<int>(instanceCount));
+		glUniform4fv(frustumPlanesLocation, 6, &planes[0].x);
+		// Occlusion is tested where last frame's depth was, with last frame's matrices.
+		glUniform1i(occlusionCullingLocation, occlusionCulling && pyramidValid);
+		glUniformMatrix4fv(previousViewProjectionLocation, 1, GL_FALSE, &previousViewProjection[0][0]);
+		cullShader.setVec2("pyramidSize", glm::vec2(static_cast<float>(width), static_cast<float>(height)));
+		cullShader.setInt("pyramidLevels", pyramidLevels);
+		cullShader.setInt("depthPyramid", pyramidUnit);
+		glActiveTexture(GL_TEXTURE0 + pyramidUnit);
+		glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+		glBindSampler(pyramidUnit, 0);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BOUNDS_BINDING, boundsBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESH_ID_BINDING, meshIdBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, visibleBuffer);
+		glDispatchCompute(groupCount(static_cast<int>(instanceCount), CULL_GROUP_SIZE), 1, 1);
+		// Commands are read as indirect parameters, visible indices as vertex attributes.
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+}
+
+void GpuCuller::setVisibleInstanceAttribute(unsigned int location) const {
+	glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+	glVertexAttribIPointer(location, 1, GL_UNSIGNED_INT, sizeof(unsigned int), reinterpret_cast<void *>(0));
+	glEnableVertexAttribArray(location);
+	// baseInstance offsets per instance attributes, selecting each command's range of the visible buffer.
+	glVertexAttribDivisor(location, 1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuCuller::draw() const {
+	if (!supported() || meshCount == 0)
+		return;
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(meshCount), 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GpuCuller::endFrame() {
+	if (!supported() || !sceneFramebuffer)
+		return;
+
+	// Present the scene.
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+
+	// Reduce depth into the pyramid, level 0 copies the depth texture, each further level takes the max of its source texels.
+	depthReduceShader.useProgram();
+	depthReduceShader.setInt("source", pyramidUnit);
+	glActiveTexture(GL_TEXTURE0 + pyramidUnit);
+	glBindSampler(pyramidUnit, 0);
+	int levelWidth = width, levelHeight = height;
+	for (int level = 0; level < pyramidLevels; level++) {
+		glBindTexture(GL_TEXTURE_2D, level == 0 ? depthTexture : pyramidTexture);
+		depthReduceShader.setInt("sourceLevel", level == 0 ? 0 : level - 1);
+		glBindImageTexture(0, pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute(groupCount(levelWidth, REDUCE_GROUP_SIZE), groupCount(levelHeight, REDUCE_GROUP_SIZE), 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		levelWidth = std::max(levelWidth / 2, 1);
+		levelHeight = std::max(levelHeight / 2, 1);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	previousViewProjection = viewProjection;
+	pyramidValid = true;
+}
+
+void GpuCuller::setOutputFramebuffer(unsigned int framebuffer) {
+	outputFramebuffer = framebuffer;
+}
+
+void GpuCuller::destroyTargets() {
+	glDeleteFramebuffers(1, &sceneFramebuffer);
+	glDeleteTextures(1, &pyramidTexture);
+	glDeleteTextures(1, &depthTexture);
+	glDeleteTextures(1, &colorTexture);
+	sceneFramebuffer = colorTexture = depthTexture = pyramidTexture = 0;
+}
\ No newline at end of file
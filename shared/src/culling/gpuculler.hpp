@@ -0,0 +1,58 @@
+#pragma once
+#ifndef GPU_CULLER_H
+#define GPU_CULLER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "shader/shader.hpp"
+#include "batch/batchrenderer.hpp"
+
+// GPU driven culling (GL 4.3). A compute pass tests instance bounding spheres against the frustum and a
+// hierarchical-Z pyramid of the previous frame's depth and appends visible instances to per mesh indirect
+// commands. Nothing is read back, the draw consumes the commands with glMultiDrawElementsIndirect.
+// The scene is rendered into an owned framebuffer so its depth can be reduced into the pyramid.
+// Per frame: beginFrame(), use the scene program, clear, draw(), endFrame().
+class GpuCuller {
+public:
+	unsigned int visibleBuffer; // Visible instance indices, per mesh ranges starting at each command's baseInstance.
+	bool occlusionCulling; // Frustum culling only when false.
+
+	GpuCuller(const char *cullShaderPath, const char *depthReduceShaderPath, unsigned int pyramidUnit);
+	~GpuCuller();
+	GpuCuller(const GpuCuller &) = delete;
+	GpuCuller &operator=(const GpuCuller &) = delete;
+
+	static bool supported();
+	// Static instances: world space bounding sphere (xyz center, w radius) and mesh index per instance.
+	// meshCommands provide count, firstIndex and baseVertex per mesh, instance counts and bases are filled in here.
+	void setInstances(const std::vector<glm::vec4> &bounds, const std::vector<unsigned int> &meshIds, std::vector<DrawElementsIndirectCommand> meshCommands);
+	// Match the scene framebuffer and depth pyramid to the default framebuffer size.
+	void resize(int width, int height);
+	// Cull against the frustum of viewProjection and the previous frame's pyramid, then bind the scene framebuffer.
+	void beginFrame(const glm::mat4 &viewProjection);
+	// Visible instance index as a per instance unsigned int attribute on the currently bound VAO.
+	void setVisibleInstanceAttribute(unsigned int location) const;
+	// Draw the culled commands with the currently bound VAO and program.
+	void draw() const;
+	// Blit the scene to the output framebuffer and reduce its depth into the pyramid for the next frame.
+	void endFrame();
+	// Where endFrame presents, 0 is the default framebuffer. Headless contexts have their own.
+	void setOutputFramebuffer(unsigned int framebuffer);
+
+private:
+	Shader cullShader;
+	Shader depthReduceShader;
+	unsigned int boundsBuffer, meshIdBuffer, commandTemplateBuffer, commandBuffer;
+	unsigned int sceneFramebuffer, colorTexture, depthTexture, pyramidTexture, outputFramebuffer;
+	unsigned int instanceCount, meshCount, pyramidUnit;
+	int width, height, pyramidLevels;
+	bool pyramidValid;
+	// Looked up once, setting them by name would build a heap allocated std::string every frame.
+	int frustumPlanesLocation, occlusionCullingLocation, previousViewProjectionLocation;
+	glm::mat4 viewProjection;
+	glm::mat4 previousViewProjection;
+
+	void destroyTargets();
+};
+#endif
\ No newline at end of file
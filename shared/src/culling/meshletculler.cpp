@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MESHLET_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "frustum.hpp"
+#include "meshletculler.hpp"
+
+namespace {
+	const size_t SIMD_WIDTH = 4;
+}
+
+MeshletCuller::MeshletCuller(const MeshletMesh &mesh) : meshletCount(mesh.meshlets.size()) {
+	for (std::vector<float> *lane : { &centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff })
+		lane->resize(meshletCount);
+	firstIndex.resize(meshletCount);
+	indexCount.resize(meshletCount);
+	for (size_t i = 0; i < meshletCount; i++) {
+		const MeshletBounds &bounds = mesh.bounds[i];
+		centerX[i] = bounds.center.x;
+		centerY[i] = bounds.center.y;
+		centerZ[i] = bounds.center.z;
+		radius[i] = bounds.radius;
+		axisX[i] = bounds.coneAxis.x;
+		axisY[i] = bounds.coneAxis.y;
+		axisZ[i] = bounds.coneAxis.z;
+		cutoff[i] = bounds.coneCutoff;
+		firstIndex[i] = mesh.meshlets[i].triangleOffset * 3;
+		indexCount[i] = mesh.meshlets[i].triangleCount * 3;
+	}
+}
+
+void MeshletCuller::cull(
+	const glm::mat4 &model, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition,
+	std::vector<DrawElementsIndirectCommand> &commands, MeshletCullStats &stats, bool simd
+) const {
+	// Everything is tested in object space: planes of the model view projection, and the camera
+	// moved into the model's space. Uniform scale keeps radii and cone angles valid there.
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection * model, planes);
+	glm::vec4 eye = glm::inverse(model) * glm::vec4(cameraPosition, 1.0f);
+	glm::vec3 objectEye(eye.x, eye.y, eye.z);
+	simd = simd && simdSupported();
+
+	bool extendCommand = false;
+	for (size_t group = 0; group < meshletCount; group += SIMD_WIDTH) {
+		size_t count = std::min(SIMD_WIDTH, meshletCount - group);
+		unsigned int culled = 0, outside = 0;
+		if (simd && count == SIMD_WIDTH) {
+			culled = testSimd(group, planes, objectEye, outside);
+		}
+		else {
+			for (size_t i = 0; i < count; i++) {
+				bool meshletOutside;
+				if (testScalar(group + i, planes, objectEye, meshletOutside))
+					culled |= 1u << i;
+				if (meshletOutside)
+					outside |= 1u << i;
+			}
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			size_t meshlet = group + i;
+			size_t triangles = indexCount[meshlet] / 3;
+			stats.meshletsTested++;
+			stats.trianglesTested += triangles;
+			if (culled & (1u << i)) {
+				if (outside & (1u << i))
+					stats.trianglesOutsideFrustum += triangles;
+				else
+					stats.trianglesBackfacing += triangles;
+				extendCommand = false;
+				continue;
+			}
+
+			stats.meshletsVisible++;
+			if (extendCommand)
+				commands.back().count += indexCount[meshlet];
+			else
+				commands.push_back({ indexCount[meshlet], 1, firstIndex[meshlet], 0, 0 });
+			extendCommand = true;
+		}
+	}
+}
+
+bool MeshletCuller::simdSupported() {
+#ifdef MESHLET_CULLER_SSE
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool MeshletCuller::testScalar(size_t meshlet, const glm::vec4 planes[6], const glm::vec3 &eye, bool &outside) const {
+	glm::vec3 center(centerX[meshlet], centerY[meshlet], centerZ[meshlet]);
+	outside = false;
+	for (int p = 0; p < 6; p++)
+		outside = outside || glm::dot(glm::vec3(planes[p].x, planes[p].y, planes[p].z), center) + planes[p].w < -radius[meshlet];
+
+	// Every triangle faces away when the view direction to the sphere lies inside the cone narrowed by its angle.
+	glm::vec3 view = center - eye;
+	float along = glm::dot(view, glm::vec3(axisX[meshlet], axisY[meshlet], axisZ[meshlet]));
+	bool backfacing = along >= cutoff[meshlet] * glm::length(view) + radius[meshlet];
+
+	return outside || backfacing;
+}
+
+unsigned int MeshletCuller::testSimd(size_t firstMeshlet, const glm::vec4 planes[6], const glm::vec3 &eye, unsigned int &outside) const {
+#ifdef MESHLET_CULLER_SSE
+	__m128 cx = _mm_loadu_ps(&centerX[firstMeshlet]);
+	__m128 cy = _mm_loadu_ps(&centerY[firstMeshlet]);
+	__m128 cz = _mm_loadu_ps(&centerZ[firstMeshlet]);
+	__m128 r = _mm_loadu_ps(&radius[firstMeshlet]);
+	__m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+	__m128 outsideMask = _mm_setzero_ps();
+	for (int p = 0; p < 6; p++) {
+		__m128 distance = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(planes[p].x)), _mm_mul_ps(cy, _mm_set1_ps(planes[p].y))),
+			_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(planes[p].z)), _mm_set1_ps(planes[p].w))
+		);
+		outsideMask = _mm_or_ps(outsideMask, _mm_cmplt_ps(distance, negativeR));
+	}
+
+	__m128 vx = _mm_sub_ps(cx, _mm_set1_ps(eye.x));
+	__m128 vy = _mm_sub_ps(cy, _mm_set1_ps(eye.y));
+	__m128 vz = _mm_sub_ps(cz, _mm_set1_ps(eye.z));
+	__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+	__m128 along = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&axisX[firstMeshlet])), _mm_mul_ps(vy, _mm_loadu_ps(&axisY[firstMeshlet]))),
+		_mm_mul_ps(vz, _mm_loadu_ps(&axisZ[firstMeshlet]))
+	);
+	__m128 backfacing = _mm_cmpge_ps(along, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[firstMeshlet]), length), r));
+
+	outside = static_cast<unsigned int>(_mm_movemask_ps(outsideMask));
+	return outside | static_cast<unsigned int>(_mm_movemask_ps(backfacing));
+#else
+	unsigned int culled = 0;
+	outside = 0;
+	for (size_t i = 0; i < SIMD_WIDTH; i++) {
+		bool meshletOutside;
+		if (testScalar(firstMeshlet + i, planes, eye, meshletOutside))
+			culled |= 1u << i;
+		if (meshletOutside)
+			outside |= 1u << i;
+	}
+	return culled;
+#endif
+}
\ No newline at end of file
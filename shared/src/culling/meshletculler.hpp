@@ -0,0 +1,48 @@
+#pragma once
+#ifndef MESHLET_CULLER_H
+#define MESHLET_CULLER_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "batch/batchrenderer.hpp"
+#include "mesh/meshlet.hpp"
+
+struct MeshletCullStats {
+	size_t meshletsTested;
+	size_t meshletsVisible;
+	size_t trianglesTested;
+	size_t trianglesOutsideFrustum;
+	size_t trianglesBackfacing; // Rejected by the normal cone, inside the frustum.
+};
+
+// CPU cluster culling of meshlets against the view frustum and their normal cones.
+// Bounds are kept in structure of arrays form and tested four meshlets at a time with SSE where available.
+// Visible meshlets become indirect commands into MeshletMesh::indexBuffer(), runs of adjacent visible
+// meshlets merge into one command since their triangles are contiguous.
+class MeshletCuller {
+public:
+	MeshletCuller(const MeshletMesh &mesh);
+
+	// Cull one instance, model may rotate, translate and scale uniformly. Commands are appended with
+	// instanceCount 1 and zero baseVertex and baseInstance, stats accumulate.
+	void cull(
+		const glm::mat4 &model, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition,
+		std::vector<DrawElementsIndirectCommand> &commands, MeshletCullStats &stats, bool simd = true
+	) const;
+
+	static bool simdSupported();
+
+private:
+	std::vector<float> centerX, centerY, centerZ, radius;
+	std::vector<float> axisX, axisY, axisZ, cutoff;
+	std::vector<unsigned int> firstIndex, indexCount;
+	size_t meshletCount;
+
+	// True when the meshlet is culled, outside tells whether the frustum rejected it.
+	bool testScalar(size_t meshlet, const glm::vec4 planes[6], const glm::vec3 &eye, bool &outside) const;
+	// Same for four meshlets, one bit per meshlet in the result and in outside.
+	unsigned int testSimd(size_t firstMeshlet, const glm::vec4 planes[6], const glm::vec3 &eye, unsigned int &outside) const;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+MappedFile::MappedFile() : view(nullptr), length(0), file(INVALID_HANDLE_VALUE), mapping(nullptr) {}
+#else
+MappedFile::MappedFile() : view(nullptr), length(0), descriptor(-1) {}
+#endif
+
+MappedFile::MappedFile(const char *path) : MappedFile() {
+	open(path);
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const char *path) {
+	close();
+
+#ifdef _WIN32
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::FILE::FILE_NOT_SUCCESFULLY_READ\n" << path << std::endl;
+	#endif
+		close();
+		return false;
+	}
+	length = static_cast<size_t>(fileSize.QuadPart);
+	// Zero length files cannot be mapped, they open as an empty view.
+	if (length == 0)
+		return true;
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping)
+		view = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	descriptor = ::open(path, O_RDONLY);
+	struct stat status;
+	if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::FILE::FILE_NOT_SUCCESFULLY_READ\n" << path << std::endl;
+	#endif
+		close();
+		return false;
+	}
+	length = static_cast<size_t>(status.st_size);
+	if (length == 0)
+		return true;
+
+	void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	if (address != MAP_FAILED) {
+		view = static_cast<const unsigned char *>(address);
+		// Parsers read front to back, let the kernel read ahead aggressively.
+		madvise(address, length, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (!view) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::FILE::MAPPING_FAILED\n" << path << std::endl;
+	#endif
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (view)
+		UnmapViewOfFile(view);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE)
+		CloseHandle(file);
+	mapping = nullptr;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (view)
+		munmap(const_cast<unsigned char *>(view), length);
+	if (descriptor >= 0)
+		::close(descriptor);
+	descriptor = -1;
+#endif
+	view = nullptr;
+	length = 0;
+}
+
+const unsigned char *MappedFile::data() const {
+	return view;
+}
+
+size_t MappedFile::size() const {
+	return length;
+}
+
+bool MappedFile::isOpen() const {
+#ifdef _WIN32
+	return file != INVALID_HANDLE_VALUE;
+#else
+	return descriptor >= 0;
+#endif
+}
\ No newline at end of file
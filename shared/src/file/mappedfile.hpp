@@ -0,0 +1,32 @@
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// Read only memory mapping of a whole file, the OS pages it in on demand.
+class MappedFile {
+public:
+	MappedFile();
+	MappedFile(const char *path);
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool open(const char *path);
+	void close();
+	const unsigned char *data() const;
+	size_t size() const;
+	bool isOpen() const;
+
+private:
+	const unsigned char *view;
+	size_t length;
+#ifdef _WIN32
+	void *file;
+	void *mapping;
+#else
+	int descriptor;
+#endif
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "framearena.hpp"
+
+namespace {
+	// Padding needed to align address.
+	size_t alignmentPadding(const unsigned char *address, size_t alignment) {
+		return (alignment - (reinterpret_cast<uintptr_t>(address) & (alignment - 1))) & (alignment - 1);
+	}
+
+	unsigned char *allocateBlock(size_t size) {
+		return static_cast<unsigned char *>(::operator new(size, std::align_val_t(LinearArena::BASE_ALIGNMENT)));
+	}
+
+	void freeBlock(unsigned char *block) {
+		::operator delete(block, std::align_val_t(LinearArena::BASE_ALIGNMENT));
+	}
+}
+
+LinearArena::LinearArena(size_t capacity) : base(allocateBlock(std::max<size_t>(capacity, 1))), baseSize(std::max<size_t>(capacity, 1)),
+	offset(0), overflowOffset(0), overflowUsed(0), peakUsed(0) {}
+
+LinearArena::~LinearArena() {
+	reset();
+	freeBlock(base);
+}
+
+void *LinearArena::allocate(size_t size, size_t alignment) {
+	size_t padding = alignmentPadding(base + offset, alignment);
+	if (offset + padding + size > baseSize)
+		return allocateOverflow(size, alignment);
+
+	void *pointer = base + offset + padding;
+	offset += padding + size;
+
+	return pointer;
+}
+
+void LinearArena::reset() {
+	peakUsed = std::max(peakUsed, used());
+	for (const Block &block : overflow)
+		freeBlock(block.data);
+	overflow.clear();
+	overflowOffset = 0;
+	overflowUsed = 0;
+	offset = 0;
+
+	// Overflowed since the last reset, grow so the same frame fits next time. A quarter more leaves
+	// room for frames that vary a little.
+	if (peakUsed > baseSize) {
+		freeBlock(base);
+		baseSize = peakUsed + peakUsed / 4;
+		base = allocateBlock(baseSize);
+	}
+}
+
+size_t LinearArena::used() const {
+	return offset + overflowUsed;
+}
+
+size_t LinearArena::capacity() const {
+	return baseSize;
+}
+
+size_t LinearArena::peak() const {
+	return std::max(peakUsed, used());
+}
+
+void *LinearArena::allocateOverflow(size_t size, size_t alignment) {
+	if (!overflow.empty()) {
+		Block &block = overflow.back();
+		size_t padding = alignmentPadding(block.data + overflowOffset, alignment);
+		if (overflowOffset + padding + size <= block.size) {
+			void *pointer = block.data + overflowOffset + padding;
+			overflowOffset += padding + size;
+			overflowUsed += padding + size;
+			return pointer;
+		}
+	}
+
+	// New block, big enough for the request at any alignment.
+	Block block = { nullptr, std::max(baseSize, size + alignment) };
+	block.data = allocateBlock(block.size);
+	overflow.push_back(block);
+	size_t padding = alignmentPadding(block.data, alignment);
+	overflowOffset = padding + size;
+	overflowUsed += padding + size;
+
+	return block.data + padding;
+}
+
+ArenaResource::ArenaResource(LinearArena &arena) : arena(arena) {}
+
+void *ArenaResource::do_allocate(size_t bytes, size_t alignment) {
+	return arena.allocate(bytes, alignment);
+}
+
+void ArenaResource::do_deallocate(void *, size_t, size_t) {}
+
+bool ArenaResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+	return this == &other;
+}
+
+FrameArena::FrameArena(size_t capacity) : arenas{ LinearArena(capacity), LinearArena(capacity) },
+	resources{ ArenaResource(arenas[0]), ArenaResource(arenas[1]) }, index(0) {}
+
+void FrameArena::beginFrame() {
+	index ^= 1;
+	arenas[index].reset();
+}
+
+LinearArena &FrameArena::current() {
+	return arenas[index];
+}
+
+std::pmr::memory_resource *FrameArena::resource() {
+	return &resources[index];
+}
\ No newline at end of file
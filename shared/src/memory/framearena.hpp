@@ -0,0 +1,87 @@
+#pragma once
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump allocator for data that lives until the next reset. Allocation is an aligned pointer increment,
+// freeing is resetting the whole arena. A frame that needs more than the capacity takes overflow blocks
+// from the heap, and the next reset grows the arena past that peak, so steady state never touches the heap.
+class LinearArena {
+public:
+	static const size_t BASE_ALIGNMENT = 64;
+
+	explicit LinearArena(size_t capacity);
+	~LinearArena();
+	LinearArena(const LinearArena &) = delete;
+	LinearArena &operator=(const LinearArena &) = delete;
+
+	// alignment must be a power of two. Never returns nullptr.
+	void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// Constructs a T in the arena. Its destructor never runs, so T may only own memory from this arena.
+	template <typename T, typename... Args>
+	T *create(Args &&...args);
+	// Invalidates everything allocated since the last reset.
+	void reset();
+
+	size_t used() const; // Bytes since the last reset, padding and overflow included.
+	size_t capacity() const;
+	size_t peak() const; // Most bytes used in one frame so far.
+
+private:
+	struct Block {
+		unsigned char *data;
+		size_t size;
+	};
+
+	unsigned char *base;
+	size_t baseSize;
+	size_t offset;
+	std::vector<Block> overflow;
+	size_t overflowOffset; // Into the last overflow block.
+	size_t overflowUsed;
+	size_t peakUsed;
+
+	void *allocateOverflow(size_t size, size_t alignment);
+};
+
+// std::pmr adapter, standard containers built with it allocate from the arena. Deallocation does nothing,
+// memory comes back when the arena is reset.
+class ArenaResource : public std::pmr::memory_resource {
+public:
+	explicit ArenaResource(LinearArena &arena);
+
+private:
+	LinearArena &arena;
+
+	void *do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
+
+// Two arenas used on alternate frames. Data written in frame N stays valid while frame N + 1 is built,
+// so a consumer that runs at most one frame behind, such as the render thread, can read it without copies.
+class FrameArena {
+public:
+	explicit FrameArena(size_t capacity);
+
+	// Switches to the other arena and resets it, frame N - 1's data is gone after this.
+	void beginFrame();
+	LinearArena &current();
+	std::pmr::memory_resource *resource();
+
+private:
+	LinearArena arenas[2];
+	ArenaResource resources[2];
+	unsigned int index;
+};
+
+template <typename T, typename... Args>
+T *LinearArena::create(Args &&...args) {
+	return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+#endif
\ No newline at end of file
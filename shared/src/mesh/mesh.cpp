@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "mesh.hpp"
+
+namespace {
+	const unsigned int SPHERE_VERTEX_SIZE = 5; // Position, texture coords.
+
+	// Hash and compare vertices by index into the source array.
+	struct VertexHash {
+		const float *data;
+		unsigned int vertexSize;
+
+		size_t operator()(unsigned int index) const {
+			const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data + static_cast<size_t>(index) * vertexSize);
+			uint64_t hash = 14695981039346656037ull; // FNV-1a
+			for (size_t i = 0; i < vertexSize * sizeof(float); i++)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			return static_cast<size_t>(hash);
+		}
+	};
+
+	struct VertexEqual {
+		const float *data;
+		unsigned int vertexSize;
+
+		bool operator()(unsigned int a, unsigned int b) const {
+			return std::memcmp(
+				data + static_cast<size_t>(a) * vertexSize,
+				data + static_cast<size_t>(b) * vertexSize,
+				vertexSize * sizeof(float)
+			) == 0;
+		}
+	};
+}
+
+size_t Mesh::vertexCount() const {
+	return vertexSize ? vertices.size() / vertexSize : 0;
+}
+
+size_t Mesh::triangleCount() const {
+	return indices.size() / 3;
+}
+
+Mesh buildIndexedMesh(const float *vertexData, size_t vertexCount, unsigned int vertexSize) {
+	Mesh mesh;
+	mesh.vertexSize = vertexSize;
+	mesh.indices.reserve(vertexCount);
+
+	// Source vertex index -> welded vertex index.
+	std::unordered_map<unsigned int, unsigned int, VertexHash, VertexEqual> unique(
+		vertexCount,
+		VertexHash{ vertexData, vertexSize },
+		VertexEqual{ vertexData, vertexSize }
+	);
+	for (size_t i = 0; i < vertexCount; i++) {
+		auto result = unique.emplace(static_cast<unsigned int>(i), static_cast<unsigned int>(mesh.vertexCount()));
+		if (result.second) {
+			const float *vertex = vertexData + i * vertexSize;
+			mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + vertexSize);
+		}
+		mesh.indices.push_back(result.first->second);
+	}
+
+	return mesh;
+}
+
+Mesh generateBumpySphere(size_t targetTriangles, Winding winding) {
+	size_t rings = std::max<size_t>(4, static_cast<size_t>(std::sqrt(targetTriangles / 4.0)));
+	size_t segments = std::max<size_t>(8, targetTriangles / (2 * rings));
+	const float PI = 3.14159265358979f, RADIUS = 10.0f, BUMP = 0.3f;
+
+	Mesh mesh;
+	mesh.vertexSize = SPHERE_VERTEX_SIZE;
+	mesh.vertices.reserve((rings + 1) * (segments + 1) * SPHERE_VERTEX_SIZE);
+	for (size_t ring = 0; ring <= rings; ring++) {
+		float v = static_cast<float>(ring) / rings;
+		float theta = v * PI;
+		for (size_t segment = 0; segment <= segments; segment++) {
+			float u = static_cast<float>(segment) / segments;
+			float phi = u * 2.0f * PI;
+			float radius = RADIUS + BUMP * std::sin(phi * 7.0f) * std::sin(theta * 5.0f);
+			const float vertex[SPHERE_VERTEX_SIZE] = {
+				std::sin(theta) * std::cos(phi) * radius, std::cos(theta) * radius, std::sin(theta) * std::sin(phi) * radius,
+				u, v
+			};
+			mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + SPHERE_VERTEX_SIZE);
+		}
+	}
+
+	mesh.indices.reserve(rings * segments * 6);
+	for (size_t ring = 0; ring < rings; ring++) {
+		for (size_t segment = 0; segment < segments; segment++) {
+			unsigned int a = static_cast<unsigned int>(ring * (segments + 1) + segment);
+			unsigned int b = static_cast<unsigned int>(a + segments + 1);
+			// Ring a runs above ring b, so a, a + 1, b turns counter clockwise seen from outside.
+			const unsigned int quad[6] = { a, a + 1, b, a + 1, b + 1, b };
+			if (winding == WINDING_COUNTER_CLOCKWISE)
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			else {
+				const unsigned int flipped[6] = { quad[0], quad[2], quad[1], quad[3], quad[5], quad[4] };
+				mesh.indices.insert(mesh.indices.end(), flipped, flipped + 6);
+			}
+		}
+	}
+
+	return mesh;
+}
\ No newline at end of file
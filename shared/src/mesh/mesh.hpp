@@ -0,0 +1,25 @@
+#pragma once
+#ifndef MESH_H
+#define MESH_H
+
+#include <cstddef>
+#include <vector>
+
+// Indexed triangle list with interleaved float vertices.
+struct Mesh {
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	unsigned int vertexSize; // Floats per vertex.
+
+	size_t vertexCount() const;
+	size_t triangleCount() const;
+};
+
+enum Winding { WINDING_COUNTER_CLOCKWISE, WINDING_CLOCKWISE }; // Seen from outside.
+
+// Weld bitwise identical vertices of an unindexed triangle list into an indexed mesh.
+Mesh buildIndexedMesh(const float *vertexData, size_t vertexCount, unsigned int vertexSize);
+// UV sphere of radius 10 with low frequency bumps, so simplification has curvature to preserve.
+// Vertices are position and texture coords, roughly targetTriangles triangles.
+Mesh generateBumpySphere(size_t targetTriangles, Winding winding = WINDING_COUNTER_CLOCKWISE);
+#endif
\ No newline at end of file
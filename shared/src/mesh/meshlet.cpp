@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "meshlet.hpp"
+
+namespace {
+	const unsigned int NO_TRIANGLE = ~0u;
+	const unsigned char NO_LOCAL_VERTEX = 0xFF;
+	// A cone wider than this (cosine of the half angle) is too wide to ever reject anything useful.
+	const float MIN_CONE_SPREAD = 0.1f;
+
+	// Meshlet under construction.
+	struct MeshletBuilder {
+		const std::vector<glm::vec3> &positions;
+		const std::vector<glm::vec3> &normals;
+		std::vector<unsigned char> localVertex; // Mesh vertex -> meshlet local vertex.
+		std::vector<unsigned int> vertices;
+		std::vector<unsigned int> triangles;
+		glm::vec3 normalSum;
+
+		MeshletBuilder(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &normals)
+			: positions(positions), normals(normals), localVertex(positions.size(), NO_LOCAL_VERTEX), normalSum(0.0f) {}
+
+		unsigned int newVertices(const unsigned int *triangle) const {
+			return (localVertex[triangle[0]] == NO_LOCAL_VERTEX)
+				+ (localVertex[triangle[1]] == NO_LOCAL_VERTEX)
+				+ (localVertex[triangle[2]] == NO_LOCAL_VERTEX);
+		}
+
+		bool fits(const unsigned int *triangle) const {
+			return triangles.size() < MAX_MESHLET_TRIANGLES && vertices.size() + newVertices(triangle) <= MAX_MESHLET_VERTICES;
+		}
+
+		void add(unsigned int triangle, const unsigned int *corners) {
+			for (int c = 0; c < 3; c++) {
+				if (localVertex[corners[c]] == NO_LOCAL_VERTEX) {
+					localVertex[corners[c]] = static_cast<unsigned char>(vertices.size());
+					vertices.push_back(corners[c]);
+				}
+			}
+			triangles.push_back(triangle);
+			normalSum += normals[triangle];
+		}
+
+		void flush(MeshletMesh &result, const std::vector<unsigned int> &indices) {
+			if (triangles.empty())
+				return;
+
+			Meshlet meshlet;
+			meshlet.vertexOffset = static_cast<unsigned int>(result.vertices.size());
+			meshlet.triangleOffset = static_cast<unsigned int>(result.triangles.size() / 3);
+			meshlet.vertexCount = static_cast<unsigned int>(vertices.size());
+			meshlet.triangleCount = static_cast<unsigned int>(triangles.size());
+			result.meshlets.push_back(meshlet);
+			result.vertices.insert(result.vertices.end(), vertices.begin(), vertices.end());
+			for (unsigned int triangle : triangles) {
+				for (int c = 0; c < 3; c++)
+					result.triangles.push_back(localVertex[indices[triangle * 3 + c]]);
+			}
+			result.bounds.push_back(computeBounds());
+
+			for (unsigned int vertex : vertices)
+				localVertex[vertex] = NO_LOCAL_VERTEX;
+			vertices.clear();
+			triangles.clear();
+			normalSum = glm::vec3(0.0f);
+		}
+
+		MeshletBounds computeBounds() const {
+			MeshletBounds bounds;
+			glm::vec3 minimum = positions[vertices[0]], maximum = minimum;
+			for (unsigned int vertex : vertices) {
+				minimum = glm::min(minimum, positions[vertex]);
+				maximum = glm::max(maximum, positions[vertex]);
+			}
+			bounds.center = (minimum + maximum) * 0.5f;
+			bounds.radius = 0.0f;
+			for (unsigned int vertex : vertices)
+				bounds.radius = std::max(bounds.radius, glm::length(positions[vertex] - bounds.center));
+
+			// Cone around the average normal, its spread is the least aligned triangle.
+			float axisLength = glm::length(normalSum);
+			bounds.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+			float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+			for (unsigned int triangle : triangles) {
+				if (normals[triangle] != glm::vec3(0.0f))
+					minDot = std::min(minDot, glm::dot(normals[triangle], bounds.coneAxis));
+			}
+			bounds.coneCutoff = minDot < MIN_CONE_SPREAD ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+			return bounds;
+		}
+	};
+}
+
+size_t MeshletMesh::triangleCount() const {
+	return triangles.size() / 3;
+}
+
+std::vector<unsigned int> MeshletMesh::indexBuffer() const {
+	std::vector<unsigned int> indices(triangles.size());
+	for (const Meshlet &meshlet : meshlets) {
+		for (size_t i = 0; i < meshlet.triangleCount * 3; i++) {
+			size_t corner = meshlet.triangleOffset * 3 + i;
+			indices[corner] = vertices[meshlet.vertexOffset + triangles[corner]];
+		}
+	}
+	return indices;
+}
+
+MeshletMesh buildMeshlets(const Mesh &mesh, const std::vector<unsigned int> &indices, unsigned int positionOffset) {
+	MeshletMesh result;
+	size_t vertexCount = mesh.vertexCount();
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return result;
+
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		const float *vertex = &mesh.vertices[v * mesh.vertexSize + positionOffset];
+		positions[v] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+	}
+	// Unit face normals, zero for degenerate triangles so they never narrow or widen a cone.
+	std::vector<glm::vec3> normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++) {
+		const unsigned int *triangle = &indices[t * 3];
+		glm::vec3 normal = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+		float length = glm::length(normal);
+		normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+
+	// Triangles adjacent to each vertex in compressed row form.
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0), adjacency(indices.size());
+	for (unsigned int index : indices)
+		adjacencyOffsets[index + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	std::vector<unsigned int> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++)
+		adjacency[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+	// Unemitted triangles per vertex. Triangles whose vertices have few left are on the edge of the
+	// remaining surface, taking them first avoids stranding small islands that become tiny meshlets.
+	std::vector<unsigned int> liveTriangles(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	auto liveScore = [&](unsigned int triangle) {
+		const unsigned int *corners = &indices[triangle * 3];
+		return static_cast<float>(std::min({ liveTriangles[corners[0]], liveTriangles[corners[1]], liveTriangles[corners[2]] }));
+	};
+
+	MeshletBuilder builder(positions, normals);
+	// Best unemitted triangle around the given vertices: fewest new vertices, then facing along the cone axis,
+	// then fewest remaining neighbours. With requireFit false, the start of the next meshlet.
+	auto findCandidate = [&](const unsigned int *around, size_t count, bool requireFit) {
+		glm::vec3 axis = builder.normalSum;
+		float axisLength = glm::length(axis);
+		if (axisLength > 0.0f)
+			axis /= axisLength;
+		unsigned int best = NO_TRIANGLE;
+		float bestScore = 0.0f;
+		for (size_t i = 0; i < count; i++) {
+			for (unsigned int a = adjacencyOffsets[around[i]]; a < adjacencyOffsets[around[i] + 1]; a++) {
+				unsigned int candidate = adjacency[a];
+				if (emitted[candidate] || (requireFit && !builder.fits(&indices[candidate * 3])))
+					continue;
+				float score = requireFit
+					? builder.newVertices(&indices[candidate * 3]) + (1.0f - glm::dot(normals[candidate], axis)) + 0.1f * liveScore(candidate)
+					: liveScore(candidate);
+				if (best == NO_TRIANGLE || score < bestScore) {
+					best = candidate;
+					bestScore = score;
+				}
+			}
+		}
+		return best;
+	};
+
+	size_t seed = 0;
+	unsigned int last = NO_TRIANGLE;
+	std::vector<unsigned int> previousVertices;
+	for (size_t added = 0; added < triangleCount; added++) {
+		// Grow from the last triangle, or from anywhere on the meshlet when that is a dead end.
+		unsigned int best = NO_TRIANGLE;
+		if (last != NO_TRIANGLE)
+			best = findCandidate(&indices[last * 3], 3, true);
+		if (best == NO_TRIANGLE && !builder.vertices.empty())
+			best = findCandidate(builder.vertices.data(), builder.vertices.size(), true);
+
+		// Nothing connected fits, close the meshlet and start the next one on the edge of the closed one,
+		// or at the next unused triangle in index order when the surface around it is used up.
+		if (best == NO_TRIANGLE) {
+			previousVertices = builder.vertices;
+			builder.flush(result, indices);
+			best = findCandidate(previousVertices.data(), previousVertices.size(), false);
+			if (best == NO_TRIANGLE) {
+				while (emitted[seed])
+					seed++;
+				best = static_cast<unsigned int>(seed);
+			}
+		}
+
+		emitted[best] = 1;
+		for (int c = 0; c < 3; c++)
+			liveTriangles[indices[best * 3 + c]]--;
+		builder.add(best, &indices[best * 3]);
+		last = best;
+	}
+	builder.flush(result, indices);
+
+	return result;
+}
\ No newline at end of file
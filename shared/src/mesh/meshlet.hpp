@@ -0,0 +1,46 @@
+#pragma once
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+
+// Limits fit a 64 lane wave and the 126 primitive output limit of mesh shader hardware.
+const unsigned int MAX_MESHLET_VERTICES = 64;
+const unsigned int MAX_MESHLET_TRIANGLES = 124;
+
+struct Meshlet {
+	unsigned int vertexOffset; // Into MeshletMesh::vertices.
+	unsigned int triangleOffset; // Into MeshletMesh::triangles, counted in triangles.
+	unsigned int vertexCount;
+	unsigned int triangleCount;
+};
+
+// Object space bounds of a meshlet. Every triangle normal lies within the cone around coneAxis,
+// coneCutoff is the sine of its half angle, 1 when the normals spread too far for the cone to cull.
+struct MeshletBounds {
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	float coneCutoff;
+};
+
+struct MeshletMesh {
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> bounds;
+	std::vector<unsigned int> vertices; // Mesh vertex per meshlet local vertex.
+	std::vector<unsigned char> triangles; // Three meshlet local vertices per triangle.
+
+	size_t triangleCount() const;
+	// Triangle list with each meshlet contiguous, meshlet i starts at index meshlets[i].triangleOffset * 3.
+	std::vector<unsigned int> indexBuffer() const;
+};
+
+// Split a triangle list into meshlets of at most MAX_MESHLET_VERTICES vertices and MAX_MESHLET_TRIANGLES triangles.
+// Meshlets grow across shared edges, preferring triangles that add no new vertex and face the same way,
+// which keeps spheres small and normal cones narrow.
+MeshletMesh buildMeshlets(const Mesh &mesh, const std::vector<unsigned int> &indices, unsigned int positionOffset = 0);
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "meshlod.hpp"
+#include "meshoptimizer.hpp"
+#include "simplifier.hpp"
+
+namespace {
+	// Simplification that removes less than this fraction of the indices ends the chain.
+	const float MIN_LOD_REDUCTION = 0.1f;
+	const unsigned int MIN_LOD_INDEX_COUNT = 36;
+}
+
+std::vector<MeshLod> generateLods(Mesh &mesh, unsigned int maxLodCount, float reduction, unsigned int positionOffset) {
+	std::vector<MeshLod> lods;
+	lods.push_back({ 0, static_cast<unsigned int>(mesh.indices.size()), 0.0f });
+
+	// Each LOD simplifies the previous one, errors accumulate as an upper bound.
+	std::vector<unsigned int> previous = mesh.indices;
+	while (lods.size() < maxLodCount && previous.size() > MIN_LOD_INDEX_COUNT) {
+		size_t target = static_cast<size_t>(previous.size() / 3 * reduction) * 3;
+		float error;
+		std::vector<unsigned int> simplified = simplifyIndices(mesh, previous, target, error, positionOffset);
+		if (simplified.size() > previous.size() * (1.0f - MIN_LOD_REDUCTION))
+			break;
+
+		optimizeVertexCache(simplified, mesh.vertexCount());
+		lods.push_back({ static_cast<unsigned int>(mesh.indices.size()), static_cast<unsigned int>(simplified.size()), lods.back().error + error });
+		mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+		previous.swap(simplified);
+	}
+
+	return lods;
+}
+
+float lodPixelsPerUnit(float fovYDegrees, int viewportHeight) {
+	return viewportHeight / (2.0f * std::tan(glm::radians(fovYDegrees) * 0.5f));
+}
+
+unsigned int selectLod(
+	const std::vector<MeshLod> &lods, unsigned int currentLod, float distance, float pixelsPerUnit, float pixelError, float hysteresis
+) {
+	if (lods.empty())
+		return 0;
+
+	float scale = pixelsPerUnit / std::max(distance, 1e-4f);
+	unsigned int current = std::min(currentLod, static_cast<unsigned int>(lods.size() - 1));
+	unsigned int target = 0;
+	for (unsigned int i = 1; i < lods.size(); i++) {
+		if (lods[i].error * scale <= pixelError)
+			target = i;
+	}
+
+	// Coarsen only once well below the threshold, refine only once well above it.
+	if (target > current) {
+		while (target > current && lods[target].error * scale > pixelError * (1.0f - hysteresis))
+			target--;
+	}
+	else if (target < current && lods[current].error * scale <= pixelError * (1.0f + hysteresis)) {
+		target = current;
+	}
+
+	return target;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <vector>
+
+#include "mesh.hpp"
+
+// Range of Mesh::indices drawn for one level of detail.
+struct MeshLod {
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error; // Geometric deviation from LOD 0 in position units, 0 for LOD 0.
+};
+
+const float DEFAULT_LOD_PIXEL_ERROR = 1.0f;
+const float DEFAULT_LOD_HYSTERESIS = 0.25f;
+
+// Append up to maxLodCount - 1 simplified index ranges to mesh.indices, each about reduction times the previous.
+// Stops early when simplification stalls. Returns all LODs, LOD 0 being the original indices.
+std::vector<MeshLod> generateLods(Mesh &mesh, unsigned int maxLodCount = 4, float reduction = 0.5f, unsigned int positionOffset = 0);
+// Screen pixels covered by one world unit at distance 1, for a perspective with the given vertical FOV.
+float lodPixelsPerUnit(float fovYDegrees, int viewportHeight);
+// Coarsest LOD whose projected error stays within pixelError, keeping currentLod while its error
+// lies within the hysteresis band around the threshold so objects near a switch distance do not pop.
+unsigned int selectLod(
+	const std::vector<MeshLod> &lods, unsigned int currentLod, float distance, float pixelsPerUnit,
+	float pixelError = DEFAULT_LOD_PIXEL_ERROR, float hysteresis = DEFAULT_LOD_HYSTERESIS
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <cstdint>
+
+#include "meshoptimizer.hpp"
+
+namespace {
+	const unsigned int INVALID_INDEX = ~0u;
+
+	// Triangles adjacent to each vertex in compressed row form.
+	struct TriangleAdjacency {
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+
+		TriangleAdjacency(const std::vector<unsigned int> &indices, size_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indices.size()) {
+			for (unsigned int index : indices)
+				offsets[index + 1]++;
+			for (size_t v = 0; v < vertexCount; v++)
+				offsets[v + 1] += offsets[v];
+
+			std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+				triangles[cursor[indices[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+	};
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize) {
+	VertexCacheStats stats = { 0.0, 0.0 };
+	if (indices.empty() || vertexCount == 0)
+		return stats;
+
+	// A vertex is cached while fewer than cacheSize misses happened since it was inserted.
+	std::vector<uint64_t> insertedAt(vertexCount, 0);
+	uint64_t misses = 0;
+	for (unsigned int index : indices) {
+		if (insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize) {
+			misses++;
+			insertedAt[index] = misses;
+		}
+	}
+	stats.acmr = static_cast<double>(misses) / (indices.size() / 3);
+	stats.atvr = static_cast<double>(misses) / vertexCount;
+
+	return stats;
+}
+
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	TriangleAdjacency adjacency(indices, vertexCount);
+	std::vector<unsigned int> liveTriangles(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnd, candidates, output;
+	deadEnd.reserve(indices.size());
+	output.reserve(indices.size());
+	unsigned int timestamp = cacheSize + 1;
+	size_t cursor = 0;
+
+	unsigned int fanning = 0;
+	while (fanning != INVALID_INDEX) {
+		// Emit every remaining triangle around the fanning vertex.
+		candidates.clear();
+		for (unsigned int a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++) {
+			unsigned int triangle = adjacency.triangles[a];
+			if (emitted[triangle])
+				continue;
+			for (int corner = 0; corner < 3; corner++) {
+				unsigned int v = indices[triangle * 3 + corner];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (timestamp - cacheTime[v] > cacheSize)
+					cacheTime[v] = timestamp++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// Next fanning vertex: the oldest candidate that will still be cached after its fan is emitted.
+		fanning = INVALID_INDEX;
+		int bestPriority = -1;
+		for (unsigned int v : candidates) {
+			if (liveTriangles[v] == 0)
+				continue;
+			int priority = 0;
+			if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = static_cast<int>(timestamp - cacheTime[v]);
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				fanning = v;
+			}
+		}
+
+		// Dead end: fall back to recently used vertices, then to input order.
+		while (fanning == INVALID_INDEX && !deadEnd.empty()) {
+			unsigned int v = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[v] > 0)
+				fanning = v;
+		}
+		while (fanning == INVALID_INDEX && cursor < vertexCount) {
+			if (liveTriangles[cursor] > 0)
+				fanning = static_cast<unsigned int>(cursor);
+			cursor++;
+		}
+	}
+
+	indices.swap(output);
+}
+
+void optimizeVertexFetch(Mesh &mesh) {
+	std::vector<unsigned int> remap(mesh.vertexCount(), INVALID_INDEX);
+	std::vector<float> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for (unsigned int &index : mesh.indices) {
+		if (remap[index] == INVALID_INDEX) {
+			remap[index] = static_cast<unsigned int>(vertices.size() / mesh.vertexSize);
+			const float *vertex = &mesh.vertices[static_cast<size_t>(index) * mesh.vertexSize];
+			vertices.insert(vertices.end(), vertex, vertex + mesh.vertexSize);
+		}
+		index = remap[index];
+	}
+
+	mesh.vertices.swap(vertices);
+}
+
+MeshOptimizationReport optimizeMesh(Mesh &mesh, unsigned int cacheSize) {
+	MeshOptimizationReport report;
+	report.before = analyzeVertexCache(mesh.indices, mesh.vertexCount(), cacheSize);
+	optimizeVertexCache(mesh.indices, mesh.vertexCount(), cacheSize);
+	optimizeVertexFetch(mesh);
+	report.after = analyzeVertexCache(mesh.indices, mesh.vertexCount(), cacheSize);
+
+	return report;
+}
\ No newline at end of file
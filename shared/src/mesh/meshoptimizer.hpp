@@ -0,0 +1,30 @@
+#pragma once
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "mesh.hpp"
+
+// Post-transform vertex cache efficiency of an index buffer on a simulated FIFO cache.
+struct VertexCacheStats {
+	double acmr; // Average cache miss ratio, transformed vertices per triangle (0.5 - 3.0).
+	double atvr; // Average transformed vertex ratio, transformed vertices per unique vertex (1.0+).
+};
+
+struct MeshOptimizationReport {
+	VertexCacheStats before;
+	VertexCacheStats after;
+};
+
+const unsigned int DEFAULT_VERTEX_CACHE_SIZE = 16;
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+// Reorder triangles for post-transform cache hits (Tipsify, Sander et al. 2007).
+void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+// Reorder vertices by first use so vertex fetch walks memory linearly, unreferenced vertices are dropped.
+void optimizeVertexFetch(Mesh &mesh);
+// Vertex cache then vertex fetch optimization, returns cache stats around the pass.
+MeshOptimizationReport optimizeMesh(Mesh &mesh, unsigned int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+#endif
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <glm/glm.hpp>
+
+#include "simplifier.hpp"
+
+namespace {
+	const unsigned int NO_VERTEX = ~0u;
+
+	// Symmetric 4x4 plane quadric, sum of w * (n.p + d)^2 over its planes.
+	struct Quadric {
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+		double weight;
+
+		void addPlane(const glm::vec3 &normal, float distance, double w) {
+			double a = normal.x, b = normal.y, c = normal.z, d = distance;
+			a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+			b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+			c2 += w * c * c; cd += w * c * d;
+			d2 += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric &q) {
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			weight += q.weight;
+		}
+
+		double evaluate(const glm::vec3 &p) const {
+			double x = p.x, y = p.y, z = p.z;
+			return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+				+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+				+ c2 * z * z + 2.0 * cd * z
+				+ d2;
+		}
+	};
+
+	struct Collapse {
+		double cost;
+		unsigned int from;
+		unsigned int to;
+	};
+
+	bool samePosition(const glm::vec3 &a, const glm::vec3 &b) {
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	glm::vec3 triangleNormal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+		return glm::cross(b - a, c - a);
+	}
+}
+
+std::vector<unsigned int> simplifyIndices(
+	const Mesh &mesh, const std::vector<unsigned int> &indices, size_t targetIndexCount, float &error, unsigned int positionOffset
+) {
+	error = 0.0f;
+	std::vector<unsigned int> result = indices;
+	size_t vertexCount = mesh.vertexCount();
+	if (vertexCount == 0 || result.size() <= targetIndexCount)
+		return result;
+
+	std::vector<glm::vec3> positions(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		const float *vertex = &mesh.vertices[v * mesh.vertexSize + positionOffset];
+		positions[v] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+	}
+
+	// Vertices sharing a position (split by UVs or normals) map to one canonical vertex for topology and quadrics.
+	std::vector<unsigned int> order(vertexCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [&positions](unsigned int a, unsigned int b) {
+		const glm::vec3 &p = positions[a], &q = positions[b];
+		return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+	});
+	std::vector<unsigned int> canonical(vertexCount);
+	std::vector<bool> locked(vertexCount, false);
+	for (size_t i = 0; i < vertexCount; ) {
+		size_t end = i + 1;
+		while (end < vertexCount && samePosition(positions[order[end]], positions[order[i]]))
+			end++;
+		for (size_t j = i; j < end; j++) {
+			canonical[order[j]] = order[i];
+			// Seam vertices would tear the surface if collapsed on their own.
+			locked[order[j]] = end - i > 1;
+		}
+		i = end;
+	}
+
+	// Area weighted plane quadrics per canonical vertex, edges used by a single triangle lock their vertices.
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	std::vector<std::pair<unsigned int, unsigned int>> edges;
+	edges.reserve(result.size());
+	for (size_t i = 0; i < result.size(); i += 3) {
+		unsigned int corner[3] = { canonical[result[i]], canonical[result[i + 1]], canonical[result[i + 2]] };
+		glm::vec3 normal = triangleNormal(positions[corner[0]], positions[corner[1]], positions[corner[2]]);
+		float length = glm::length(normal);
+		if (length > 0.0f) {
+			glm::vec3 unitNormal = normal / length;
+			float distance = -glm::dot(unitNormal, positions[corner[0]]);
+			for (unsigned int v : corner)
+				quadrics[v].addPlane(unitNormal, distance, 0.5 * length);
+		}
+		for (int e = 0; e < 3; e++)
+			edges.emplace_back(std::min(corner[e], corner[(e + 1) % 3]), std::max(corner[e], corner[(e + 1) % 3]));
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size(); ) {
+		size_t end = i + 1;
+		while (end < edges.size() && edges[end] == edges[i])
+			end++;
+		if (end - i == 1)
+			locked[edges[i].first] = locked[edges[i].second] = true;
+		i = end;
+	}
+	for (size_t v = 0; v < vertexCount; v++) {
+		if (locked[canonical[v]])
+			locked[v] = true;
+	}
+
+	// Passes of independent collapses, cheapest first, each vertex touched at most once per pass.
+	std::vector<unsigned int> offsets, adjacent;
+	std::vector<Collapse> collapses;
+	std::vector<bool> touched;
+	double maxCost = 0.0;
+	while (result.size() > targetIndexCount) {
+		size_t triangleCount = result.size() / 3;
+		offsets.assign(vertexCount + 1, 0);
+		for (unsigned int index : result)
+			offsets[index + 1]++;
+		for (size_t v = 0; v < vertexCount; v++)
+			offsets[v + 1] += offsets[v];
+		adjacent.resize(result.size());
+		std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++)
+			adjacent[cursor[result[i]]++] = static_cast<unsigned int>(i / 3);
+
+		// Cheapest collapse per unlocked vertex onto one of its neighbours.
+		collapses.clear();
+		for (size_t from = 0; from < vertexCount; from++) {
+			if (locked[from])
+				continue;
+			Collapse best = { 0.0, NO_VERTEX, NO_VERTEX };
+			for (unsigned int a = offsets[from]; a < offsets[from + 1]; a++) {
+				const unsigned int *triangle = &result[adjacent[a] * 3];
+				for (int c = 0; c < 3; c++) {
+					unsigned int to = triangle[c];
+					if (to == from)
+						continue;
+					Quadric quadric = quadrics[canonical[from]];
+					quadric.add(quadrics[canonical[to]]);
+					double cost = std::max(0.0, quadric.evaluate(positions[to])) / std::max(quadric.weight, 1e-30);
+					if (best.from == NO_VERTEX || cost < best.cost)
+						best = { cost, static_cast<unsigned int>(from), to };
+				}
+			}
+			if (best.from != NO_VERTEX)
+				collapses.push_back(best);
+		}
+		if (collapses.empty())
+			break;
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+		size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+		size_t removed = 0;
+		touched.assign(vertexCount, false);
+		for (const Collapse &collapse : collapses) {
+			if (removed >= trianglesToRemove)
+				break;
+			if (touched[collapse.from] || touched[collapse.to])
+				continue;
+
+			// Reject collapses that flip a remaining triangle.
+			bool flips = false;
+			unsigned int collapsing = 0;
+			for (unsigned int a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; a++) {
+				const unsigned int *triangle = &result[adjacent[a] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+					collapsing++;
+					continue;
+				}
+				glm::vec3 corner[3], moved[3];
+				for (int c = 0; c < 3; c++) {
+					corner[c] = positions[triangle[c]];
+					moved[c] = triangle[c] == collapse.from ? positions[collapse.to] : corner[c];
+				}
+				glm::vec3 before = triangleNormal(corner[0], corner[1], corner[2]);
+				glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+				flips = glm::dot(before, after) <= 0.0f;
+			}
+			if (flips)
+				continue;
+
+			for (unsigned int a = offsets[collapse.from]; a < offsets[collapse.from + 1]; a++) {
+				unsigned int *triangle = &result[adjacent[a] * 3];
+				for (int c = 0; c < 3; c++) {
+					touched[triangle[c]] = true;
+					if (triangle[c] == collapse.from)
+						triangle[c] = collapse.to;
+				}
+			}
+			quadrics[canonical[collapse.to]].add(quadrics[canonical[collapse.from]]);
+			maxCost = std::max(maxCost, collapse.cost);
+			removed += collapsing;
+		}
+		if (removed == 0)
+			break;
+
+		// Drop triangles that collapsed to an edge.
+		size_t write = 0;
+		for (size_t t = 0; t < triangleCount; t++) {
+			unsigned int a = result[t * 3], b = result[t * 3 + 1], c = result[t * 3 + 2];
+			if (a == b || b == c || a == c)
+				continue;
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	error = static_cast<float>(std::sqrt(maxCost));
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+#ifndef SIMPLIFIER_H
+#define SIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "mesh.hpp"
+
+// Quadric error metric edge collapse (Garland and Heckbert 1997) on an index buffer of mesh.
+// Vertices only move onto existing vertices, so the result indexes the same vertex buffer.
+// Vertices on UV seams or open borders are locked so the surface cannot tear.
+// error receives the largest collapse error, as an RMS distance in position units.
+std::vector<unsigned int> simplifyIndices(
+	const Mesh &mesh, const std::vector<unsigned int> &indices, size_t targetIndexCount, float &error, unsigned int positionOffset = 0
+);
+#endif
\ No newline at end of file
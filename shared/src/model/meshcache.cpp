@@ -0,0 +1,255 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "meshcache.hpp"
+#include "modelloader.hpp"
+
+namespace {
+	const MeshAttributes MODEL_ATTRIBUTES = { 0, 3, 5 };
+
+	size_t alignSection(size_t offset) {
+		return (offset + MeshCache::SECTION_ALIGNMENT - 1) & ~(MeshCache::SECTION_ALIGNMENT - 1);
+	}
+
+	uint64_t mix(uint64_t h) {
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	// Word at a time multiply-xor hash, fast enough to check a multi-hundred MB source on every start.
+	uint64_t hashBytes(const unsigned char *data, size_t size, uint64_t seed) {
+		const uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+		uint64_t h = seed ^ (size * PRIME);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t word;
+			std::memcpy(&word, data + i, sizeof(word));
+			h = (h ^ mix(word)) * PRIME;
+		}
+		uint64_t tail = 0;
+		if (i < size)
+			std::memcpy(&tail, data + i, size - i);
+		return mix((h ^ mix(tail)) * PRIME);
+	}
+}
+
+MeshCache::MeshCache() : header(), valid(false) {}
+
+bool MeshCache::open(const char *path) {
+	close();
+	if (!file.open(path))
+		return false;
+
+	// Sections must lie inside the file and agree with the counts in the header.
+	valid = file.size() >= sizeof(header);
+	if (valid)
+		std::memcpy(&header, file.data(), sizeof(header));
+	valid = valid
+		&& std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+		&& header.version == VERSION
+		&& header.fileSize == file.size()
+		&& header.stride > 0
+		&& header.lodCount > 0
+		// Ordered and inside the file first, so the sums below cannot wrap.
+		&& header.lodOffset >= sizeof(header)
+		&& header.lodOffset <= header.vertexOffset
+		&& header.vertexOffset <= header.indexOffset
+		&& header.indexOffset <= header.fileSize
+		// Sections are read in place through typed pointers.
+		&& header.lodOffset % alignof(MeshLod) == 0
+		&& header.lodOffset + static_cast<uint64_t>(header.lodCount) * sizeof(MeshLod) <= header.vertexOffset
+		&& header.vertexOffset + static_cast<uint64_t>(header.vertexCount) * header.stride <= header.indexOffset
+		&& header.indexOffset + static_cast<uint64_t>(header.indexCount) * sizeof(unsigned int) <= header.fileSize
+		&& header.indexOffset % sizeof(unsigned int) == 0;
+	for (uint32_t i = 0; valid && i < header.lodCount; i++)
+		valid = lods()[i].firstIndex + static_cast<uint64_t>(lods()[i].indexCount) <= header.indexCount;
+
+	if (!valid) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::MESH_CACHE::INVALID_FILE\n" << path << std::endl;
+	#endif
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MeshCache::close() {
+	file.close();
+	valid = false;
+}
+
+bool MeshCache::isOpen() const {
+	return valid;
+}
+
+const unsigned char *MeshCache::vertexData() const {
+	return file.data() + header.vertexOffset;
+}
+
+size_t MeshCache::vertexBytes() const {
+	return static_cast<size_t>(header.vertexCount) * header.stride;
+}
+
+const unsigned int *MeshCache::indexData() const {
+	return reinterpret_cast<const unsigned int *>(file.data() + header.indexOffset);
+}
+
+size_t MeshCache::indexBytes() const {
+	return static_cast<size_t>(header.indexCount) * sizeof(unsigned int);
+}
+
+const MeshLod *MeshCache::lods() const {
+	return reinterpret_cast<const MeshLod *>(file.data() + header.lodOffset);
+}
+
+QuantizedMesh MeshCache::layout() const {
+	QuantizedMesh mesh;
+	mesh.stride = header.stride;
+	mesh.texCoordOffset = header.texCoordOffset;
+	mesh.normalOffset = header.normalOffset;
+	mesh.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	mesh.positionOrigin = glm::vec3(header.positionOrigin[0], header.positionOrigin[1], header.positionOrigin[2]);
+	mesh.texCoordScale = glm::vec2(header.texCoordScale[0], header.texCoordScale[1]);
+	mesh.texCoordOrigin = glm::vec2(header.texCoordOrigin[0], header.texCoordOrigin[1]);
+	return mesh;
+}
+
+QuantizedMesh MeshCache::quantizedMesh() const {
+	QuantizedMesh mesh = layout();
+	mesh.vertices.assign(vertexData(), vertexData() + vertexBytes());
+	mesh.indices.assign(indexData(), indexData() + header.indexCount);
+	return mesh;
+}
+
+std::vector<MeshLod> MeshCache::lodList() const {
+	return std::vector<MeshLod>(lods(), lods() + header.lodCount);
+}
+
+void MeshCache::createBuffers(unsigned int &vertexBuffer, unsigned int &indexBuffer) const {
+	unsigned int buffers[2];
+	glGenBuffers(2, buffers);
+	vertexBuffer = buffers[0];
+	indexBuffer = buffers[1];
+
+	const void *data[2] = { vertexData(), indexData() };
+	size_t sizes[2] = { vertexBytes(), indexBytes() };
+	for (int i = 0; i < 2; i++) {
+		// Bound to GL_COPY_WRITE_BUFFER to leave the caller's VAO element binding alone.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[i]);
+		if (GLAD_GL_VERSION_4_4)
+			glBufferStorage(GL_COPY_WRITE_BUFFER, sizes[i], data[i], 0);
+		else
+			glBufferData(GL_COPY_WRITE_BUFFER, sizes[i], data[i], GL_STATIC_DRAW);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+uint64_t hashMeshSource(const unsigned char *data, size_t size, const MeshCacheSettings &settings) {
+	// Format version and anything that changes the built data are folded into the seed.
+	uint32_t reduction;
+	std::memcpy(&reduction, &settings.lodReduction, sizeof(reduction));
+	uint64_t seed = mix(MeshCache::VERSION ^ (static_cast<uint64_t>(settings.maxLodCount) << 16) ^ (static_cast<uint64_t>(reduction) << 32));
+	return hashBytes(data, size, seed);
+}
+
+bool writeMeshCache(const char *path, const QuantizedMesh &mesh, const std::vector<MeshLod> &lods, uint64_t sourceHash) {
+	MeshCacheHeader header = {};
+	std::memcpy(header.magic, MeshCache::MAGIC, sizeof(header.magic));
+	header.version = MeshCache::VERSION;
+	header.sourceHash = sourceHash;
+	header.stride = mesh.stride;
+	header.texCoordOffset = mesh.texCoordOffset;
+	header.normalOffset = mesh.normalOffset;
+	header.vertexCount = static_cast<uint32_t>(mesh.vertexCount());
+	header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	header.lodCount = static_cast<uint32_t>(lods.size());
+	header.lodOffset = alignSection(sizeof(header));
+	header.vertexOffset = alignSection(header.lodOffset + lods.size() * sizeof(MeshLod));
+	header.indexOffset = alignSection(header.vertexOffset + mesh.vertices.size());
+	header.fileSize = header.indexOffset + mesh.indices.size() * sizeof(unsigned int);
+	for (int c = 0; c < 3; c++) {
+		header.positionScale[c] = mesh.positionScale[c];
+		header.positionOrigin[c] = mesh.positionOrigin[c];
+		// Quantization maps the bounds onto [-1, 1], so they follow from the dequantization constants.
+		header.boundsMin[c] = mesh.positionOrigin[c] - mesh.positionScale[c];
+		header.boundsMax[c] = mesh.positionOrigin[c] + mesh.positionScale[c];
+	}
+	for (int c = 0; c < 2; c++) {
+		header.texCoordScale[c] = mesh.texCoordScale[c];
+		header.texCoordOrigin[c] = mesh.texCoordOrigin[c];
+	}
+
+	// Write beside the target and rename over it, so an interrupted write never leaves a cache that looks valid.
+	std::string temporaryPath = std::string(path) + ".tmp";
+	std::FILE *out = std::fopen(temporaryPath.c_str(), "wb");
+	if (!out) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::MESH_CACHE::FILE_NOT_SUCCESFULLY_WRITTEN\n" << path << std::endl;
+	#endif
+		return false;
+	}
+
+	const unsigned char padding[MeshCache::SECTION_ALIGNMENT] = {};
+	size_t written = 0;
+	auto write = [&](const void *data, size_t size, uint64_t offset) {
+		written += std::fwrite(padding, 1, static_cast<size_t>(offset) - written, out);
+		written += std::fwrite(data, 1, size, out);
+	};
+	write(&header, sizeof(header), 0);
+	write(lods.data(), lods.size() * sizeof(MeshLod), header.lodOffset);
+	write(mesh.vertices.data(), mesh.vertices.size(), header.vertexOffset);
+	write(mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int), header.indexOffset);
+	bool success = std::fclose(out) == 0 && written == header.fileSize;
+
+	std::remove(path);
+	if (!success || std::rename(temporaryPath.c_str(), path) != 0) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::MESH_CACHE::FILE_NOT_SUCCESFULLY_WRITTEN\n" << path << std::endl;
+	#endif
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool loadCachedModel(const char *sourcePath, const char *cachePath, MeshCache &cache, const MeshCacheSettings &settings, bool *rebuilt) {
+	if (rebuilt)
+		*rebuilt = false;
+
+	uint64_t sourceHash;
+	{
+		MappedFile source(sourcePath);
+		if (!source.isOpen())
+			return false;
+		sourceHash = hashMeshSource(source.data(), source.size(), settings);
+	}
+	// A missing cache is the normal first run, not an error worth reporting.
+	std::error_code error;
+	if (std::filesystem::exists(cachePath, error) && cache.open(cachePath) && cache.header.sourceHash == sourceHash)
+		return true;
+	cache.close();
+
+	Mesh mesh;
+	if (!loadModel(sourcePath, mesh, settings.threadCount))
+		return false;
+	std::vector<MeshLod> lods = generateLods(mesh, settings.maxLodCount, settings.lodReduction);
+	QuantizedMesh quantized = quantizeMesh(mesh, MODEL_ATTRIBUTES);
+	if (!writeMeshCache(cachePath, quantized, lods, sourceHash) || !cache.open(cachePath))
+		return false;
+
+	if (rebuilt)
+		*rebuilt = true;
+
+	return true;
+}
\ No newline at end of file
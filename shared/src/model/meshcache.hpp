@@ -0,0 +1,87 @@
+#pragma once
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "file/mappedfile.hpp"
+#include "mesh/meshlod.hpp"
+#include "vertex/vertexformat.hpp"
+
+// File header of a mesh cache, followed by the LOD table, the quantized vertex buffer and the index buffer.
+// Sections start on SECTION_ALIGNMENT byte boundaries and hold exactly what the GPU buffers hold,
+// so a mapped cache uploads with no conversion. All fields are little endian.
+struct MeshCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash; // Content hash of the source asset combined with the build settings.
+	uint64_t fileSize;
+	uint32_t stride;
+	uint32_t texCoordOffset;
+	uint32_t normalOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount; // Every LOD, MeshLod ranges index into this.
+	uint32_t lodCount;
+	uint64_t lodOffset;
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	float positionScale[3];
+	float positionOrigin[3];
+	float texCoordScale[2];
+	float texCoordOrigin[2];
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+// Settings that change the cached data, part of the hash so changing them rebuilds caches.
+struct MeshCacheSettings {
+	unsigned int maxLodCount = 4;
+	float lodReduction = 0.5f;
+	unsigned int threadCount = 0; // Source parsing threads, does not affect the data.
+};
+
+// Read only view of a memory mapped mesh cache.
+class MeshCache {
+public:
+	static constexpr char MAGIC[4] = { 'M', 'S', 'H', 'C' };
+	static const uint32_t VERSION = 1;
+	static const size_t SECTION_ALIGNMENT = 64;
+
+	MeshCacheHeader header;
+
+	MeshCache();
+	MeshCache(const MeshCache &) = delete;
+	MeshCache &operator=(const MeshCache &) = delete;
+
+	// Map and validate the structure, the source hash is left to the caller.
+	bool open(const char *path);
+	void close();
+	bool isOpen() const;
+
+	const unsigned char *vertexData() const;
+	size_t vertexBytes() const;
+	const unsigned int *indexData() const;
+	size_t indexBytes() const;
+	const MeshLod *lods() const;
+	// Stride, attribute offsets and dequantization constants without geometry, for setVertexAttributes
+	// and setDequantizationUniforms.
+	QuantizedMesh layout() const;
+	// Copy of the geometry, for consumers that pack meshes together such as BatchRenderer.
+	QuantizedMesh quantizedMesh() const;
+	std::vector<MeshLod> lodList() const;
+	// Immutable GL buffers filled straight from the mapping with glBufferStorage (GL 4.4), or glBufferData.
+	void createBuffers(unsigned int &vertexBuffer, unsigned int &indexBuffer) const;
+
+private:
+	MappedFile file;
+	bool valid;
+};
+
+uint64_t hashMeshSource(const unsigned char *data, size_t size, const MeshCacheSettings &settings);
+bool writeMeshCache(const char *path, const QuantizedMesh &mesh, const std::vector<MeshLod> &lods, uint64_t sourceHash);
+// Open cachePath if it was built from the current contents of sourcePath with the same settings and format version.
+// Otherwise load the source model, generate LODs, quantize, write the cache and open that. rebuilt reports which happened.
+bool loadCachedModel(const char *sourcePath, const char *cachePath, MeshCache &cache, const MeshCacheSettings &settings = {}, bool *rebuilt = nullptr);
+#endif
\ No newline at end of file
@@ -0,0 +1,923 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "benchmark/benchmark.hpp"
+#include "file/mappedfile.hpp"
+#include "mesh/meshoptimizer.hpp"
+#include "modelloader.hpp"
+
+namespace {
+	const uint32_t NO_INDEX = 0xFFFFFFFFu;
+	const uint32_t RELATIVE_INDEX = 0x80000000u; // Corner value indexes ObjChunk::relativeIndices.
+	const size_t MIN_CHUNK_BYTES = 1 << 20; // Below this a thread costs more than it parses.
+	const int MAX_NODE_DEPTH = 64;
+
+	enum ObjAttribute { OBJ_POSITION, OBJ_TEX_COORD, OBJ_NORMAL, OBJ_ATTRIBUTE_COUNT };
+	const unsigned int OBJ_COMPONENTS[OBJ_ATTRIBUTE_COUNT] = { 3, 2, 3 };
+
+	// Parsed attributes and triangle corners of one line aligned range of an OBJ file.
+	// Corners hold 0-based global indices. Negative OBJ indices are relative to the attributes read so far,
+	// which includes earlier chunks, so they are kept chunk local until every chunk is parsed.
+	struct ObjChunk {
+		const char *begin;
+		const char *end;
+		std::vector<float> attributes[OBJ_ATTRIBUTE_COUNT];
+		std::vector<uint32_t> corners; // Position, texture coords, normal per corner, NO_INDEX when absent.
+		std::vector<int64_t> relativeIndices; // Chunk local 0-based, negative reaches into earlier chunks.
+		size_t bases[OBJ_ATTRIBUTE_COUNT]; // Attribute counts of all earlier chunks.
+		bool valid;
+	};
+
+	const char *skipSpaces(const char *p, const char *end) {
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+		return p;
+	}
+
+	bool atLineEnd(const char *p, const char *end) {
+		return p >= end || *p == '\r' || *p == '#';
+	}
+
+	// std::from_chars is locale independent and an order of magnitude faster than stream extraction.
+	const char *parseFloat(const char *p, const char *end, float &value) {
+		p = skipSpaces(p, end);
+		if (p < end && *p == '+')
+			p++;
+		std::from_chars_result result = std::from_chars(p, end, value);
+		if (result.ec == std::errc::result_out_of_range)
+			value = 0.0f; // Denormals and overflow, not worth failing a model over.
+		else if (result.ec != std::errc())
+			return nullptr;
+		return result.ptr;
+	}
+
+	const char *parseIndex(const char *p, const char *end, int64_t &value) {
+		bool negative = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+'))
+			p++;
+		if (p >= end || *p < '0' || *p > '9')
+			return nullptr;
+		value = 0;
+		while (p < end && *p >= '0' && *p <= '9' && value < RELATIVE_INDEX)
+			value = value * 10 + (*p++ - '0');
+		if (negative)
+			value = -value;
+		return p;
+	}
+
+	bool parseObjAttribute(ObjChunk &chunk, ObjAttribute attribute, const char *p, const char *lineEnd) {
+		float values[3] = { 0.0f, 0.0f, 0.0f };
+		for (unsigned int c = 0; c < OBJ_COMPONENTS[attribute]; c++) {
+			// vt may omit v, trailing components (v w, vertex colors, vt w) are ignored.
+			if (attribute == OBJ_TEX_COORD && c > 0 && atLineEnd(skipSpaces(p, lineEnd), lineEnd))
+				break;
+			p = parseFloat(p, lineEnd, values[c]);
+			if (!p)
+				return false;
+		}
+		chunk.attributes[attribute].insert(chunk.attributes[attribute].end(), values, values + OBJ_COMPONENTS[attribute]);
+		return true;
+	}
+
+	// Face corners v, v/vt, v//vn or v/vt/vn, polygons are fanned into triangles.
+	bool parseObjFace(ObjChunk &chunk, const char *p, const char *lineEnd, std::vector<uint32_t> &polygon) {
+		polygon.clear();
+		for (p = skipSpaces(p, lineEnd); !atLineEnd(p, lineEnd); p = skipSpaces(p, lineEnd)) {
+			uint32_t corner[OBJ_ATTRIBUTE_COUNT] = { NO_INDEX, NO_INDEX, NO_INDEX };
+			for (unsigned int attribute = 0; attribute < OBJ_ATTRIBUTE_COUNT; attribute++) {
+				if (attribute > 0) {
+					if (p >= lineEnd || *p != '/')
+						break;
+					p++;
+					if (attribute == OBJ_TEX_COORD && p < lineEnd && *p == '/')
+						continue;
+				}
+
+				int64_t index;
+				p = parseIndex(p, lineEnd, index);
+				if (!p || index == 0)
+					return false;
+				if (index > 0) {
+					corner[attribute] = static_cast<uint32_t>(index - 1);
+				}
+				else {
+					int64_t localCount = chunk.attributes[attribute].size() / OBJ_COMPONENTS[attribute];
+					corner[attribute] = RELATIVE_INDEX | static_cast<uint32_t>(chunk.relativeIndices.size());
+					chunk.relativeIndices.push_back(localCount + index);
+				}
+			}
+			polygon.insert(polygon.end(), corner, corner + OBJ_ATTRIBUTE_COUNT);
+		}
+
+		size_t cornerCount = polygon.size() / OBJ_ATTRIBUTE_COUNT;
+		if (cornerCount < 3)
+			return false;
+		for (size_t i = 2; i < cornerCount; i++) {
+			chunk.corners.insert(chunk.corners.end(), &polygon[0], &polygon[OBJ_ATTRIBUTE_COUNT]);
+			chunk.corners.insert(chunk.corners.end(), &polygon[(i - 1) * OBJ_ATTRIBUTE_COUNT], &polygon[i * OBJ_ATTRIBUTE_COUNT]);
+			chunk.corners.insert(chunk.corners.end(), &polygon[i * OBJ_ATTRIBUTE_COUNT], &polygon[(i + 1) * OBJ_ATTRIBUTE_COUNT]);
+		}
+		return true;
+	}
+
+	void parseObjChunk(ObjChunk &chunk) {
+		std::vector<uint32_t> polygon;
+		const char *p = chunk.begin, *end = chunk.end;
+		chunk.valid = true;
+		while (p < end) {
+			const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+			if (!lineEnd)
+				lineEnd = end;
+
+			p = skipSpaces(p, lineEnd);
+			bool valid = true;
+			if (lineEnd - p >= 2 && p[0] == 'v') {
+				if (p[1] == ' ' || p[1] == '\t')
+					valid = parseObjAttribute(chunk, OBJ_POSITION, p + 1, lineEnd);
+				else if (p[1] == 't')
+					valid = parseObjAttribute(chunk, OBJ_TEX_COORD, p + 2, lineEnd);
+				else if (p[1] == 'n')
+					valid = parseObjAttribute(chunk, OBJ_NORMAL, p + 2, lineEnd);
+			}
+			else if (lineEnd - p >= 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+				valid = parseObjFace(chunk, p + 1, lineEnd, polygon);
+			}
+			if (!valid) {
+				chunk.valid = false;
+				return;
+			}
+
+			p = lineEnd + 1;
+		}
+	}
+
+	// Open addressing map from resolved (position, texture coords, normal) triplets to welded vertices.
+	class CornerWelder {
+	public:
+		std::vector<uint32_t> keys; // Triplet per welded vertex.
+
+		CornerWelder(size_t expectedVertices) : mask(0), count(0) {
+			rehash(expectedVertices * 2);
+		}
+
+		uint32_t weld(const uint32_t key[OBJ_ATTRIBUTE_COUNT]) {
+			size_t slot = hash(key) & mask;
+			while (table[slot] != NO_INDEX) {
+				const uint32_t *existing = &keys[static_cast<size_t>(table[slot]) * OBJ_ATTRIBUTE_COUNT];
+				if (existing[0] == key[0] && existing[1] == key[1] && existing[2] == key[2])
+					return table[slot];
+				slot = (slot + 1) & mask;
+			}
+
+			uint32_t vertex = static_cast<uint32_t>(count++);
+			table[slot] = vertex;
+			keys.insert(keys.end(), key, key + OBJ_ATTRIBUTE_COUNT);
+			if (count * 2 > table.size())
+				rehash(table.size() * 2);
+			return vertex;
+		}
+
+	private:
+		std::vector<uint32_t> table;
+		size_t mask;
+		size_t count;
+
+		static size_t hash(const uint32_t key[OBJ_ATTRIBUTE_COUNT]) {
+			uint64_t h = key[0] * 0x9E3779B97F4A7C15ull;
+			h ^= (key[1] + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+			h ^= (key[2] + 0x165667B19E3779F9ull) * 0x94D049BB133111EBull;
+			return static_cast<size_t>(h ^ (h >> 29));
+		}
+
+		void rehash(size_t minimumSize) {
+			size_t size = 16;
+			while (size < minimumSize)
+				size *= 2;
+			table.assign(size, NO_INDEX);
+			mask = size - 1;
+			for (size_t vertex = 0; vertex < count; vertex++) {
+				size_t slot = hash(&keys[vertex * OBJ_ATTRIBUTE_COUNT]) & mask;
+				while (table[slot] != NO_INDEX)
+					slot = (slot + 1) & mask;
+				table[slot] = static_cast<uint32_t>(vertex);
+			}
+		}
+	};
+
+	// Global 0-based index of a corner attribute, NO_INDEX when absent or out of range.
+	uint32_t resolveIndex(const ObjChunk &chunk, uint32_t value, unsigned int attribute, size_t total) {
+		if (value == NO_INDEX)
+			return NO_INDEX;
+		int64_t index = value & RELATIVE_INDEX
+			? static_cast<int64_t>(chunk.bases[attribute]) + chunk.relativeIndices[value & ~RELATIVE_INDEX]
+			: value;
+		return index >= 0 && index < static_cast<int64_t>(total) ? static_cast<uint32_t>(index) : NO_INDEX;
+	}
+
+	const float *findAttribute(const std::vector<ObjChunk> &chunks, unsigned int attribute, uint32_t index) {
+		// Few chunks, a linear walk from the back beats a binary search.
+		size_t chunk = chunks.size() - 1;
+		while (chunks[chunk].bases[attribute] > index)
+			chunk--;
+		return &chunks[chunk].attributes[attribute][(index - chunks[chunk].bases[attribute]) * OBJ_COMPONENTS[attribute]];
+	}
+
+	// Area weighted smooth normals for vertices flagged in missing.
+	void generateNormals(Mesh &mesh, const std::vector<unsigned char> &missing) {
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			const unsigned int *triangle = &mesh.indices[i];
+			if (!missing[triangle[0]] && !missing[triangle[1]] && !missing[triangle[2]])
+				continue;
+
+			glm::vec3 positions[3];
+			for (int c = 0; c < 3; c++) {
+				const float *vertex = &mesh.vertices[static_cast<size_t>(triangle[c]) * MODEL_VERTEX_SIZE];
+				positions[c] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+			}
+			glm::vec3 faceNormal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+			for (int c = 0; c < 3; c++) {
+				if (!missing[triangle[c]])
+					continue;
+				float *normal = &mesh.vertices[static_cast<size_t>(triangle[c]) * MODEL_VERTEX_SIZE + 5];
+				normal[0] += faceNormal.x;
+				normal[1] += faceNormal.y;
+				normal[2] += faceNormal.z;
+			}
+		}
+
+		for (size_t vertex = 0; vertex < missing.size(); vertex++) {
+			if (!missing[vertex])
+				continue;
+			float *normal = &mesh.vertices[vertex * MODEL_VERTEX_SIZE + 5];
+			float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 0.0f) {
+				normal[0] /= length;
+				normal[1] /= length;
+				normal[2] /= length;
+			}
+		}
+	}
+
+	// JSON numbers are doubles, so counts, offsets and indices are only cast once they are whole and within 0..limit.
+	bool toSize(double value, size_t limit, size_t &result) {
+		if (!(value >= 0.0 && value <= static_cast<double>(limit)) || value != std::floor(value))
+			return false;
+		result = static_cast<size_t>(value);
+		return true;
+	}
+
+	// Just enough JSON for the glTF header chunk.
+	struct JsonValue {
+		enum Type { JSON_NULL, JSON_BOOLEAN, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+		Type type = JSON_NULL;
+		double number = 0.0; // Booleans are 0 or 1.
+		std::string string;
+		std::vector<JsonValue> elements; // Array elements or object member values.
+		std::vector<std::string> keys; // Object member names, parallel to elements.
+
+		const JsonValue *find(const char *key) const {
+			for (size_t i = 0; i < keys.size(); i++) {
+				if (keys[i] == key)
+					return &elements[i];
+			}
+			return nullptr;
+		}
+
+		const JsonValue *at(double index) const {
+			size_t i;
+			return type == JSON_ARRAY && toSize(index, elements.size(), i) && i < elements.size() ? &elements[i] : nullptr;
+		}
+
+		double numberOr(const char *key, double fallback) const {
+			const JsonValue *value = find(key);
+			return value && value->type == JSON_NUMBER ? value->number : fallback;
+		}
+	};
+
+	class JsonParser {
+	public:
+		JsonParser(const char *begin, const char *end) : p(begin), end(end), depth(0) {}
+
+		bool parse(JsonValue &value) {
+			if (!parseValue(value))
+				return false;
+			skipWhitespace();
+			return p == end || *p == '\0';
+		}
+
+	private:
+		const char *p;
+		const char *end;
+		int depth;
+
+		void skipWhitespace() {
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+				p++;
+		}
+
+		bool match(const char *literal) {
+			size_t length = std::strlen(literal);
+			if (static_cast<size_t>(end - p) < length || std::memcmp(p, literal, length) != 0)
+				return false;
+			p += length;
+			return true;
+		}
+
+		bool parseValue(JsonValue &value) {
+			skipWhitespace();
+			if (p >= end || ++depth > MAX_NODE_DEPTH)
+				return false;
+
+			bool valid;
+			if (*p == '{') {
+				value.type = JsonValue::JSON_OBJECT;
+				valid = parseContainer(value, '}');
+			}
+			else if (*p == '[') {
+				value.type = JsonValue::JSON_ARRAY;
+				valid = parseContainer(value, ']');
+			}
+			else if (*p == '"') {
+				value.type = JsonValue::JSON_STRING;
+				valid = parseString(value.string);
+			}
+			else if (match("true")) {
+				value.type = JsonValue::JSON_BOOLEAN;
+				value.number = 1.0;
+				valid = true;
+			}
+			else if (match("false")) {
+				value.type = JsonValue::JSON_BOOLEAN;
+				valid = true;
+			}
+			else if (match("null")) {
+				valid = true;
+			}
+			else {
+				value.type = JsonValue::JSON_NUMBER;
+				std::from_chars_result result = std::from_chars(p, end, value.number);
+				valid = result.ec == std::errc();
+				p = result.ptr;
+			}
+
+			depth--;
+			return valid;
+		}
+
+		bool parseContainer(JsonValue &value, char close) {
+			p++;
+			skipWhitespace();
+			if (p < end && *p == close) {
+				p++;
+				return true;
+			}
+
+			while (true) {
+				if (value.type == JsonValue::JSON_OBJECT) {
+					skipWhitespace();
+					value.keys.emplace_back();
+					if (p >= end || *p != '"' || !parseString(value.keys.back()))
+						return false;
+					skipWhitespace();
+					if (p >= end || *p++ != ':')
+						return false;
+				}
+				value.elements.emplace_back();
+				if (!parseValue(value.elements.back()))
+					return false;
+
+				skipWhitespace();
+				if (p >= end)
+					return false;
+				char separator = *p++;
+				if (separator == close)
+					return true;
+				if (separator != ',')
+					return false;
+			}
+		}
+
+		bool parseString(std::string &string) {
+			p++;
+			while (p < end && *p != '"') {
+				if (*p != '\\') {
+					string.push_back(*p++);
+					continue;
+				}
+				if (++p >= end)
+					return false;
+				char escape = *p++;
+				switch (escape) {
+					case 'b': string.push_back('\b'); break;
+					case 'f': string.push_back('\f'); break;
+					case 'n': string.push_back('\n'); break;
+					case 'r': string.push_back('\r'); break;
+					case 't': string.push_back('\t'); break;
+					case 'u': {
+						// glTF keys are ASCII, names may not be. Encode the code unit as UTF-8, pairs are not joined.
+						unsigned int code;
+						if (end - p < 4 || std::from_chars(p, p + 4, code, 16).ptr != p + 4)
+							return false;
+						p += 4;
+						if (code < 0x80) {
+							string.push_back(static_cast<char>(code));
+						}
+						else if (code < 0x800) {
+							string.push_back(static_cast<char>(0xC0 | (code >> 6)));
+							string.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+						}
+						else {
+							string.push_back(static_cast<char>(0xE0 | (code >> 12)));
+							string.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+							string.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+						}
+						break;
+					}
+					default: string.push_back(escape); break;
+				}
+			}
+			if (p >= end)
+				return false;
+			p++;
+			return true;
+		}
+	};
+
+	const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+	const unsigned int GL_BYTE_TYPE = 5120, GL_UNSIGNED_BYTE_TYPE = 5121, GL_SHORT_TYPE = 5122;
+	const unsigned int GL_UNSIGNED_SHORT_TYPE = 5123, GL_UNSIGNED_INT_TYPE = 5125, GL_FLOAT_TYPE = 5126;
+	const int GLTF_TRIANGLES = 4;
+
+	struct GlbFile {
+		JsonValue json;
+		const unsigned char *bin;
+		size_t binSize;
+	};
+
+	// Typed, bounds checked view of an accessor's elements in the BIN chunk.
+	struct AccessorView {
+		const unsigned char *data;
+		size_t count;
+		size_t stride;
+		unsigned int componentType;
+		unsigned int components;
+		bool normalized;
+
+		float component(size_t element, unsigned int c) const {
+			const unsigned char *source = data + element * stride;
+			switch (componentType) {
+				case GL_FLOAT_TYPE: {
+					float value;
+					std::memcpy(&value, source + c * sizeof(float), sizeof(float));
+					return value;
+				}
+				case GL_UNSIGNED_BYTE_TYPE:
+					return normalized ? source[c] / 255.0f : source[c];
+				case GL_BYTE_TYPE: {
+					float value = static_cast<signed char>(source[c]);
+					return normalized ? std::max(value / 127.0f, -1.0f) : value;
+				}
+				case GL_UNSIGNED_SHORT_TYPE: {
+					uint16_t value;
+					std::memcpy(&value, source + c * sizeof(value), sizeof(value));
+					return normalized ? value / 65535.0f : value;
+				}
+				case GL_SHORT_TYPE: {
+					int16_t value;
+					std::memcpy(&value, source + c * sizeof(value), sizeof(value));
+					return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+				}
+				default:
+					return 0.0f;
+			}
+		}
+
+		uint32_t index(size_t element) const {
+			const unsigned char *source = data + element * stride;
+			if (componentType == GL_UNSIGNED_BYTE_TYPE)
+				return source[0];
+			if (componentType == GL_UNSIGNED_SHORT_TYPE) {
+				uint16_t value;
+				std::memcpy(&value, source, sizeof(value));
+				return value;
+			}
+			uint32_t value;
+			std::memcpy(&value, source, sizeof(value));
+			return value;
+		}
+	};
+
+	unsigned int componentSize(unsigned int componentType) {
+		switch (componentType) {
+			case GL_BYTE_TYPE:
+			case GL_UNSIGNED_BYTE_TYPE:
+				return 1;
+			case GL_SHORT_TYPE:
+			case GL_UNSIGNED_SHORT_TYPE:
+				return 2;
+			case GL_UNSIGNED_INT_TYPE:
+			case GL_FLOAT_TYPE:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+
+	unsigned int typeComponents(const JsonValue *type) {
+		if (!type || type->type != JsonValue::JSON_STRING)
+			return 0;
+		if (type->string == "SCALAR")
+			return 1;
+		if (type->string.size() == 4 && type->string.compare(0, 3, "VEC") == 0 && type->string[3] >= '2' && type->string[3] <= '4')
+			return type->string[3] - '0';
+		return 0;
+	}
+
+	bool accessorView(const GlbFile &glb, double accessorIndex, unsigned int minComponents, AccessorView &view) {
+		const JsonValue *accessors = glb.json.find("accessors");
+		const JsonValue *accessor = accessors ? accessors->at(accessorIndex) : nullptr;
+		if (!accessor || accessor->find("sparse"))
+			return false;
+		const JsonValue *bufferViews = glb.json.find("bufferViews");
+		double viewIndex = accessor->numberOr("bufferView", -1.0);
+		const JsonValue *bufferView = bufferViews ? bufferViews->at(viewIndex) : nullptr;
+		if (!bufferView || bufferView->numberOr("buffer", 0.0) != 0.0)
+			return false;
+
+		size_t componentType, viewOffset, viewLength, accessorOffset;
+		if (!toSize(accessor->numberOr("componentType", 0.0), 0xFFFF, componentType) || !toSize(accessor->numberOr("count", 0.0), glb.binSize, view.count))
+			return false;
+		view.componentType = static_cast<unsigned int>(componentType);
+		view.components = typeComponents(accessor->find("type"));
+		view.normalized = accessor->numberOr("normalized", 0.0) != 0.0;
+		size_t elementSize = componentSize(view.componentType) * view.components;
+		if (elementSize == 0 || view.components < minComponents)
+			return false;
+
+		if (!toSize(bufferView->numberOr("byteOffset", 0.0), glb.binSize, viewOffset) || !toSize(bufferView->numberOr("byteLength", 0.0), glb.binSize, viewLength)
+			|| !toSize(accessor->numberOr("byteOffset", 0.0), glb.binSize, accessorOffset) || !toSize(bufferView->numberOr("byteStride", 0.0), glb.binSize, view.stride))
+			return false;
+		if (view.stride == 0)
+			view.stride = elementSize;
+		// Only subtractions of smaller values, so crafted sizes cannot wrap around the checks.
+		if (viewLength > glb.binSize - viewOffset || view.stride < elementSize || accessorOffset > viewLength)
+			return false;
+		if (view.count > 0 && (elementSize > viewLength - accessorOffset || view.count - 1 > (viewLength - accessorOffset - elementSize) / view.stride))
+			return false;
+
+		view.data = glb.bin + viewOffset + accessorOffset;
+		return true;
+	}
+
+	bool appendPrimitive(const GlbFile &glb, const JsonValue &primitive, const glm::mat4 &transform, Mesh &mesh, std::vector<unsigned char> &missingNormals) {
+		if (primitive.numberOr("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES)
+			return true; // Points and lines have nothing to rasterize as triangles.
+
+		const JsonValue *attributes = primitive.find("attributes");
+		AccessorView positions, texCoords, normals;
+		if (!attributes || !accessorView(glb, attributes->numberOr("POSITION", -1.0), 3, positions))
+			return false;
+		bool hasTexCoords = accessorView(glb, attributes->numberOr("TEXCOORD_0", -1.0), 2, texCoords) && texCoords.count == positions.count;
+		bool hasNormals = accessorView(glb, attributes->numberOr("NORMAL", -1.0), 3, normals) && normals.count == positions.count;
+
+		size_t baseVertex = mesh.vertexCount();
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+		mesh.vertices.resize((baseVertex + positions.count) * MODEL_VERTEX_SIZE);
+		missingNormals.resize(baseVertex + positions.count, hasNormals ? 0 : 1);
+		for (size_t i = 0; i < positions.count; i++) {
+			float *vertex = &mesh.vertices[(baseVertex + i) * MODEL_VERTEX_SIZE];
+			glm::vec4 position = transform * glm::vec4(positions.component(i, 0), positions.component(i, 1), positions.component(i, 2), 1.0f);
+			glm::vec3 normal(0.0f);
+			if (hasNormals)
+				normal = glm::normalize(normalMatrix * glm::vec3(normals.component(i, 0), normals.component(i, 1), normals.component(i, 2)));
+			vertex[0] = position.x;
+			vertex[1] = position.y;
+			vertex[2] = position.z;
+			vertex[3] = hasTexCoords ? texCoords.component(i, 0) : 0.0f;
+			vertex[4] = hasTexCoords ? texCoords.component(i, 1) : 0.0f;
+			vertex[5] = normal.x;
+			vertex[6] = normal.y;
+			vertex[7] = normal.z;
+		}
+
+		AccessorView indices;
+		double indicesAccessor = primitive.numberOr("indices", -1.0);
+		if (indicesAccessor < 0.0) {
+			// Sequential triangles, a trailing partial triangle is dropped.
+			for (size_t i = 0; i < positions.count - positions.count % 3; i++)
+				mesh.indices.push_back(static_cast<unsigned int>(baseVertex + i));
+			return true;
+		}
+		if (!accessorView(glb, indicesAccessor, 1, indices) || indices.componentType == GL_FLOAT_TYPE)
+			return false;
+		for (size_t i = 0; i + 2 < indices.count; i += 3) {
+			for (int c = 0; c < 3; c++) {
+				uint32_t index = indices.index(i + c);
+				if (index >= positions.count)
+					return false;
+				mesh.indices.push_back(static_cast<unsigned int>(baseVertex + index));
+			}
+		}
+
+		return true;
+	}
+
+	glm::mat4 nodeTransform(const JsonValue &node) {
+		glm::mat4 transform(1.0f);
+		const JsonValue *matrix = node.find("matrix");
+		if (matrix && matrix->elements.size() == 16) {
+			// Column major, same as glm.
+			for (int i = 0; i < 16; i++)
+				glm::value_ptr(transform)[i] = static_cast<float>(matrix->elements[i].number);
+			return transform;
+		}
+
+		const JsonValue *translation = node.find("translation");
+		const JsonValue *rotation = node.find("rotation");
+		const JsonValue *scale = node.find("scale");
+		if (translation && translation->elements.size() == 3) {
+			transform[3] = glm::vec4(
+				static_cast<float>(translation->elements[0].number),
+				static_cast<float>(translation->elements[1].number),
+				static_cast<float>(translation->elements[2].number),
+				1.0f
+			);
+		}
+		if (rotation && rotation->elements.size() == 4) {
+			// glTF stores x, y, z, w.
+			glm::quat q(
+				static_cast<float>(rotation->elements[3].number),
+				static_cast<float>(rotation->elements[0].number),
+				static_cast<float>(rotation->elements[1].number),
+				static_cast<float>(rotation->elements[2].number)
+			);
+			transform = transform * glm::mat4_cast(q);
+		}
+		if (scale && scale->elements.size() == 3) {
+			for (int c = 0; c < 3; c++)
+				transform[c] *= static_cast<float>(scale->elements[c].number);
+		}
+		return transform;
+	}
+
+	bool appendNode(const GlbFile &glb, double nodeIndex, const glm::mat4 &parent, int depth, Mesh &mesh, std::vector<unsigned char> &missingNormals) {
+		const JsonValue *nodes = glb.json.find("nodes");
+		const JsonValue *node = nodes ? nodes->at(nodeIndex) : nullptr;
+		if (!node || depth > MAX_NODE_DEPTH)
+			return false;
+
+		glm::mat4 transform = parent * nodeTransform(*node);
+		const JsonValue *meshes = glb.json.find("meshes");
+		double meshIndex = node->numberOr("mesh", -1.0);
+		if (meshIndex >= 0) {
+			const JsonValue *nodeMesh = meshes ? meshes->at(meshIndex) : nullptr;
+			const JsonValue *primitives = nodeMesh ? nodeMesh->find("primitives") : nullptr;
+			if (!primitives)
+				return false;
+			for (const JsonValue &primitive : primitives->elements) {
+				if (!appendPrimitive(glb, primitive, transform, mesh, missingNormals))
+					return false;
+			}
+		}
+
+		const JsonValue *children = node->find("children");
+		if (children) {
+			for (const JsonValue &child : children->elements) {
+				if (!appendNode(glb, child.number, transform, depth + 1, mesh, missingNormals))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool hasExtension(const char *path, const char *extension) {
+		size_t pathLength = std::strlen(path), extensionLength = std::strlen(extension);
+		if (pathLength < extensionLength)
+			return false;
+		for (size_t i = 0; i < extensionLength; i++) {
+			char c = path[pathLength - extensionLength + i];
+			if (c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+			if (c != extension[i])
+				return false;
+		}
+		return true;
+	}
+}
+
+bool loadObj(const char *path, Mesh &mesh, unsigned int threadCount, ModelLoadStats *stats) {
+	Stopwatch parseTime;
+	MappedFile file(path);
+	if (!file.isOpen())
+		return false;
+
+	// Split into line aligned chunks, one per thread.
+	const char *text = reinterpret_cast<const char *>(file.data());
+	size_t size = file.size();
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_BYTES, 1, threadCount);
+	std::vector<ObjChunk> chunks(chunkCount);
+	const char *begin = text;
+	for (size_t i = 0; i < chunkCount; i++) {
+		const char *end = text + size * (i + 1) / chunkCount;
+		if (i + 1 < chunkCount) {
+			const char *lineEnd = static_cast<const char *>(std::memchr(end, '\n', text + size - end));
+			end = lineEnd ? lineEnd + 1 : text + size;
+		}
+		chunks[i].begin = begin;
+		chunks[i].end = std::max(begin, end);
+		begin = chunks[i].end;
+	}
+
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; i++)
+		workers.emplace_back(parseObjChunk, std::ref(chunks[i]));
+	parseObjChunk(chunks[0]);
+	for (std::thread &worker : workers)
+		worker.join();
+
+	size_t totals[OBJ_ATTRIBUTE_COUNT] = { 0, 0, 0 };
+	size_t cornerCount = 0;
+	for (ObjChunk &chunk : chunks) {
+		if (!chunk.valid) {
+		#ifndef NDEBUG
+			DEBUG_OUT << "ERROR::MODEL::OBJ_PARSE_FAILED\n" << path << std::endl;
+		#endif
+			return false;
+		}
+		for (unsigned int attribute = 0; attribute < OBJ_ATTRIBUTE_COUNT; attribute++) {
+			chunk.bases[attribute] = totals[attribute];
+			totals[attribute] += chunk.attributes[attribute].size() / OBJ_COMPONENTS[attribute];
+		}
+		cornerCount += chunk.corners.size() / OBJ_ATTRIBUTE_COUNT;
+	}
+	double parseMs = parseTime.elapsedMs();
+
+	// Weld corners sharing all three indices, then gather their attributes.
+	Stopwatch indexTime;
+	Mesh result;
+	result.vertexSize = MODEL_VERTEX_SIZE;
+	result.indices.reserve(cornerCount);
+	CornerWelder welder(totals[OBJ_POSITION]);
+	for (const ObjChunk &chunk : chunks) {
+		for (size_t i = 0; i < chunk.corners.size(); i += OBJ_ATTRIBUTE_COUNT) {
+			uint32_t key[OBJ_ATTRIBUTE_COUNT];
+			for (unsigned int attribute = 0; attribute < OBJ_ATTRIBUTE_COUNT; attribute++)
+				key[attribute] = resolveIndex(chunk, chunk.corners[i + attribute], attribute, totals[attribute]);
+			// An index pointing past the file's attributes is an error, an absent vt or vn is not.
+			bool outOfRange = key[OBJ_POSITION] == NO_INDEX
+				|| (key[OBJ_TEX_COORD] == NO_INDEX && chunk.corners[i + OBJ_TEX_COORD] != NO_INDEX)
+				|| (key[OBJ_NORMAL] == NO_INDEX && chunk.corners[i + OBJ_NORMAL] != NO_INDEX);
+			if (outOfRange) {
+			#ifndef NDEBUG
+				DEBUG_OUT << "ERROR::MODEL::OBJ_INDEX_OUT_OF_RANGE\n" << path << std::endl;
+			#endif
+				return false;
+			}
+			result.indices.push_back(welder.weld(key));
+		}
+	}
+
+	size_t vertexCount = welder.keys.size() / OBJ_ATTRIBUTE_COUNT;
+	result.vertices.assign(vertexCount * MODEL_VERTEX_SIZE, 0.0f);
+	std::vector<unsigned char> missingNormals(vertexCount, 0);
+	bool anyMissingNormals = false;
+	for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+		const uint32_t *key = &welder.keys[vertex * OBJ_ATTRIBUTE_COUNT];
+		float *out = &result.vertices[vertex * MODEL_VERTEX_SIZE];
+		std::memcpy(out, findAttribute(chunks, OBJ_POSITION, key[OBJ_POSITION]), 3 * sizeof(float));
+		if (key[OBJ_TEX_COORD] != NO_INDEX)
+			std::memcpy(out + 3, findAttribute(chunks, OBJ_TEX_COORD, key[OBJ_TEX_COORD]), 2 * sizeof(float));
+		if (key[OBJ_NORMAL] != NO_INDEX)
+			std::memcpy(out + 5, findAttribute(chunks, OBJ_NORMAL, key[OBJ_NORMAL]), 3 * sizeof(float));
+		else {
+			missingNormals[vertex] = 1;
+			anyMissingNormals = true;
+		}
+	}
+	if (anyMissingNormals)
+		generateNormals(result, missingNormals);
+
+	optimizeMesh(result);
+	mesh = std::move(result);
+
+	if (stats) {
+		stats->fileBytes = size;
+		stats->parseMs = parseMs;
+		stats->indexMs = indexTime.elapsedMs();
+	}
+
+	return true;
+}
+
+bool loadGlb(const char *path, Mesh &mesh, ModelLoadStats *stats) {
+	Stopwatch parseTime;
+	MappedFile file(path);
+	if (!file.isOpen())
+		return false;
+
+	// 12 byte header, then a JSON chunk and an optional BIN chunk, each with an 8 byte chunk header.
+	const unsigned char *data = file.data();
+	size_t size = file.size();
+	uint32_t header[5];
+	if (size >= sizeof(header))
+		std::memcpy(header, data, sizeof(header));
+	if (size < sizeof(header) || header[0] != GLB_MAGIC || header[1] != 2 || header[2] > size
+		|| header[2] < sizeof(header) || header[4] != GLB_CHUNK_JSON || header[3] > header[2] - sizeof(header)) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::MODEL::GLB_INVALID_HEADER\n" << path << std::endl;
+	#endif
+		return false;
+	}
+
+	GlbFile glb;
+	const char *json = reinterpret_cast<const char *>(data + sizeof(header));
+	JsonParser parser(json, json + header[3]);
+	if (!parser.parse(glb.json) || glb.json.type != JsonValue::JSON_OBJECT) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::MODEL::GLB_INVALID_JSON\n" << path << std::endl;
+	#endif
+		return false;
+	}
+
+	glb.bin = nullptr;
+	glb.binSize = 0;
+	size_t binHeader = sizeof(header) + ((header[3] + 3) & ~3u);
+	if (binHeader + 8 <= header[2]) {
+		uint32_t chunk[2];
+		std::memcpy(chunk, data + binHeader, sizeof(chunk));
+		if (chunk[1] == GLB_CHUNK_BIN && chunk[0] <= header[2] - binHeader - 8) {
+			glb.bin = data + binHeader + 8;
+			glb.binSize = chunk[0];
+		}
+	}
+
+	Mesh result;
+	result.vertexSize = MODEL_VERTEX_SIZE;
+	std::vector<unsigned char> missingNormals;
+	bool valid = true;
+	const JsonValue *scenes = glb.json.find("scenes");
+	const JsonValue *scene = scenes ? scenes->at(glb.json.numberOr("scene", 0.0)) : nullptr;
+	const JsonValue *sceneNodes = scene ? scene->find("nodes") : nullptr;
+	if (sceneNodes) {
+		for (const JsonValue &node : sceneNodes->elements)
+			valid = valid && appendNode(glb, node.number, glm::mat4(1.0f), 0, result, missingNormals);
+	}
+	else if (const JsonValue *meshes = glb.json.find("meshes")) {
+		// No scene, every mesh untransformed.
+		for (const JsonValue &sceneMesh : meshes->elements) {
+			const JsonValue *primitives = sceneMesh.find("primitives");
+			for (size_t i = 0; valid && primitives && i < primitives->elements.size(); i++)
+				valid = appendPrimitive(glb, primitives->elements[i], glm::mat4(1.0f), result, missingNormals);
+		}
+	}
+	if (!valid) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::MODEL::GLB_INVALID_PRIMITIVE\n" << path << std::endl;
+	#endif
+		return false;
+	}
+	double parseMs = parseTime.elapsedMs();
+
+	Stopwatch indexTime;
+	generateNormals(result, missingNormals);
+	optimizeMesh(result);
+	mesh = std::move(result);
+
+	if (stats) {
+		stats->fileBytes = size;
+		stats->parseMs = parseMs;
+		stats->indexMs = indexTime.elapsedMs();
+	}
+
+	return true;
+}
+
+bool loadModel(const char *path, Mesh &mesh, unsigned int threadCount, ModelLoadStats *stats) {
+	if (hasExtension(path, ".obj"))
+		return loadObj(path, mesh, threadCount, stats);
+	if (hasExtension(path, ".glb"))
+		return loadGlb(path, mesh, stats);
+
+#ifndef NDEBUG
+	DEBUG_OUT << "ERROR::MODEL::UNSUPPORTED_FORMAT\n" << path << std::endl;
+#endif
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <cstddef>
+
+#include "mesh/mesh.hpp"
+
+// Vertex layout of loaded models: position, texture coords, normal.
+// Matches MeshAttributes { 0, 3, 5 } for quantizeMesh.
+const unsigned int MODEL_VERTEX_SIZE = 8;
+
+struct ModelLoadStats {
+	size_t fileBytes;
+	double parseMs; // Mapping and parsing the file into attributes and faces.
+	double indexMs; // Welding into an indexed mesh and cache/fetch optimization.
+};
+
+// Wavefront OBJ: v, vt, vn and polygon faces (fan triangulated), everything else is skipped.
+// The file is split at line boundaries into one chunk per thread, threadCount 0 uses every hardware thread.
+// Smooth normals are generated for corners without vn.
+bool loadObj(const char *path, Mesh &mesh, unsigned int threadCount = 0, ModelLoadStats *stats = nullptr);
+// Binary glTF 2.0 (.glb): triangle primitives of the default scene with node transforms applied.
+// Reads POSITION, TEXCOORD_0 and NORMAL from the embedded buffer, external buffers are not supported.
+bool loadGlb(const char *path, Mesh &mesh, ModelLoadStats *stats = nullptr);
+// Pick the loader from the file extension.
+bool loadModel(const char *path, Mesh &mesh, unsigned int threadCount = 0, ModelLoadStats *stats = nullptr);
+#endif
\ No newline at end of file
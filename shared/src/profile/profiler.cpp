@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "profiler.hpp"
+
+namespace {
+	const uint32_t RING_MASK = Profiler::RING_CAPACITY - 1;
+
+	// Single producer, single consumer. The owning thread advances head, the collector advances tail.
+	struct ThreadRing {
+		alignas(64) std::atomic<uint32_t> head{ 0 };
+		alignas(64) std::atomic<uint32_t> tail{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		uint32_t index = 0;
+		std::string name; // Guarded by registryMutex.
+		ProfileEvent events[Profiler::RING_CAPACITY];
+	};
+
+	std::atomic<bool> profilingEnabled(false);
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadRing>> rings;
+	std::vector<ProfileEvent> captured;
+	uint64_t captureDropped = 0;
+
+	// Rings are created on a thread's first event, names set before that wait here.
+	thread_local ThreadRing *currentRing = nullptr;
+	thread_local std::string pendingThreadName;
+
+	ThreadRing &threadRing() {
+		if (!currentRing) {
+			std::lock_guard<std::mutex> lock(registryMutex);
+			rings.push_back(std::make_unique<ThreadRing>());
+			currentRing = rings.back().get();
+			currentRing->index = static_cast<uint32_t>(rings.size() - 1);
+			currentRing->name = pendingThreadName.empty() ? "thread " + std::to_string(currentRing->index) : pendingThreadName;
+		}
+
+		return *currentRing;
+	}
+
+	void writeJsonString(std::FILE *file, const char *text) {
+		std::fputc('"', file);
+		for (const char *c = text; *c; c++) {
+			if (*c == '"' || *c == '\\')
+				std::fputc('\\', file);
+			if (static_cast<unsigned char>(*c) >= 0x20)
+				std::fputc(*c, file);
+		}
+		std::fputc('"', file);
+	}
+}
+
+void Profiler::setEnabled(bool enabled) {
+	profilingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::enabled() {
+	return profilingEnabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const char *name) {
+	pendingThreadName = name;
+	if (currentRing) {
+		std::lock_guard<std::mutex> lock(registryMutex);
+		currentRing->name = name;
+	}
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t end, bool gpu) {
+	if (!enabled())
+		return;
+
+	ThreadRing &ring = threadRing();
+	uint32_t head = ring.head.load(std::memory_order_relaxed);
+	if (head - ring.tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+		ring.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	ring.events[head & RING_MASK] = { name, start, end, ring.index, gpu };
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::collect() {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (const std::unique_ptr<ThreadRing> &ring : rings) {
+		uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint32_t head = ring->head.load(std::memory_order_acquire);
+		for (; tail != head; tail++) {
+			if (captured.size() < MAX_CAPTURED_EVENTS)
+				captured.push_back(ring->events[tail & RING_MASK]);
+			else
+				captureDropped++;
+		}
+		ring->tail.store(tail, std::memory_order_release);
+	}
+}
+
+const std::vector<ProfileEvent> &Profiler::capture() {
+	return captured;
+}
+
+uint64_t Profiler::droppedEvents() {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	uint64_t dropped = captureDropped;
+	for (const std::unique_ptr<ThreadRing> &ring : rings)
+		dropped += ring->dropped.load(std::memory_order_relaxed);
+
+	return dropped;
+}
+
+void Profiler::clear() {
+	std::lock_guard<std::mutex> lock(registryMutex);
+	captured.clear();
+	captureDropped = 0;
+	for (const std::unique_ptr<ThreadRing> &ring : rings)
+		ring->dropped.store(0, std::memory_order_relaxed);
+}
+
+bool Profiler::writeChromeTrace(const char *path) {
+	std::FILE *file = std::fopen(path, "wb");
+	if (!file) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::PROFILER::FILE_NOT_SUCCESFULLY_WRITTEN\n" << path << std::endl;
+	#endif
+		return false;
+	}
+
+	// Timestamps from the first event, in microseconds as the format expects. Each thread has an even
+	// track id, its GPU scopes go to the odd one after it.
+	uint64_t origin = UINT64_MAX;
+	std::vector<bool> gpuTracks;
+	for (const ProfileEvent &event : captured) {
+		origin = std::min(origin, event.start);
+		if (event.gpu) {
+			gpuTracks.resize(std::max<size_t>(gpuTracks.size(), event.thread + 1));
+			gpuTracks[event.thread] = true;
+		}
+	}
+	std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+	bool first = true;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		for (const std::unique_ptr<ThreadRing> &ring : rings) {
+			bool hasGpuTrack = ring->index < gpuTracks.size() && gpuTracks[ring->index];
+			for (int gpu = 0; gpu < 1 + hasGpuTrack; gpu++) {
+				std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", ring->index * 2 + gpu);
+				writeJsonString(file, (ring->name + (gpu ? " GPU" : "")).c_str());
+				std::fputs("}}", file);
+				first = false;
+			}
+		}
+	}
+	for (const ProfileEvent &event : captured) {
+		std::fputs(first ? "{\"name\":" : ",\n{\"name\":", file);
+		writeJsonString(file, event.name);
+		std::fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", event.thread * 2 + event.gpu,
+			(event.start - origin) * 1e-3, (event.end > event.start ? event.end - event.start : 0) * 1e-3);
+		first = false;
+	}
+	std::fputs("\n]}\n", file);
+	bool written = std::ferror(file) == 0;
+	std::fclose(file);
+
+	return written;
+}
+
+GpuTimer::GpuTimer() : current(0), depth(0) {
+	for (Frame &frame : frames) {
+		glGenQueries(MAX_SCOPES * 2, frame.queries);
+		frame.count = 0;
+		frame.lastQuery = 0;
+	}
+}
+
+GpuTimer::~GpuTimer() {
+	for (Frame &frame : frames)
+		glDeleteQueries(MAX_SCOPES * 2, frame.queries);
+}
+
+void GpuTimer::beginFrame() {
+	// Scopes left open end with the frame.
+	while (depth > 0)
+		end();
+
+	current = (current + 1) % FRAME_LATENCY;
+	Frame &frame = frames[current];
+	if (frame.count > 0) {
+		GLint available = 0;
+		glGetQueryObjectiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+		// Still running after FRAME_LATENCY frames, skip it rather than wait.
+		if (available) {
+			// GPU timestamps to the CPU clock, measured now so drift between the clocks never builds up.
+			GLint64 gpuNow = 0;
+			glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+			int64_t offset = static_cast<int64_t>(nowNanoseconds()) - gpuNow;
+			results.clear();
+			for (unsigned int i = 0; i < frame.count; i++) {
+				GLuint64 start = 0, end = 0;
+				glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+				glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+				results.push_back({ frame.names[i], (end - start) * 1e-6 });
+				Profiler::record(frame.names[i], start + offset, end + offset, true);
+			}
+		}
+	}
+	frame.count = 0;
+}
+
+void GpuTimer::begin(const char *name) {
+	Frame &frame = frames[current];
+	int scope = -1;
+	if (frame.count < MAX_SCOPES) {
+		scope = static_cast<int>(frame.count++);
+		frame.names[scope] = name;
+		glQueryCounter(frame.queries[scope * 2], GL_TIMESTAMP);
+	}
+	if (depth < MAX_SCOPES)
+		stack[depth] = scope;
+	depth++;
+}
+
+void GpuTimer::end() {
+	if (depth == 0)
+		return;
+
+	depth--;
+	Frame &frame = frames[current];
+	if (depth < MAX_SCOPES && stack[depth] >= 0) {
+		frame.lastQuery = frame.queries[stack[depth] * 2 + 1];
+		glQueryCounter(frame.lastQuery, GL_TIMESTAMP);
+	}
+}
+
+const std::vector<GpuTimer::Result> &GpuTimer::frameResults() const {
+	return results;
+}
\ No newline at end of file
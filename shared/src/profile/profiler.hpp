@@ -0,0 +1,113 @@
+#pragma once
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <vector>
+#ifdef TRACY_ENABLE
+#include <tracy/Tracy.hpp>
+#endif
+
+#include "timing/framepacer.hpp"
+
+// One timed scope. Names must outlive the profiler, string literals in practice.
+struct ProfileEvent {
+	const char *name;
+	uint64_t start; // nowNanoseconds clock, GPU times are converted to it.
+	uint64_t end;
+	uint32_t thread; // Registration order, 0 is the first thread that recorded.
+	bool gpu; // Measured by GpuTimer on the thread's context.
+};
+
+// Collects timed scopes from every thread. Each thread records into its own fixed ring, which one
+// collecting thread drains, so recording never takes a lock or allocates after the thread's first event.
+// A full ring drops events rather than wait. Disabled by default, scopes then cost one relaxed load.
+// Builds with TRACY_ENABLE also forward PROFILE_SCOPE to Tracy zones.
+class Profiler {
+public:
+	static const uint32_t RING_CAPACITY = 16384; // Events per thread between collects.
+	static const size_t MAX_CAPTURED_EVENTS = 1 << 22; // Further events are counted as dropped.
+
+	static void setEnabled(bool enabled);
+	static bool enabled();
+	// Names the calling thread in exports.
+	static void setThreadName(const char *name);
+	static void record(const char *name, uint64_t start, uint64_t end, bool gpu = false);
+
+	// Moves ring contents into the capture. Call from one thread at a time, once per frame or so.
+	static void collect();
+	static const std::vector<ProfileEvent> &capture();
+	static uint64_t droppedEvents();
+	static void clear();
+
+	// Chrome trace event JSON, for chrome://tracing, Perfetto, or Tracy through its import-chrome tool.
+	// GPU scopes get their own track next to the thread that measured them.
+	static bool writeChromeTrace(const char *path);
+};
+
+// Records the enclosing scope.
+class ProfileScope {
+public:
+	explicit ProfileScope(const char *name) : name(name), start(Profiler::enabled() ? nowNanoseconds() : 0) {}
+	~ProfileScope() {
+		if (start)
+			Profiler::record(name, start, nowNanoseconds());
+	}
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+	const char *name;
+	uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef TRACY_ENABLE
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name); ZoneScopedN(name)
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+// GPU time of scopes within a frame, from GL_TIMESTAMP queries issued around them. Timestamps nest,
+// unlike GL_TIME_ELAPSED queries, and place scopes on the CPU timeline. Each frame has its own query set,
+// read FRAME_LATENCY frames later when the GPU has long finished, so reading never stalls the pipeline.
+// Results go to the profiler when it is enabled and to frameResults either way. Create, use and destroy
+// with the context current.
+class GpuTimer {
+public:
+	static const unsigned int FRAME_LATENCY = 3;
+	static const unsigned int MAX_SCOPES = 32; // Per frame, further scopes are not measured.
+
+	struct Result {
+		const char *name;
+		double ms;
+	};
+
+	GpuTimer();
+	~GpuTimer();
+	GpuTimer(const GpuTimer &) = delete;
+	GpuTimer &operator=(const GpuTimer &) = delete;
+
+	// Resolves the oldest frame's queries and starts recording a new frame.
+	void beginFrame();
+	void begin(const char *name);
+	void end();
+	// Scopes of the last resolved frame, FRAME_LATENCY frames old, in begin order.
+	const std::vector<Result> &frameResults() const;
+
+private:
+	struct Frame {
+		unsigned int queries[MAX_SCOPES * 2]; // Begin and end timestamp per scope.
+		const char *names[MAX_SCOPES];
+		unsigned int count;
+		unsigned int lastQuery; // Issued last, the frame's results are ready when it is.
+	};
+
+	Frame frames[FRAME_LATENCY];
+	unsigned int current;
+	int stack[MAX_SCOPES]; // Open scopes, -1 for those past MAX_SCOPES.
+	unsigned int depth;
+	std::vector<Result> results;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "glstatecache.hpp"
+
+namespace {
+	const unsigned int UNKNOWN = ~0u;
+
+	const GLenum bufferTargets[] = {
+		GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_DRAW_INDIRECT_BUFFER,
+		GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_TEXTURE_BUFFER
+	};
+	const GLenum textureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BUFFER };
+
+	int findSlot(const GLenum *targets, int count, unsigned int target) {
+		for (int i = 0; i < count; i++)
+			if (targets[i] == target)
+				return i;
+		return -1;
+	}
+
+#ifndef NDEBUG
+	const GLenum bufferBindingQueries[] = {
+		GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_BINDING,
+		GL_DRAW_INDIRECT_BUFFER_BINDING, GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING, GL_TEXTURE_BUFFER_BINDING
+	};
+	const GLenum textureBindingQueries[] = {
+		GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_2D_ARRAY, GL_TEXTURE_BINDING_CUBE_MAP, GL_TEXTURE_BINDING_BUFFER
+	};
+
+	bool check(const char *name, unsigned int cached, GLenum query) {
+		if (cached == UNKNOWN)
+			return true;
+		GLint value = 0;
+		glGetIntegerv(query, &value);
+		if (static_cast<unsigned int>(value) == cached)
+			return true;
+		DEBUG_OUT << "ERROR::GL_STATE_CACHE::MISMATCH\n" << name << ": cached " << cached << ", current " << value << std::endl;
+		return false;
+	}
+#endif
+}
+
+GlStateCache::GlStateCache() : stats() {
+	invalidate();
+}
+
+void GlStateCache::useProgram(unsigned int program) {
+	if (unchanged(program == this->program))
+		return;
+	glUseProgram(program);
+	this->program = program;
+}
+
+void GlStateCache::bindVertexArray(unsigned int vertexArray) {
+	if (unchanged(vertexArray == this->vertexArray))
+		return;
+	glBindVertexArray(vertexArray);
+	this->vertexArray = vertexArray;
+	buffers[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+}
+
+void GlStateCache::bindBuffer(unsigned int target, unsigned int buffer) {
+	int slot = findSlot(bufferTargets, BUFFER_SLOT_COUNT, target);
+	if (slot >= 0 && unchanged(buffers[slot] == buffer))
+		return;
+	glBindBuffer(target, buffer);
+	if (slot >= 0)
+		buffers[slot] = buffer;
+	else
+		stats.issued++;
+}
+
+void GlStateCache::bindTexture(unsigned int unit, unsigned int target, unsigned int texture) {
+	int slot = unit < TEXTURE_UNIT_COUNT ? findSlot(textureTargets, TEXTURE_SLOT_COUNT, target) : -1;
+	if (slot >= 0 && unchanged(textures[unit][slot] == texture))
+		return;
+	setActiveUnit(unit);
+	glBindTexture(target, texture);
+	if (slot >= 0)
+		textures[unit][slot] = texture;
+	else
+		stats.issued++;
+}
+
+void GlStateCache::bindSampler(unsigned int unit, unsigned int sampler) {
+	if (unit < TEXTURE_UNIT_COUNT) {
+		if (unchanged(samplers[unit] == sampler))
+			return;
+		samplers[unit] = sampler;
+	}
+	else {
+		stats.issued++;
+	}
+	glBindSampler(unit, sampler);
+}
+
+void GlStateCache::setBlend(bool enabled) {
+	setCapability(blend, GL_BLEND, enabled);
+}
+
+void GlStateCache::setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor) {
+	if (unchanged(sourceFactor == blendSource && destinationFactor == blendDestination))
+		return;
+	glBlendFunc(sourceFactor, destinationFactor);
+	blendSource = sourceFactor;
+	blendDestination = destinationFactor;
+}
+
+void GlStateCache::setDepthTest(bool enabled) {
+	setCapability(depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void GlStateCache::setDepthWrite(bool enabled) {
+	if (unchanged(depthWrite == (enabled ? FLAG_ON : FLAG_OFF)))
+		return;
+	glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	depthWrite = enabled ? FLAG_ON : FLAG_OFF;
+}
+
+void GlStateCache::setDepthFunc(unsigned int function) {
+	if (unchanged(function == depthFunc))
+		return;
+	glDepthFunc(function);
+	depthFunc = function;
+}
+
+void GlStateCache::setViewport(int x, int y, int width, int height) {
+	if (unchanged(viewportKnown && x == viewport[0] && y == viewport[1] && width == viewport[2] && height == viewport[3]))
+		return;
+	glViewport(x, y, width, height);
+	viewport[0] = x;
+	viewport[1] = y;
+	viewport[2] = width;
+	viewport[3] = height;
+	viewportKnown = true;
+}
+
+void GlStateCache::invalidate() {
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	for (unsigned int &buffer : buffers)
+		buffer = UNKNOWN;
+	activeUnit = UNKNOWN;
+	for (unsigned int unit = 0; unit < TEXTURE_UNIT_COUNT; unit++) {
+		for (unsigned int &texture : textures[unit])
+			texture = UNKNOWN;
+		samplers[unit] = UNKNOWN;
+	}
+	blend = depthTest = depthWrite = FLAG_UNKNOWN;
+	blendSource = blendDestination = UNKNOWN;
+	depthFunc = UNKNOWN;
+	viewportKnown = false;
+}
+
+void GlStateCache::resetStats() {
+	stats = {};
+}
+
+#ifndef NDEBUG
+bool GlStateCache::verify() const {
+	const char *bufferNames[BUFFER_SLOT_COUNT] = {
+		"array buffer", "element array buffer", "uniform buffer", "shader storage buffer", "draw indirect buffer",
+		"pixel pack buffer", "pixel unpack buffer", "texture buffer"
+	};
+	const char *textureNames[TEXTURE_SLOT_COUNT] = { "texture 2D", "texture 2D array", "texture cube map", "texture buffer" };
+
+	bool valid = check("program", program, GL_CURRENT_PROGRAM);
+	valid &= check("vertex array", vertexArray, GL_VERTEX_ARRAY_BINDING);
+	for (int slot = 0; slot < BUFFER_SLOT_COUNT; slot++)
+		valid &= check(bufferNames[slot], buffers[slot], bufferBindingQueries[slot]);
+
+	// Texture and sampler bindings can only be read from the active unit.
+	GLint originalUnit = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &originalUnit);
+	valid &= check("active texture", activeUnit == UNKNOWN ? UNKNOWN : GL_TEXTURE0 + activeUnit, GL_ACTIVE_TEXTURE);
+	for (unsigned int unit = 0; unit < TEXTURE_UNIT_COUNT; unit++) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		for (int slot = 0; slot < TEXTURE_SLOT_COUNT; slot++)
+			valid &= check(textureNames[slot], textures[unit][slot], textureBindingQueries[slot]);
+		valid &= check("sampler", samplers[unit], GL_SAMPLER_BINDING);
+	}
+	glActiveTexture(originalUnit);
+
+	valid &= check("blend", blend == FLAG_UNKNOWN ? UNKNOWN : blend, GL_BLEND);
+	valid &= check("blend source", blendSource, GL_BLEND_SRC_RGB);
+	valid &= check("blend destination", blendDestination, GL_BLEND_DST_RGB);
+	valid &= check("depth test", depthTest == FLAG_UNKNOWN ? UNKNOWN : depthTest, GL_DEPTH_TEST);
+	valid &= check("depth write", depthWrite == FLAG_UNKNOWN ? UNKNOWN : depthWrite, GL_DEPTH_WRITEMASK);
+	valid &= check("depth function", depthFunc, GL_DEPTH_FUNC);
+	if (viewportKnown) {
+		GLint current[4];
+		glGetIntegerv(GL_VIEWPORT, current);
+		if (current[0] != viewport[0] || current[1] != viewport[1] || current[2] != viewport[2] || current[3] != viewport[3]) {
+			DEBUG_OUT << "ERROR::GL_STATE_CACHE::MISMATCH\n" << "viewport: cached " << viewport[0] << " " << viewport[1] << " "
+				<< viewport[2] << " " << viewport[3] << ", current " << current[0] << " " << current[1] << " "
+				<< current[2] << " " << current[3] << std::endl;
+			valid = false;
+		}
+	}
+
+	return valid;
+}
+#endif
+
+void GlStateCache::setActiveUnit(unsigned int unit) {
+	if (unchanged(unit == activeUnit))
+		return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	activeUnit = unit;
+}
+
+void GlStateCache::setCapability(int &flag, unsigned int capability, bool enabled) {
+	if (unchanged(flag == (enabled ? FLAG_ON : FLAG_OFF)))
+		return;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	flag = enabled ? FLAG_ON : FLAG_OFF;
+}
+
+bool GlStateCache::unchanged(bool same) {
+	if (same)
+		stats.skipped++;
+	else
+		stats.issued++;
+	return same;
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+struct GlStateStats {
+	unsigned int issued; // State calls that reached GL.
+	unsigned int skipped; // Redundant calls dropped because the state was already current.
+};
+
+// Shadow copy of the GL state the render loops change most: program, vertex array, buffer, texture and
+// sampler bindings, blend, depth and viewport. Setters compare against the shadow copy and only call GL
+// on a change. State starts out unknown, so the first call always goes through, and code that changes GL
+// state behind the cache's back must be followed by invalidate().
+// The element array binding belongs to the vertex array, binding another vertex array forgets it.
+class GlStateCache {
+public:
+	static const unsigned int TEXTURE_UNIT_COUNT = 32; // Units past this are passed through uncached.
+
+	GlStateStats stats;
+
+	GlStateCache();
+
+	void useProgram(unsigned int program);
+	void bindVertexArray(unsigned int vertexArray);
+	// Array, element array, uniform, shader storage, draw indirect, pixel pack and unpack, and texture buffer
+	// targets are cached. Indexed bindings (glBindBufferBase) are not.
+	void bindBuffer(unsigned int target, unsigned int buffer);
+	// 2D, 2D array, cube map and buffer textures are cached. Changes the active unit.
+	void bindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+	void bindSampler(unsigned int unit, unsigned int sampler);
+	void setBlend(bool enabled);
+	void setBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor);
+	void setDepthTest(bool enabled);
+	void setDepthWrite(bool enabled);
+	void setDepthFunc(unsigned int function);
+	void setViewport(int x, int y, int width, int height);
+
+	// Mark all state unknown.
+	void invalidate();
+	// Start counting a new frame.
+	void resetStats();
+#ifndef NDEBUG
+	// Compare every known value with glGet, reports mismatches and returns false if there were any.
+	// Leaves the active texture unit as the cache believes it to be.
+	bool verify() const;
+#endif
+
+private:
+	enum BufferSlot { BUFFER_ARRAY, BUFFER_ELEMENT_ARRAY, BUFFER_UNIFORM, BUFFER_SHADER_STORAGE, BUFFER_DRAW_INDIRECT,
+		BUFFER_PIXEL_PACK, BUFFER_PIXEL_UNPACK, BUFFER_TEXTURE, BUFFER_SLOT_COUNT };
+	enum TextureSlot { TEXTURE_2D, TEXTURE_2D_ARRAY, TEXTURE_CUBE_MAP, TEXTURE_BUFFER, TEXTURE_SLOT_COUNT };
+	enum Flag { FLAG_UNKNOWN = -1, FLAG_OFF = 0, FLAG_ON = 1 };
+
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int buffers[BUFFER_SLOT_COUNT];
+	unsigned int activeUnit;
+	unsigned int textures[TEXTURE_UNIT_COUNT][TEXTURE_SLOT_COUNT];
+	unsigned int samplers[TEXTURE_UNIT_COUNT];
+	int blend, depthTest, depthWrite;
+	unsigned int blendSource, blendDestination;
+	unsigned int depthFunc;
+	int viewport[4];
+	bool viewportKnown;
+
+	void setActiveUnit(unsigned int unit);
+	void setCapability(int &flag, unsigned int capability, bool enabled);
+	bool unchanged(bool same);
+};
+#endif
\ No newline at end of file
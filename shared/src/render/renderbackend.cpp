@@ -0,0 +1,88 @@
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "renderbackend.hpp"
+
+RenderBackend::RenderBackend(GlStateCache &state, const char *transformUniform) : stats(), state(state), transformUniform(transformUniform) {}
+
+unsigned int RenderBackend::addPass(const RenderPassState &state) {
+	passes.push_back(state);
+	return static_cast<unsigned int>(passes.size() - 1);
+}
+
+unsigned int RenderBackend::addProgram(Shader *shader) {
+	programs.push_back({ shader, shader->getUniformLocation(transformUniform) });
+	return static_cast<unsigned int>(programs.size() - 1);
+}
+
+unsigned int RenderBackend::addTextureSet(const std::vector<unsigned int> &textureIds) {
+	textureSets.push_back(textureIds);
+	return static_cast<unsigned int>(textureSets.size() - 1);
+}
+
+unsigned int RenderBackend::addVertexArray(unsigned int vertexArray) {
+	vertexArrays.push_back(vertexArray);
+	return static_cast<unsigned int>(vertexArrays.size() - 1);
+}
+
+void RenderBackend::execute(const RenderQueue &queue) {
+	stats = {};
+	bool first = true;
+	unsigned int currentPass = 0, currentProgram = 0, currentTextureSet = 0, currentVertexArray = 0;
+	for (const RenderQueue::Entry &entry : queue.entryList()) {
+		uint64_t key = entry.key;
+		unsigned int pass = sortKeyPass(key);
+		unsigned int program = sortKeyProgram(key);
+		unsigned int textureSet = sortKeyTextureSet(key);
+		unsigned int vertexArray = sortKeyVertexArray(key);
+		if (pass >= passes.size() || program >= programs.size() || textureSet >= textureSets.size() || vertexArray >= vertexArrays.size()) {
+#ifndef NDEBUG
+			DEBUG_OUT << "ERROR::RENDER_BACKEND::INVALID_HANDLE\n" << "Command " << entry.command << " skipped" << std::endl;
+#endif
+			continue;
+		}
+
+		if (first || pass != currentPass) {
+			const RenderPassState &passState = passes[pass];
+			state.setDepthTest(passState.depthTest);
+			state.setDepthWrite(passState.depthWrite);
+			state.setBlend(passState.blend);
+			if (passState.blend)
+				state.setBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			currentPass = pass;
+			stats.passChanges++;
+		}
+		if (first || program != currentProgram) {
+			state.useProgram(programs[program].shader->getProgram());
+			currentProgram = program;
+			stats.programChanges++;
+		}
+		if (first || textureSet != currentTextureSet) {
+			const std::vector<unsigned int> &textures = textureSets[textureSet];
+			for (unsigned int unit = 0; unit < textures.size(); unit++)
+				state.bindTexture(unit, GL_TEXTURE_2D, textures[unit]);
+			currentTextureSet = textureSet;
+			stats.textureSetChanges++;
+		}
+		if (first || vertexArray != currentVertexArray) {
+			state.bindVertexArray(vertexArrays[vertexArray]);
+			currentVertexArray = vertexArray;
+			stats.vertexArrayChanges++;
+		}
+		first = false;
+
+		const DrawCommand &command = queue.command(entry);
+		int transformLocation = programs[program].transformLocation;
+		if (transformLocation >= 0)
+			glUniformMatrix4fv(transformLocation, 1, GL_FALSE, &queue.transform(command.transform)[0][0]);
+		const void *indexOffset = reinterpret_cast<const void *>(static_cast<size_t>(command.firstIndex) * sizeof(unsigned int));
+		if (command.instanceCount > 1)
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.indexCount), GL_UNSIGNED_INT, indexOffset,
+				static_cast<GLsizei>(command.instanceCount), command.baseVertex);
+		else
+			glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.indexCount), GL_UNSIGNED_INT, indexOffset, command.baseVertex);
+		stats.draws++;
+	}
+}
\ No newline at end of file
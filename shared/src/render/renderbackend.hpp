@@ -0,0 +1,50 @@
+#pragma once
+#ifndef RENDER_BACKEND_H
+#define RENDER_BACKEND_H
+
+#include <vector>
+
+#include "shader/shader.hpp"
+#include "render/renderqueue.hpp"
+#include "render/glstatecache.hpp"
+
+// Fixed function state of a pass.
+struct RenderPassState {
+	bool depthTest;
+	bool depthWrite;
+	bool blend; // Premultiplied alpha, GL_ONE and GL_ONE_MINUS_SRC_ALPHA.
+};
+
+// Executes a sorted RenderQueue. Key fields are handles into the tables below, and only the fields that
+// differ from the previous command are applied, through the state cache so state left current by the last
+// frame or other code is not set again. Texture sets bind 2D textures to units 0 - n. Each program's
+// transform uniform is set per draw from the command. Programs, passes and vertex arrays are not owned.
+class RenderBackend {
+public:
+	RenderStateStats stats; // Of the last execute.
+
+	// Name of the mat4 uniform each program reads its command's transform from.
+	RenderBackend(GlStateCache &state, const char *transformUniform = "model");
+
+	unsigned int addPass(const RenderPassState &state);
+	unsigned int addProgram(Shader *shader);
+	unsigned int addTextureSet(const std::vector<unsigned int> &textureIds);
+	unsigned int addVertexArray(unsigned int vertexArray);
+
+	// Per frame uniforms are the caller's, set them on every program before executing.
+	void execute(const RenderQueue &queue);
+
+private:
+	struct Program {
+		Shader *shader;
+		int transformLocation;
+	};
+
+	GlStateCache &state;
+	const char *transformUniform;
+	std::vector<RenderPassState> passes;
+	std::vector<Program> programs;
+	std::vector<std::vector<unsigned int>> textureSets;
+	std::vector<unsigned int> vertexArrays;
+};
+#endif
\ No newline at end of file
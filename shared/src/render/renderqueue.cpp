@@ -0,0 +1,148 @@
+#include <algorithm>
+
+#include "renderqueue.hpp"
+
+namespace {
+	const unsigned int DEPTH_SHIFT = 0;
+	const unsigned int VERTEX_ARRAY_SHIFT = DEPTH_SHIFT + SORT_KEY_DEPTH_BITS;
+	const unsigned int TEXTURE_SET_SHIFT = VERTEX_ARRAY_SHIFT + SORT_KEY_VERTEX_ARRAY_BITS;
+	const unsigned int PROGRAM_SHIFT = TEXTURE_SET_SHIFT + SORT_KEY_TEXTURE_SET_BITS;
+	const unsigned int PASS_SHIFT = PROGRAM_SHIFT + SORT_KEY_PROGRAM_BITS;
+
+	uint64_t field(unsigned int value, unsigned int bits, unsigned int shift) {
+		return (static_cast<uint64_t>(value) & ((uint64_t(1) << bits) - 1)) << shift;
+	}
+
+	unsigned int extract(uint64_t key, unsigned int bits, unsigned int shift) {
+		return static_cast<unsigned int>((key >> shift) & ((uint64_t(1) << bits) - 1));
+	}
+}
+
+uint64_t makeSortKey(unsigned int pass, unsigned int program, unsigned int textureSet, unsigned int vertexArray, float depth) {
+	const float depthRange = static_cast<float>((1u << SORT_KEY_DEPTH_BITS) - 1);
+	// Negated comparison so NaN clamps to 0 as well.
+	float clamped = !(depth > 0.0f) ? 0.0f : std::min(depth, 1.0f);
+	unsigned int quantizedDepth = static_cast<unsigned int>(clamped * depthRange);
+
+	return field(pass, SORT_KEY_PASS_BITS, PASS_SHIFT)
+		| field(program, SORT_KEY_PROGRAM_BITS, PROGRAM_SHIFT)
+		| field(textureSet, SORT_KEY_TEXTURE_SET_BITS, TEXTURE_SET_SHIFT)
+		| field(vertexArray, SORT_KEY_VERTEX_ARRAY_BITS, VERTEX_ARRAY_SHIFT)
+		| field(quantizedDepth, SORT_KEY_DEPTH_BITS, DEPTH_SHIFT);
+}
+
+unsigned int sortKeyPass(uint64_t key) {
+	return extract(key, SORT_KEY_PASS_BITS, PASS_SHIFT);
+}
+
+unsigned int sortKeyProgram(uint64_t key) {
+	return extract(key, SORT_KEY_PROGRAM_BITS, PROGRAM_SHIFT);
+}
+
+unsigned int sortKeyTextureSet(uint64_t key) {
+	return extract(key, SORT_KEY_TEXTURE_SET_BITS, TEXTURE_SET_SHIFT);
+}
+
+unsigned int sortKeyVertexArray(uint64_t key) {
+	return extract(key, SORT_KEY_VERTEX_ARRAY_BITS, VERTEX_ARRAY_SHIFT);
+}
+
+void RenderQueue::clear() {
+	entries.clear();
+	commands.clear();
+	transforms.clear();
+}
+
+unsigned int RenderQueue::addTransform(const glm::mat4 &transform) {
+	transforms.push_back(transform);
+	return static_cast<unsigned int>(transforms.size() - 1);
+}
+
+void RenderQueue::submit(uint64_t key, const DrawCommand &command) {
+	entries.push_back({ key, static_cast<unsigned int>(commands.size()) });
+	commands.push_back(command);
+}
+
+void RenderQueue::resize(size_t commandCount, size_t transformCount) {
+	entries.resize(commandCount);
+	commands.resize(commandCount);
+	transforms.resize(transformCount);
+}
+
+void RenderQueue::setTransform(unsigned int index, const glm::mat4 &transform) {
+	transforms[index] = transform;
+}
+
+void RenderQueue::setCommand(size_t index, uint64_t key, const DrawCommand &command) {
+	entries[index] = { key, static_cast<unsigned int>(index) };
+	commands[index] = command;
+}
+
+void RenderQueue::sort() {
+	size_t count = entries.size();
+	if (count < 2)
+		return;
+
+	// Histograms of all eight bytes in one pass over the keys.
+	static const unsigned int RADIX = 256, DIGITS = 8;
+	size_t histograms[DIGITS][RADIX] = {};
+	for (const Entry &entry : entries) {
+		uint64_t key = entry.key;
+		for (unsigned int digit = 0; digit < DIGITS; digit++)
+			histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+	}
+
+	scratch.resize(count);
+	for (unsigned int digit = 0; digit < DIGITS; digit++) {
+		size_t *histogram = histograms[digit];
+		// All keys share this byte, the pass would copy entries unchanged.
+		if (histogram[(entries[0].key >> (digit * 8)) & 0xFF] == count)
+			continue;
+
+		// Exclusive prefix sum turns counts into output offsets.
+		size_t offset = 0;
+		for (unsigned int bucket = 0; bucket < RADIX; bucket++) {
+			size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (const Entry &entry : entries)
+			scratch[histogram[(entry.key >> (digit * 8)) & 0xFF]++] = entry;
+		entries.swap(scratch);
+	}
+}
+
+size_t RenderQueue::size() const {
+	return entries.size();
+}
+
+const std::vector<RenderQueue::Entry> &RenderQueue::entryList() const {
+	return entries;
+}
+
+const DrawCommand &RenderQueue::command(const Entry &entry) const {
+	return commands[entry.command];
+}
+
+const glm::mat4 &RenderQueue::transform(unsigned int index) const {
+	return transforms[index];
+}
+
+RenderStateStats countStateChanges(const RenderQueue &queue) {
+	RenderStateStats stats = {};
+	bool first = true;
+	uint64_t previous = 0;
+	for (const RenderQueue::Entry &entry : queue.entryList()) {
+		uint64_t key = entry.key;
+		// Fields change independently, texture and vertex array bindings outlive a program change.
+		stats.passChanges += first || sortKeyPass(key) != sortKeyPass(previous);
+		stats.programChanges += first || sortKeyProgram(key) != sortKeyProgram(previous);
+		stats.textureSetChanges += first || sortKeyTextureSet(key) != sortKeyTextureSet(previous);
+		stats.vertexArrayChanges += first || sortKeyVertexArray(key) != sortKeyVertexArray(previous);
+		stats.draws++;
+		previous = key;
+		first = false;
+	}
+
+	return stats;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Sort key fields from most to least significant. Sorting by key groups draws by pass, then program,
+// then texture set, then vertex array, so the most expensive state changes happen least often.
+// Depth comes last and only orders draws that share all state.
+const unsigned int SORT_KEY_PASS_BITS = 4;
+const unsigned int SORT_KEY_PROGRAM_BITS = 10;
+const unsigned int SORT_KEY_TEXTURE_SET_BITS = 12;
+const unsigned int SORT_KEY_VERTEX_ARRAY_BITS = 10;
+const unsigned int SORT_KEY_DEPTH_BITS = 28;
+
+// Handles index the backend's resource tables and are masked to their field width.
+// Depth is clamped to 0 - 1, pass 1 - depth for back to front order in blended passes.
+uint64_t makeSortKey(unsigned int pass, unsigned int program, unsigned int textureSet, unsigned int vertexArray, float depth);
+unsigned int sortKeyPass(uint64_t key);
+unsigned int sortKeyProgram(uint64_t key);
+unsigned int sortKeyTextureSet(uint64_t key);
+unsigned int sortKeyVertexArray(uint64_t key);
+
+// Payload of an indexed draw, everything else it needs is in its key.
+struct DrawCommand {
+	unsigned int indexCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int instanceCount;
+	unsigned int transform; // Index into the queue's transforms.
+};
+
+struct RenderStateStats {
+	unsigned int passChanges;
+	unsigned int programChanges;
+	unsigned int textureSetChanges;
+	unsigned int vertexArrayChanges;
+	unsigned int draws;
+};
+
+// Per frame list of draw commands. Commands are submitted in any order, sorted once by key and then
+// executed in that order. Sorting moves 16 byte key and index pairs, never the payloads.
+class RenderQueue {
+public:
+	struct Entry {
+		uint64_t key;
+		unsigned int command;
+	};
+
+	void clear();
+	// Returns the transform index for commands.
+	unsigned int addTransform(const glm::mat4 &transform);
+	void submit(uint64_t key, const DrawCommand &command);
+	// Fill by index instead of appending, so several threads can write disjoint ranges.
+	// Replaces the queue's contents with commandCount commands and transformCount transforms to be set.
+	void resize(size_t commandCount, size_t transformCount);
+	void setTransform(unsigned int index, const glm::mat4 &transform);
+	void setCommand(size_t index, uint64_t key, const DrawCommand &command);
+	// Stable least significant digit radix sort, 8 bits per pass. Passes over bytes every key shares are skipped.
+	void sort();
+
+	size_t size() const;
+	const std::vector<Entry> &entryList() const;
+	const DrawCommand &command(const Entry &entry) const;
+	const glm::mat4 &transform(unsigned int index) const;
+
+private:
+	std::vector<Entry> entries;
+	std::vector<Entry> scratch;
+	std::vector<DrawCommand> commands;
+	std::vector<glm::mat4> transforms;
+};
+
+// State changes executing the queue in its current order would cost, counted the way the backend applies them.
+RenderStateStats countStateChanges(const RenderQueue &queue);
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <glad/glad.h>
+
+#include "sampler.hpp"
+
+uint64_t SamplerState::key() const {
+	return static_cast<uint64_t>(minFilter & 0xFFFF)
+		| static_cast<uint64_t>(magFilter & 0xFFFF) << 16
+		| static_cast<uint64_t>(wrapS & 0xFFFF) << 32
+		| static_cast<uint64_t>(wrapT & 0xFFFF) << 48;
+}
+
+SamplerCache::SamplerCache() {}
+
+SamplerCache::~SamplerCache() {
+	clear();
+}
+
+unsigned int SamplerCache::get(const SamplerState &state) {
+	uint64_t key = state.key();
+	auto it = samplers.find(key);
+	if (it != samplers.end())
+		return it->second;
+
+	// First request for this state, create and configure a new sampler.
+	unsigned int sampler;
+	glGenSamplers(1, &sampler);
+	glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, state.minFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, state.magFilter);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, state.wrapS);
+	glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, state.wrapT);
+	samplers.emplace(key, sampler);
+
+	return sampler;
+}
+
+void SamplerCache::bind(unsigned int unit, const SamplerState &state) {
+	glBindSampler(unit, get(state));
+}
+
+size_t SamplerCache::size() const {
+	return samplers.size();
+}
+
+void SamplerCache::clear() {
+	for (auto &entry : samplers)
+		glDeleteSamplers(1, &entry.second);
+	samplers.clear();
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Filter and wrap state shared by every texture sampled the same way.
+struct SamplerState {
+	unsigned int minFilter;
+	unsigned int magFilter;
+	unsigned int wrapS;
+	unsigned int wrapT;
+
+	// GL enums used here all fit in 16 bits.
+	uint64_t key() const;
+};
+
+// Interns sampler objects so textures with identical sampling state share one sampler.
+class SamplerCache {
+public:
+	SamplerCache();
+	~SamplerCache();
+	SamplerCache(const SamplerCache &) = delete;
+	SamplerCache &operator=(const SamplerCache &) = delete;
+
+	unsigned int get(const SamplerState &state);
+	void bind(unsigned int unit, const SamplerState &state);
+	size_t size() const;
+	void clear();
+
+private:
+	std::unordered_map<uint64_t, unsigned int> samplers;
+};
+#endif
\ No newline at end of file
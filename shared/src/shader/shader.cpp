@@ -1,11 +1,12 @@
 #include <fstream>
 #include <sstream>
-#include <glad\glad.h>
+#include <glad/glad.h>
 #ifndef NDEBUG
 #include <debugout.hpp>
 #endif
 
 #include "shader.hpp"
+#include "profile/profiler.hpp"
 
 Shader::Shader() : program(glCreateProgram()) {}
 
@@ -13,6 +14,10 @@ Shader::Shader(const char *vertexShaderPath, const char *fragmentShaderPath) : S
 	compileProgram(vertexShaderPath, fragmentShaderPath);
 }
 
+Shader::Shader(const char *computeShaderPath) : Shader() {
+	compileComputeProgram(computeShaderPath);
+}
+
 Shader::~Shader() {
 	glDeleteProgram(program);
 }
@@ -21,7 +26,12 @@ void Shader::useProgram() {
 	glUseProgram(program);
 }
 
+unsigned int Shader::getProgram() const {
+	return program;
+}
+
 void Shader::compileProgram(const char *vertexShaderPath, const char *fragmentShaderPath) {
+	PROFILE_SCOPE("Shader::compileProgram");
 	std::string vertexShaderSource = getShaderSource(vertexShaderPath);
 	std::string fragmentShaderSource = getShaderSource(fragmentShaderPath);
 	const char *vertexShaderCode = vertexShaderSource.c_str();
@@ -41,6 +51,22 @@ void Shader::compileProgram(const char *vertexShaderPath, const char *fragmentSh
 	glDeleteShader(fragmentShader);
 }
 
+void Shader::compileComputeProgram(const char *computeShaderPath) {
+	PROFILE_SCOPE("Shader::compileComputeProgram");
+	std::string computeShaderSource = getShaderSource(computeShaderPath);
+	const char *computeShaderCode = computeShaderSource.c_str();
+
+	// Compile and link shader.
+	unsigned int computeShader = glCreateShader(GL_COMPUTE_SHADER);
+	compileShader(computeShader, "COMPUTE", computeShaderCode);
+	glLinkProgram(program);
+#ifndef NDEBUG
+	checkCompileErrors(program, "PROGRAM");
+#endif
+
+	glDeleteShader(computeShader);
+}
+
 void Shader::setBool(const std::string &name, bool value) const {
 	glUniform1i(glGetUniformLocation(program, name.c_str()), (int)value);
 }
@@ -89,6 +115,10 @@ void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
 	glUniformMatrix4fv(glGetUniformLocation(program, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
+int Shader::getUniformLocation(const std::string &name) const {
+	return glGetUniformLocation(program, name.c_str());
+}
+
 void Shader::compileShader(unsigned int shader, std::string type, const char *shaderCode) {
 	glShaderSource(shader, 1, &shaderCode, NULL);
 	glCompileShader(shader);
@@ -9,10 +9,13 @@ class Shader {
 public:
 	Shader();
 	Shader(const char *vertexShaderPath, const char *fragmentShaderPath);
+	explicit Shader(const char *computeShaderPath); // Compute shaders need GL 4.3.
 	~Shader();
 
 	void useProgram();
+	unsigned int getProgram() const;
 	void compileProgram(const char *vertexShaderPath, const char *fragmentShaderPath);
+	void compileComputeProgram(const char *computeShaderPath);
 	// Uniform setters.
 	void setBool(const std::string &name, bool value) const;
 	void setInt(const std::string &name, int value) const;
@@ -26,6 +29,8 @@ public:
 	void setMat2(const std::string &name, const glm::mat2 &mat) const;
 	void setMat3(const std::string &name, const glm::mat3 &mat) const;
 	void setMat4(const std::string &name, const glm::mat4 &mat) const;
+	// -1 if the program has no active uniform by that name. Lets hot loops skip the name lookup.
+	int getUniformLocation(const std::string &name) const;
 
 private:
 	unsigned int program;
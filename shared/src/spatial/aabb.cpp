@@ -0,0 +1,31 @@
+#include <cmath>
+
+#include "aabb.hpp"
+
+Aabb transformAabb(const Aabb &box, const glm::mat4 &m) {
+	glm::vec3 center = (box.min + box.max) * 0.5f;
+	glm::vec3 extent = (box.max - box.min) * 0.5f;
+	glm::vec3 newCenter(m[3]);
+	glm::vec3 newExtent(0.0f);
+	for (int column = 0; column < 3; column++) {
+		glm::vec3 axis(m[column]);
+		newCenter += axis * center[column];
+		newExtent += glm::vec3(std::fabs(axis.x), std::fabs(axis.y), std::fabs(axis.z)) * extent[column];
+	}
+	return { newCenter - newExtent, newCenter + newExtent };
+}
+
+Aabb mergeAabb(const Aabb &a, const Aabb &b) {
+	return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+float aabbSurfaceArea(const Aabb &box) {
+	glm::vec3 size = box.max - box.min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool aabbOverlap(const Aabb &a, const Aabb &b) {
+	return a.min.x <= b.max.x && a.max.x >= b.min.x
+		&& a.min.y <= b.max.y && a.max.y >= b.min.y
+		&& a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
\ No newline at end of file
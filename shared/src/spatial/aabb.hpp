@@ -0,0 +1,18 @@
+#pragma once
+#ifndef AABB_H
+#define AABB_H
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box.
+struct Aabb {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// Box enclosing the given box after an affine transform, from the absolute values of the matrix.
+Aabb transformAabb(const Aabb &box, const glm::mat4 &m);
+Aabb mergeAabb(const Aabb &a, const Aabb &b);
+float aabbSurfaceArea(const Aabb &box);
+bool aabbOverlap(const Aabb &a, const Aabb &b);
+#endif
\ No newline at end of file
@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "bvh.hpp"
+#include "culling/frustum.hpp"
+
+namespace {
+	const unsigned int PARALLEL_MIN_OBJECTS = 16384; // Smaller subtrees build faster than a thread starts.
+	const unsigned int MAX_DEPTH = 60; // Deeper nodes become leaves, traversal stacks never overflow.
+	const unsigned int STACK_SIZE = MAX_DEPTH + 2;
+	const unsigned int ALL_PLANES = 0x3F;
+	const float TRAVERSAL_COST = 1.0f; // Relative to testing one object's bounds.
+	const float INFINITE_DISTANCE = std::numeric_limits<float>::infinity();
+
+	// Object bounds in the build, partitioned in place so every subtree owns a contiguous range.
+	struct BuildRef {
+		glm::vec3 min;
+		unsigned int object;
+		glm::vec3 max;
+		float padding;
+	};
+
+	struct Bin {
+		Aabb bounds;
+		unsigned int count;
+	};
+
+	struct Split {
+		int axis;
+		int bin; // Last bin on the left side.
+		unsigned int binCount;
+		Aabb leftBounds;
+		Aabb rightBounds;
+	};
+
+	Aabb emptyAabb() {
+		const float huge = std::numeric_limits<float>::max();
+		return { glm::vec3(huge), glm::vec3(-huge) };
+	}
+
+	// Local versions of the Aabb helpers, the split sweep calls them a few hundred times per node.
+	void grow(Aabb &box, const Aabb &other) {
+		box.min = glm::min(box.min, other.min);
+		box.max = glm::max(box.max, other.max);
+	}
+
+	float halfArea(const Aabb &box) {
+		glm::vec3 size = box.max - box.min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	// Centroids are kept doubled, min + max, which saves a multiply per object.
+	glm::vec3 doubledCentroid(const BuildRef &ref) {
+		return ref.min + ref.max;
+	}
+
+	struct Builder {
+		std::vector<BuildRef> &refs;
+
+		// Subtree over refs [first, first + count) appended to out. Interior offsets are relative to the
+		// start of out, leaf offsets index refs.
+		void build(size_t first, size_t count, const Aabb &bounds, const Aabb &centroidBounds,
+			std::vector<BvhNode> &out, unsigned int depth, unsigned int parallelDepth) {
+			size_t index = out.size();
+			out.push_back({ bounds.min, static_cast<unsigned int>(first), bounds.max, static_cast<unsigned int>(count) });
+			// Testing a handful of boxes stored together costs about as much as one more node visit.
+			if (count <= Bvh::MAX_LEAF_SIZE || depth >= MAX_DEPTH)
+				return;
+
+			Split split;
+			size_t leftCount;
+			Aabb leftCentroids = emptyAabb(), rightCentroids = emptyAabb();
+			if (findSplit(first, count, centroidBounds, split))
+				leftCount = partition(first, count, centroidBounds, split, leftCentroids, rightCentroids);
+			else {
+				// Centroids coincide, no plane separates them. Halve the range so leaves stay small.
+				leftCount = count / 2;
+				rangeBounds(first, leftCount, split.leftBounds, leftCentroids);
+				rangeBounds(first + leftCount, count - leftCount, split.rightBounds, rightCentroids);
+			}
+
+			out[index].count = 0;
+			size_t rightFirst = first + leftCount, rightCount = count - leftCount;
+			if (parallelDepth > 0 && count >= PARALLEL_MIN_OBJECTS) {
+				std::vector<BvhNode> leftNodes, rightNodes;
+				std::thread worker([&]() {
+					build(first, leftCount, split.leftBounds, leftCentroids, leftNodes, depth + 1, parallelDepth - 1);
+				});
+				build(rightFirst, rightCount, split.rightBounds, rightCentroids, rightNodes, depth + 1, parallelDepth - 1);
+				worker.join();
+				append(out, leftNodes);
+				out[index].offset = static_cast<unsigned int>(out.size());
+				append(out, rightNodes);
+			}
+			else {
+				build(first, leftCount, split.leftBounds, leftCentroids, out, depth + 1, 0);
+				out[index].offset = static_cast<unsigned int>(out.size());
+				build(rightFirst, rightCount, split.rightBounds, rightCentroids, out, depth + 1, 0);
+			}
+		}
+
+		// Bins centroids along the axis where they spread the most, then sweeps every bin boundary for the
+		// lowest surface area cost. Binning all three axes finds slightly better splits at three times the cost.
+		// False when no boundary separates the centroids.
+		bool findSplit(size_t first, size_t count, const Aabb &centroidBounds, Split &split) const {
+			glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+			int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+			if (extent[axis] <= 0.0f)
+				return false;
+
+			// Small nodes, most of the tree, get fewer bins. They rarely have more useful split planes.
+			const int binCount = static_cast<int>(std::min<size_t>(Bvh::BIN_COUNT, count));
+			const float origin = centroidBounds.min[axis];
+			const float scale = binCount * 0.99999f / extent[axis];
+			Bin bins[Bvh::BIN_COUNT];
+			for (int b = 0; b < binCount; b++)
+				bins[b] = { emptyAabb(), 0 };
+			for (size_t i = first; i < first + count; i++) {
+				const BuildRef &ref = refs[i];
+				Bin &bin = bins[static_cast<int>((ref.min[axis] + ref.max[axis] - origin) * scale)];
+				grow(bin.bounds, { ref.min, ref.max });
+				bin.count++;
+			}
+
+			// Right side areas and counts for each boundary, swept from the far end.
+			float rightArea[Bvh::BIN_COUNT];
+			unsigned int rightCount[Bvh::BIN_COUNT];
+			Aabb right = emptyAabb();
+			unsigned int rightTotal = 0;
+			for (int b = binCount - 1; b > 0; b--) {
+				grow(right, bins[b].bounds);
+				rightTotal += bins[b].count;
+				rightArea[b] = halfArea(right);
+				rightCount[b] = rightTotal;
+			}
+			float bestCost = INFINITE_DISTANCE;
+			Aabb left = emptyAabb();
+			unsigned int leftCount = 0;
+			for (int b = 0; b < binCount - 1; b++) {
+				grow(left, bins[b].bounds);
+				leftCount += bins[b].count;
+				if (leftCount == 0 || rightCount[b + 1] == 0)
+					continue;
+				float cost = halfArea(left) * leftCount + rightArea[b + 1] * rightCount[b + 1];
+				if (cost < bestCost) {
+					bestCost = cost;
+					split.bin = b;
+					split.leftBounds = left;
+				}
+			}
+			if (bestCost == INFINITE_DISTANCE)
+				return false;
+
+			split.axis = axis;
+			split.binCount = binCount;
+			split.rightBounds = emptyAabb();
+			for (int b = split.bin + 1; b < binCount; b++)
+				grow(split.rightBounds, bins[b].bounds);
+			return true;
+		}
+
+		// Moves left side objects to the front, returns their count. Child centroid bounds come out of the same pass.
+		size_t partition(size_t first, size_t count, const Aabb &centroidBounds, const Split &split,
+			Aabb &leftCentroids, Aabb &rightCentroids) {
+			int axis = split.axis;
+			float origin = centroidBounds.min[axis];
+			float scale = split.binCount * 0.99999f / (centroidBounds.max[axis] - centroidBounds.min[axis]);
+			size_t i = first, end = first + count;
+			while (i < end) {
+				glm::vec3 centroid = doubledCentroid(refs[i]);
+				if (static_cast<int>((centroid[axis] - origin) * scale) <= split.bin) {
+					leftCentroids.min = glm::min(leftCentroids.min, centroid);
+					leftCentroids.max = glm::max(leftCentroids.max, centroid);
+					i++;
+				}
+				else {
+					rightCentroids.min = glm::min(rightCentroids.min, centroid);
+					rightCentroids.max = glm::max(rightCentroids.max, centroid);
+					std::swap(refs[i], refs[--end]);
+				}
+			}
+			return i - first;
+		}
+
+		void rangeBounds(size_t first, size_t count, Aabb &bounds, Aabb &centroidBounds) const {
+			bounds = emptyAabb();
+			centroidBounds = emptyAabb();
+			for (size_t i = first; i < first + count; i++) {
+				glm::vec3 centroid = doubledCentroid(refs[i]);
+				bounds.min = glm::min(bounds.min, refs[i].min);
+				bounds.max = glm::max(bounds.max, refs[i].max);
+				centroidBounds.min = glm::min(centroidBounds.min, centroid);
+				centroidBounds.max = glm::max(centroidBounds.max, centroid);
+			}
+		}
+
+		// Splices a subtree built on another thread, its interior offsets shift by where it lands.
+		static void append(std::vector<BvhNode> &out, const std::vector<BvhNode> &subtree) {
+			unsigned int base = static_cast<unsigned int>(out.size());
+			for (BvhNode node : subtree) {
+				if (node.count == 0)
+					node.offset += base;
+				out.push_back(node);
+			}
+		}
+	};
+
+	// False when the box is outside one of the planes in mask. Planes the box is fully inside are
+	// cleared from mask, so children skip them.
+	bool intersectsFrustum(const glm::vec4 planes[6], const glm::vec3 &min, const glm::vec3 &max, unsigned int &mask) {
+		for (int p = 0; p < 6; p++) {
+			if (!(mask & (1u << p)))
+				continue;
+			const glm::vec4 &plane = planes[p];
+			// The corner furthest along the normal decides outside, the nearest decides fully inside.
+			float furthest = plane.w
+				+ plane.x * (plane.x > 0.0f ? max.x : min.x)
+				+ plane.y * (plane.y > 0.0f ? max.y : min.y)
+				+ plane.z * (plane.z > 0.0f ? max.z : min.z);
+			if (furthest < 0.0f)
+				return false;
+			float nearest = plane.w
+				+ plane.x * (plane.x > 0.0f ? min.x : max.x)
+				+ plane.y * (plane.y > 0.0f ? min.y : max.y)
+				+ plane.z * (plane.z > 0.0f ? min.z : max.z);
+			if (nearest >= 0.0f)
+				mask &= ~(1u << p);
+		}
+		return true;
+	}
+
+	// Slab test, entry distance clamped to the origin, infinite on a miss.
+	float rayBoxDistance(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &min, const glm::vec3 &max, float maxDistance) {
+		glm::vec3 t0 = (min - origin) * inverseDirection;
+		glm::vec3 t1 = (max - origin) * inverseDirection;
+		float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), std::max(std::min(t0.z, t1.z), 0.0f));
+		float tFar = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), std::min(std::max(t0.z, t1.z), maxDistance));
+		return tNear <= tFar ? tNear : INFINITE_DISTANCE;
+	}
+}
+
+Bvh::Bvh() {}
+
+void Bvh::build(const std::vector<Aabb> &bounds, unsigned int threadCount) {
+	nodes.clear();
+	objectIndices.clear();
+	objectBounds.clear();
+	if (bounds.empty())
+		return;
+
+	std::vector<BuildRef> refs(bounds.size());
+	Aabb rootBounds = emptyAabb(), centroidBounds = emptyAabb();
+	for (size_t i = 0; i < bounds.size(); i++) {
+		refs[i] = { bounds[i].min, static_cast<unsigned int>(i), bounds[i].max, 0.0f };
+		glm::vec3 centroid = doubledCentroid(refs[i]);
+		rootBounds = mergeAabb(rootBounds, bounds[i]);
+		centroidBounds.min = glm::min(centroidBounds.min, centroid);
+		centroidBounds.max = glm::max(centroidBounds.max, centroid);
+	}
+
+	// Each level near the root doubles the subtrees built at once.
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	unsigned int parallelDepth = 0;
+	while ((1u << parallelDepth) < threadCount)
+		parallelDepth++;
+
+	// Worst case is one leaf per object and as many interior nodes.
+	nodes.reserve(2 * bounds.size());
+	Builder builder = { refs };
+	builder.build(0, refs.size(), rootBounds, centroidBounds, nodes, 0, parallelDepth);
+	nodes.shrink_to_fit();
+
+	objectIndices.resize(refs.size());
+	objectBounds.resize(refs.size());
+	for (size_t i = 0; i < refs.size(); i++) {
+		objectIndices[i] = refs[i].object;
+		objectBounds[i] = { refs[i].min, refs[i].max };
+	}
+}
+
+void Bvh::refit(const std::vector<Aabb> &bounds) {
+	if (bounds.size() != objectIndices.size()) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::BVH::OBJECT_COUNT_MISMATCH\n" << bounds.size() << " objects, built with " << objectIndices.size() << std::endl;
+	#endif
+		return;
+	}
+
+	for (size_t i = 0; i < objectIndices.size(); i++)
+		objectBounds[i] = bounds[objectIndices[i]];
+	// Children always follow their parent, a reverse sweep visits them first.
+	for (size_t n = nodes.size(); n-- > 0; ) {
+		BvhNode &node = nodes[n];
+		Aabb box;
+		if (node.count) {
+			box = objectBounds[node.offset];
+			for (unsigned int i = 1; i < node.count; i++)
+				box = mergeAabb(box, objectBounds[node.offset + i]);
+		}
+		else {
+			const BvhNode &left = nodes[n + 1], &right = nodes[node.offset];
+			box = { glm::min(left.min, right.min), glm::max(left.max, right.max) };
+		}
+		node.min = box.min;
+		node.max = box.max;
+	}
+}
+
+void Bvh::queryFrustum(const glm::mat4 &viewProjection, std::vector<unsigned int> &objects) const {
+	collectFrustum(viewProjection, objects);
+}
+
+void Bvh::queryFrustum(const glm::mat4 &viewProjection, std::pmr::vector<unsigned int> &objects) const {
+	collectFrustum(viewProjection, objects);
+}
+
+template <typename ObjectList>
+void Bvh::collectFrustum(const glm::mat4 &viewProjection, ObjectList &objects) const {
+	if (nodes.empty())
+		return;
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+
+	struct Entry {
+		unsigned int node;
+		unsigned int mask;
+	};
+	Entry stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = { 0, ALL_PLANES };
+	while (top > 0) {
+		Entry entry = stack[--top];
+		const BvhNode &node = nodes[entry.node];
+		unsigned int mask = entry.mask;
+		if (mask && !intersectsFrustum(planes, node.min, node.max, mask))
+			continue;
+
+		if (mask == 0) {
+			// Fully inside, the subtree's objects are one contiguous range from its leftmost to rightmost leaf.
+			unsigned int first = entry.node, last = entry.node;
+			while (nodes[first].count == 0)
+				first++;
+			while (nodes[last].count == 0)
+				last = nodes[last].offset;
+			for (unsigned int i = nodes[first].offset; i < nodes[last].offset + nodes[last].count; i++)
+				objects.push_back(objectIndices[i]);
+		}
+		else if (node.count) {
+			for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+				unsigned int objectMask = mask;
+				if (intersectsFrustum(planes, objectBounds[i].min, objectBounds[i].max, objectMask))
+					objects.push_back(objectIndices[i]);
+			}
+		}
+		else {
+			stack[top++] = { node.offset, mask };
+			stack[top++] = { entry.node + 1, mask };
+		}
+	}
+}
+
+void Bvh::queryBox(const Aabb &box, std::vector<unsigned int> &objects) const {
+	if (nodes.empty())
+		return;
+
+	unsigned int stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		unsigned int index = stack[--top];
+		const BvhNode &node = nodes[index];
+		if (!aabbOverlap(box, { node.min, node.max }))
+			continue;
+
+		if (node.count) {
+			for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+				if (aabbOverlap(box, objectBounds[i]))
+					objects.push_back(objectIndices[i]);
+			}
+		}
+		else {
+			stack[top++] = node.offset;
+			stack[top++] = index + 1;
+		}
+	}
+}
+
+bool Bvh::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BvhRayHit &hit) const {
+	if (nodes.empty())
+		return false;
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	struct Entry {
+		unsigned int node;
+		float distance;
+	};
+	Entry stack[STACK_SIZE];
+	size_t top = 0;
+	float closest = maxDistance;
+	bool found = false;
+	float rootDistance = rayBoxDistance(origin, inverseDirection, nodes[0].min, nodes[0].max, closest);
+	if (rootDistance != INFINITE_DISTANCE)
+		stack[top++] = { 0, rootDistance };
+	while (top > 0) {
+		Entry entry = stack[--top];
+		// Skip nodes that were entered beyond a hit found since they were pushed.
+		if (entry.distance > closest)
+			continue;
+		const BvhNode &node = nodes[entry.node];
+
+		if (node.count) {
+			for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+				float distance = rayBoxDistance(origin, inverseDirection, objectBounds[i].min, objectBounds[i].max, closest);
+				if (distance <= closest) {
+					closest = distance;
+					hit.object = objectIndices[i];
+					hit.distance = distance;
+					found = true;
+				}
+			}
+		}
+		else {
+			// Nearer child on top of the stack, so hits in it prune the other.
+			unsigned int left = entry.node + 1, right = node.offset;
+			float leftDistance = rayBoxDistance(origin, inverseDirection, nodes[left].min, nodes[left].max, closest);
+			float rightDistance = rayBoxDistance(origin, inverseDirection, nodes[right].min, nodes[right].max, closest);
+			if (leftDistance > rightDistance) {
+				std::swap(left, right);
+				std::swap(leftDistance, rightDistance);
+			}
+			if (rightDistance != INFINITE_DISTANCE)
+				stack[top++] = { right, rightDistance };
+			if (leftDistance != INFINITE_DISTANCE)
+				stack[top++] = { left, leftDistance };
+		}
+	}
+
+	return found;
+}
+
+size_t Bvh::objectCount() const {
+	return objectIndices.size();
+}
+
+const std::vector<BvhNode> &Bvh::nodeList() const {
+	return nodes;
+}
+
+float Bvh::sahCost() const {
+	if (nodes.empty())
+		return 0.0f;
+	float rootArea = aabbSurfaceArea({ nodes[0].min, nodes[0].max });
+	if (rootArea <= 0.0f)
+		return 1.0f;
+	double cost = 0.0;
+	for (const BvhNode &node : nodes) {
+		float area = aabbSurfaceArea({ node.min, node.max }) / rootArea;
+		cost += node.count ? area * node.count : area * TRAVERSAL_COST;
+	}
+	return static_cast<float>(cost);
+}
\ No newline at end of file
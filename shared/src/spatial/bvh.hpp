@@ -0,0 +1,64 @@
+#pragma once
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "spatial/aabb.hpp"
+
+// Flattened node, 32 bytes so two share a cache line. Nodes are stored depth first: the left child
+// of an interior node directly follows it, so parents always come before their children.
+struct BvhNode {
+	glm::vec3 min;
+	unsigned int offset; // Interior: index of the right child. Leaf: first object in leaf order.
+	glm::vec3 max;
+	unsigned int count; // Objects in a leaf, 0 for interior nodes.
+};
+
+struct BvhRayHit {
+	unsigned int object;
+	float distance; // Along the ray direction, in units of its length.
+};
+
+// Bounding volume hierarchy over object bounds for culling, picking and overlap queries.
+// Built top down with a binned surface area heuristic, subtrees go to worker threads near the root.
+// Moving objects are handled by refit, which keeps the topology and only grows or shrinks boxes.
+class Bvh {
+public:
+	static const unsigned int BIN_COUNT = 16;
+	static const unsigned int MAX_LEAF_SIZE = 4;
+
+	Bvh();
+
+	// threadCount 0 uses every hardware thread. Object ids in queries are indices into bounds.
+	void build(const std::vector<Aabb> &bounds, unsigned int threadCount = 0);
+	// Same object count as the last build, bounds may have changed arbitrarily. Query cost degrades
+	// as objects drift from where they were at build time.
+	void refit(const std::vector<Aabb> &bounds);
+
+	// Objects whose bounds intersect the frustum of the view projection matrix are appended to objects.
+	void queryFrustum(const glm::mat4 &viewProjection, std::vector<unsigned int> &objects) const;
+	// Same, for lists in a frame arena or any other memory resource.
+	void queryFrustum(const glm::mat4 &viewProjection, std::pmr::vector<unsigned int> &objects) const;
+	// Objects whose bounds overlap the box are appended to objects.
+	void queryBox(const Aabb &box, std::vector<unsigned int> &objects) const;
+	// Closest object bounds hit by the ray within maxDistance, false on a miss.
+	bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BvhRayHit &hit) const;
+
+	size_t objectCount() const;
+	const std::vector<BvhNode> &nodeList() const;
+	// Expected box tests for a random ray through the root under the surface area heuristic.
+	float sahCost() const;
+
+private:
+	std::vector<BvhNode> nodes;
+	std::vector<unsigned int> objectIndices; // Leaf order -> object id.
+	std::vector<Aabb> objectBounds; // In leaf order.
+
+	template <typename ObjectList>
+	void collectFrustum(const glm::mat4 &viewProjection, ObjectList &objects) const;
+};
+#endif
\ No newline at end of file
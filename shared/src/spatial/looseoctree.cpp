@@ -0,0 +1,364 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "looseoctree.hpp"
+#include "culling/frustum.hpp"
+
+namespace {
+	const unsigned int ROOT = 0;
+	const unsigned int ALL_PLANES = 0x3F;
+	const unsigned int MAX_DEPTH_LIMIT = 16;
+	// Each visited node pushes at most its eight children.
+	const unsigned int STACK_SIZE = 7 * MAX_DEPTH_LIMIT + 8;
+
+	// Signed distance of the plane to a box center and how far the box reaches along the plane normal.
+	bool outsidePlane(const glm::vec4 &plane, const glm::vec3 &center, float extent, float &distance, float &reach) {
+		distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		reach = extent * (std::fabs(plane.x) + std::fabs(plane.y) + std::fabs(plane.z));
+		return distance < -reach;
+	}
+
+	float boxDistanceSquared(const glm::vec3 &point, const glm::vec3 &center, float extent) {
+		glm::vec3 offset = glm::max(glm::abs(point - center) - glm::vec3(extent), glm::vec3(0.0f));
+		return glm::dot(offset, offset);
+	}
+
+	// Slab test against a cube, entry distance clamped to the origin, infinite on a miss.
+	float rayCubeDistance(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &center, float extent, float maxDistance) {
+		glm::vec3 t0 = (center - glm::vec3(extent) - origin) * inverseDirection;
+		glm::vec3 t1 = (center + glm::vec3(extent) - origin) * inverseDirection;
+		float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), std::max(std::min(t0.z, t1.z), 0.0f));
+		float tFar = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), std::min(std::max(t0.z, t1.z), maxDistance));
+		return tNear <= tFar ? tNear : std::numeric_limits<float>::infinity();
+	}
+}
+
+LooseOctree::LooseOctree(const glm::vec3 &center, float halfSize, unsigned int maxDepth)
+	: liveObjects(0), relocations(0), maxDepth(std::min(maxDepth, MAX_DEPTH_LIMIT)) {
+	Node root;
+	root.center = center;
+	root.halfSize = halfSize;
+	std::fill(root.children, root.children + 8, NO_INDEX);
+	root.parent = NO_INDEX;
+	root.depth = 0;
+	root.firstObject = NO_INDEX;
+	root.childCount = 0;
+	nodes.push_back(root);
+}
+
+unsigned int LooseOctree::insert(const glm::vec3 &center, float radius) {
+	unsigned int object;
+	if (!freeObjects.empty()) {
+		object = freeObjects.back();
+		freeObjects.pop_back();
+	}
+	else {
+		object = static_cast<unsigned int>(objectPool.size());
+		objectPool.push_back({});
+	}
+	objectPool[object].center = center;
+	objectPool[object].radius = radius;
+	link(object, findNode(center, radius));
+	liveObjects++;
+
+	return object;
+}
+
+void LooseOctree::move(unsigned int object, const glm::vec3 &center, float radius) {
+	if (object >= objectPool.size() || objectPool[object].node == NO_INDEX) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::LOOSE_OCTREE::INVALID_OBJECT\n" << "Object " << object << " is not in the tree" << std::endl;
+	#endif
+		return;
+	}
+
+	Object &entry = objectPool[object];
+	entry.center = center;
+	entry.radius = radius;
+	// Most moves stay inside the octant, the loose bounds still cover the sphere.
+	if (fitsNode(entry.node, center, radius))
+		return;
+
+	unlink(object);
+	link(object, findNode(center, radius));
+	relocations++;
+}
+
+void LooseOctree::remove(unsigned int object) {
+	if (object >= objectPool.size() || objectPool[object].node == NO_INDEX) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::LOOSE_OCTREE::INVALID_OBJECT\n" << "Object " << object << " is not in the tree" << std::endl;
+	#endif
+		return;
+	}
+
+	unlink(object);
+	objectPool[object].node = NO_INDEX;
+	freeObjects.push_back(object);
+	liveObjects--;
+}
+
+void LooseOctree::clear() {
+	nodes.resize(1);
+	std::fill(nodes[ROOT].children, nodes[ROOT].children + 8, NO_INDEX);
+	nodes[ROOT].firstObject = NO_INDEX;
+	nodes[ROOT].childCount = 0;
+	freeNodes.clear();
+	objectPool.clear();
+	freeObjects.clear();
+	liveObjects = 0;
+	relocations = 0;
+}
+
+void LooseOctree::queryFrustum(const glm::mat4 &viewProjection, std::vector<unsigned int> &objects) const {
+	glm::vec4 planes[6];
+	extractFrustumPlanes(viewProjection, planes);
+
+	struct Entry {
+		unsigned int node;
+		unsigned int mask;
+	};
+	Entry stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = { ROOT, ALL_PLANES };
+	while (top > 0) {
+		Entry entry = stack[--top];
+		const Node &node = nodes[entry.node];
+
+		for (unsigned int i = node.firstObject; i != NO_INDEX; i = objectPool[i].next) {
+			const Object &object = objectPool[i];
+			bool visible = true;
+			for (int p = 0; p < 6 && visible; p++) {
+				if (entry.mask & (1u << p))
+					visible = glm::dot(glm::vec3(planes[p]), object.center) + planes[p].w >= -object.radius;
+			}
+			if (visible)
+				objects.push_back(i);
+		}
+
+		for (unsigned int child : node.children) {
+			if (node.childCount == 0)
+				break;
+			if (child == NO_INDEX)
+				continue;
+			// Planes the loose bounds are fully inside are skipped for the whole subtree.
+			const Node &childNode = nodes[child];
+			unsigned int mask = entry.mask;
+			bool outside = false;
+			for (int p = 0; p < 6 && !outside; p++) {
+				if (!(mask & (1u << p)))
+					continue;
+				float distance, reach;
+				outside = outsidePlane(planes[p], childNode.center, 2.0f * childNode.halfSize, distance, reach);
+				if (distance >= reach)
+					mask &= ~(1u << p);
+			}
+			if (!outside)
+				stack[top++] = { child, mask };
+		}
+	}
+}
+
+void LooseOctree::querySphere(const glm::vec3 &center, float radius, std::vector<unsigned int> &objects) const {
+	unsigned int stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = ROOT;
+	while (top > 0) {
+		const Node &node = nodes[stack[--top]];
+		for (unsigned int i = node.firstObject; i != NO_INDEX; i = objectPool[i].next) {
+			const Object &object = objectPool[i];
+			glm::vec3 offset = object.center - center;
+			float reach = radius + object.radius;
+			if (glm::dot(offset, offset) <= reach * reach)
+				objects.push_back(i);
+		}
+
+		for (unsigned int child : node.children) {
+			if (child != NO_INDEX && boxDistanceSquared(center, nodes[child].center, 2.0f * nodes[child].halfSize) <= radius * radius)
+				stack[top++] = child;
+		}
+	}
+}
+
+bool LooseOctree::raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, OctreeRayHit &hit) const {
+	glm::vec3 inverseDirection = 1.0f / direction;
+	float directionLengthSquared = glm::dot(direction, direction);
+	float closest = maxDistance;
+	bool found = false;
+
+	struct Entry {
+		unsigned int node;
+		float distance;
+	};
+	Entry stack[STACK_SIZE];
+	size_t top = 0;
+	stack[top++] = { ROOT, 0.0f };
+	while (top > 0) {
+		Entry entry = stack[--top];
+		// Skip nodes that were entered beyond a hit found since they were pushed.
+		if (entry.distance > closest)
+			continue;
+		const Node &node = nodes[entry.node];
+		for (unsigned int i = node.firstObject; i != NO_INDEX; i = objectPool[i].next) {
+			// Solve |origin + t * direction - center| = radius for the first t.
+			const Object &object = objectPool[i];
+			glm::vec3 offset = origin - object.center;
+			float b = glm::dot(offset, direction);
+			float c = glm::dot(offset, offset) - object.radius * object.radius;
+			float distance;
+			if (c <= 0.0f)
+				distance = 0.0f;
+			else {
+				float discriminant = b * b - directionLengthSquared * c;
+				if (b > 0.0f || discriminant < 0.0f)
+					continue;
+				distance = (-b - std::sqrt(discriminant)) / directionLengthSquared;
+			}
+			if (distance <= closest) {
+				closest = distance;
+				hit.object = i;
+				hit.distance = distance;
+				found = true;
+			}
+		}
+
+		// Children hit by the ray, pushed far to near so the nearest is visited first and its hits prune the rest.
+		Entry children[8];
+		unsigned int childCount = 0;
+		for (unsigned int child : node.children) {
+			if (child == NO_INDEX)
+				continue;
+			float distance = rayCubeDistance(origin, inverseDirection, nodes[child].center, 2.0f * nodes[child].halfSize, closest);
+			if (distance <= closest) {
+				unsigned int slot = childCount++;
+				for (; slot > 0 && children[slot - 1].distance < distance; slot--)
+					children[slot] = children[slot - 1];
+				children[slot] = { child, distance };
+			}
+		}
+		for (unsigned int c = 0; c < childCount; c++)
+			stack[top++] = children[c];
+	}
+
+	return found;
+}
+
+size_t LooseOctree::objectCount() const {
+	return liveObjects;
+}
+
+size_t LooseOctree::nodeCount() const {
+	return nodes.size() - freeNodes.size();
+}
+
+size_t LooseOctree::takeRelocationCount() {
+	size_t count = relocations;
+	relocations = 0;
+	return count;
+}
+
+// Deepest node whose octant half size still covers the radius, along the path to the center.
+unsigned int LooseOctree::findNode(const glm::vec3 &center, float radius) {
+	const Node &root = nodes[ROOT];
+	glm::vec3 offset = glm::abs(center - root.center);
+	if (std::max(std::max(offset.x, offset.y), offset.z) > root.halfSize)
+		return ROOT;
+
+	unsigned int depth = maxDepth;
+	if (radius > 0.0f)
+		depth = static_cast<unsigned int>(std::clamp(std::floor(std::log2(root.halfSize / radius)), 0.0f, static_cast<float>(maxDepth)));
+
+	unsigned int node = ROOT;
+	for (unsigned int d = 0; d < depth; d++) {
+		const glm::vec3 &nodeCenter = nodes[node].center;
+		unsigned int octant = (center.x >= nodeCenter.x) | (center.y >= nodeCenter.y) << 1 | (center.z >= nodeCenter.z) << 2;
+		unsigned int child = nodes[node].children[octant];
+		node = child != NO_INDEX ? child : allocateNode(node, octant);
+	}
+
+	return node;
+}
+
+bool LooseOctree::fitsNode(unsigned int node, const glm::vec3 &center, float radius) const {
+	const Node &entry = nodes[node];
+	glm::vec3 offset = glm::abs(center - entry.center);
+	float distance = std::max(std::max(offset.x, offset.y), offset.z);
+	// The root keeps objects outside the region and those too large for any octant.
+	if (node == ROOT)
+		return distance > entry.halfSize || radius > entry.halfSize * 0.5f || maxDepth == 0;
+
+	// Too large for the node, or small enough that a deeper node is tighter.
+	if (radius > entry.halfSize || (entry.depth < maxDepth && radius <= entry.halfSize * 0.5f))
+		return false;
+	// Anywhere the sphere stays inside the loose bounds, not just the octant, so objects moving back
+	// and forth across an octant boundary are not relinked every frame.
+	return distance + radius <= 2.0f * entry.halfSize;
+}
+
+unsigned int LooseOctree::allocateNode(unsigned int parent, unsigned int octant) {
+	unsigned int index;
+	if (!freeNodes.empty()) {
+		index = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else {
+		index = static_cast<unsigned int>(nodes.size());
+		nodes.push_back({});
+	}
+
+	const Node &parentNode = nodes[parent];
+	Node &node = nodes[index];
+	float quarter = parentNode.halfSize * 0.5f;
+	node.center = parentNode.center + glm::vec3(
+		octant & 1 ? quarter : -quarter,
+		octant & 2 ? quarter : -quarter,
+		octant & 4 ? quarter : -quarter
+	);
+	node.halfSize = quarter;
+	std::fill(node.children, node.children + 8, NO_INDEX);
+	node.parent = parent;
+	node.depth = parentNode.depth + 1;
+	node.firstObject = NO_INDEX;
+	node.childCount = 0;
+	nodes[parent].children[octant] = index;
+	nodes[parent].childCount++;
+
+	return index;
+}
+
+void LooseOctree::link(unsigned int object, unsigned int node) {
+	Object &entry = objectPool[object];
+	entry.node = node;
+	entry.previous = NO_INDEX;
+	entry.next = nodes[node].firstObject;
+	if (entry.next != NO_INDEX)
+		objectPool[entry.next].previous = object;
+	nodes[node].firstObject = object;
+}
+
+void LooseOctree::unlink(unsigned int object) {
+	Object &entry = objectPool[object];
+	if (entry.previous != NO_INDEX)
+		objectPool[entry.previous].next = entry.next;
+	else
+		nodes[entry.node].firstObject = entry.next;
+	if (entry.next != NO_INDEX)
+		objectPool[entry.next].previous = entry.previous;
+
+	// Return nodes left without objects or children to the pool, up to the first one still in use.
+	unsigned int node = entry.node;
+	while (node != ROOT && nodes[node].firstObject == NO_INDEX && nodes[node].childCount == 0) {
+		Node &parent = nodes[nodes[node].parent];
+		for (unsigned int &child : parent.children) {
+			if (child == node)
+				child = NO_INDEX;
+		}
+		parent.childCount--;
+		freeNodes.push_back(node);
+		node = nodes[node].parent;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef LOOSE_OCTREE_H
+#define LOOSE_OCTREE_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct OctreeRayHit {
+	unsigned int object;
+	float distance; // Along the ray direction, in units of its length.
+};
+
+// Loose octree of bounding spheres over a fixed cubic region, for scenes where most objects move every frame.
+// Node bounds are twice their octant, so an object belongs to the node at the depth its radius selects whose
+// octant holds its center. That node is found without looking at other objects, and an object that stays
+// in its octant moves without touching the tree. Objects outside the region live in the root.
+// Nodes and objects come from pools with free lists, emptied leaves return to the pool.
+class LooseOctree {
+public:
+	static constexpr unsigned int NO_INDEX = ~0u;
+
+	// Octants at maxDepth are 1 / 2^maxDepth of the region across, it is capped at 16.
+	LooseOctree(const glm::vec3 &center, float halfSize, unsigned int maxDepth = 6);
+
+	// Returns the object's id, stable until it is removed. Ids of removed objects are reused.
+	unsigned int insert(const glm::vec3 &center, float radius);
+	void move(unsigned int object, const glm::vec3 &center, float radius);
+	void remove(unsigned int object);
+	void clear();
+
+	// Objects whose spheres intersect the frustum of the view projection matrix are appended to objects.
+	void queryFrustum(const glm::mat4 &viewProjection, std::vector<unsigned int> &objects) const;
+	// Objects whose spheres intersect the sphere are appended to objects.
+	void querySphere(const glm::vec3 &center, float radius, std::vector<unsigned int> &objects) const;
+	// Closest sphere hit by the ray within maxDistance, false on a miss.
+	bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, OctreeRayHit &hit) const;
+
+	size_t objectCount() const;
+	size_t nodeCount() const;
+	// Objects that changed node since the last call, a measure of how much moves cost.
+	size_t takeRelocationCount();
+
+private:
+	struct Node {
+		glm::vec3 center;
+		float halfSize; // Of the octant, loose bounds extend twice as far.
+		unsigned int children[8]; // NO_INDEX where absent.
+		unsigned int parent;
+		unsigned int depth;
+		unsigned int firstObject; // Doubly linked list through Object.
+		unsigned int childCount;
+	};
+
+	struct Object {
+		glm::vec3 center;
+		float radius;
+		unsigned int node; // NO_INDEX while on the free list.
+		unsigned int next;
+		unsigned int previous;
+	};
+
+	std::vector<Node> nodes;
+	std::vector<unsigned int> freeNodes;
+	std::vector<Object> objectPool;
+	std::vector<unsigned int> freeObjects;
+	size_t liveObjects;
+	size_t relocations;
+	unsigned int maxDepth;
+
+	unsigned int findNode(const glm::vec3 &center, float radius);
+	bool fitsNode(unsigned int node, const glm::vec3 &center, float radius) const;
+	unsigned int allocateNode(unsigned int parent, unsigned int octant);
+	void link(unsigned int object, unsigned int node);
+	void unlink(unsigned int object);
+};
+#endif
\ No newline at end of file
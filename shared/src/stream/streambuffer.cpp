@@ -0,0 +1,134 @@
+#include <glad/glad.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "streambuffer.hpp"
+
+namespace {
+	const GLuint64 FENCE_TIMEOUT = 1000000000; // 1 s in ns, per wait.
+
+	size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	void waitFence(void *&fence) {
+		if (!fence)
+			return;
+		GLsync sync = static_cast<GLsync>(fence);
+		// Flush on wait so the fence is guaranteed to signal.
+		while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(sync);
+		fence = nullptr;
+	}
+}
+
+StreamBuffer::StreamBuffer(size_t frameSize) : id(0), frameSize(alignUp(frameSize, ALIGNMENT)), waitCount(0),
+	mapped(nullptr), fences{}, frame(FRAME_COUNT - 1), frameOffset(0) {
+	create();
+}
+
+StreamBuffer::~StreamBuffer() {
+	destroy();
+}
+
+void StreamBuffer::create() {
+	size_t size = frameSize * FRAME_COUNT;
+	glGenBuffers(1, &id);
+	// Bound to GL_COPY_WRITE_BUFFER to avoid disturbing any target the caller uses.
+	glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+	if (persistent()) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		mapped = static_cast<unsigned char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+	#ifndef NDEBUG
+		if (!mapped)
+			DEBUG_OUT << "ERROR::STREAM_BUFFER::MAP_FAILED\n" << "Size " << size << std::endl;
+	#endif
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		staging.resize(size);
+		mapped = staging.data();
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::destroy() {
+	for (void *&fence : fences)
+		waitFence(fence);
+	if (persistent() && mapped) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	mapped = nullptr;
+	glDeleteBuffers(1, &id);
+	id = 0;
+}
+
+void StreamBuffer::reserve(size_t frameSize) {
+	frameSize = alignUp(frameSize, ALIGNMENT);
+	if (frameSize <= this->frameSize)
+		return;
+
+	// Allocations made this frame are lost, reserve before allocating.
+	destroy();
+	this->frameSize = frameSize;
+	frameOffset = 0;
+	create();
+}
+
+void StreamBuffer::beginFrame() {
+	frame = (frame + 1) % FRAME_COUNT;
+	frameOffset = 0;
+	if (fences[frame]) {
+		// The region is free if its fence signalled already, otherwise the GPU is FRAME_COUNT frames behind.
+		GLsync sync = static_cast<GLsync>(fences[frame]);
+		if (glClientWaitSync(sync, 0, 0) != GL_ALREADY_SIGNALED)
+			waitCount++;
+		waitFence(fences[frame]);
+	}
+}
+
+StreamAllocation StreamBuffer::allocate(size_t size) {
+	size_t alignedSize = alignUp(size, ALIGNMENT);
+	if (!mapped || frameOffset + alignedSize > frameSize) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::STREAM_BUFFER::OUT_OF_SPACE\n" << "Requested " << size << " bytes, "
+			<< frameSize - frameOffset << " left in frame" << std::endl;
+	#endif
+		return { nullptr, 0, 0 };
+	}
+
+	size_t offset = frame * frameSize + frameOffset;
+	frameOffset += alignedSize;
+
+	return { mapped + offset, offset, size };
+}
+
+void StreamBuffer::finishWrites() {
+	// Coherent persistent mappings need no flush.
+	if (persistent() || frameOffset == 0)
+		return;
+
+	size_t offset = frame * frameSize;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, offset, frameOffset, staging.data() + offset);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::endFrame() {
+	if (fences[frame])
+		glDeleteSync(static_cast<GLsync>(fences[frame]));
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::bindRange(unsigned int target, unsigned int index, const StreamAllocation &allocation) const {
+	glBindBufferRange(target, index, id, allocation.offset, allocation.size);
+}
+
+bool StreamBuffer::persistent() const {
+	// glBufferStorage and GL_MAP_PERSISTENT_BIT are core in GL 4.4.
+	return GLAD_GL_VERSION_4_4;
+}
\ No newline at end of file
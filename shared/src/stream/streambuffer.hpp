@@ -0,0 +1,55 @@
+#pragma once
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+// Sub-allocation of the current frame's region.
+struct StreamAllocation {
+	void *data; // CPU write pointer, nullptr when the region is full.
+	size_t offset; // Byte offset in the buffer, for glBindBufferRange and indirect/texel offsets.
+	size_t size;
+};
+
+// Ring of FRAME_COUNT per frame regions in one buffer, written by the CPU while the GPU reads older regions.
+// With GL 4.4 the buffer is immutable storage mapped once, persistent and coherent, so writes land in place.
+// Otherwise writes go to a CPU staging copy that finishWrites() uploads with glBufferSubData.
+// A fence per region makes beginFrame() wait only when the CPU is more than FRAME_COUNT - 1 frames ahead.
+class StreamBuffer {
+public:
+	static const unsigned int FRAME_COUNT = 3;
+	static const size_t ALIGNMENT = 256; // Covers GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT on current hardware.
+
+	unsigned int id;
+	size_t frameSize; // Bytes per region.
+	unsigned int waitCount; // Frames that had to wait on the GPU.
+
+	StreamBuffer(size_t frameSize);
+	~StreamBuffer();
+	StreamBuffer(const StreamBuffer &) = delete;
+	StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+	// Grow regions to at least frameSize. Waits for the GPU and replaces the buffer object, id changes.
+	void reserve(size_t frameSize);
+	// Advance to the next region, waiting on its fence if the GPU still reads it.
+	void beginFrame();
+	StreamAllocation allocate(size_t size);
+	// Make this frame's writes visible to the GPU, call before drawing from them.
+	void finishWrites();
+	// Fence the region once every draw reading it has been issued.
+	void endFrame();
+	void bindRange(unsigned int target, unsigned int index, const StreamAllocation &allocation) const;
+	bool persistent() const;
+
+private:
+	unsigned char *mapped;
+	std::vector<unsigned char> staging;
+	void *fences[FRAME_COUNT];
+	unsigned int frame;
+	size_t frameOffset;
+
+	void create();
+	void destroy();
+};
+#endif
\ No newline at end of file
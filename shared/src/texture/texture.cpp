@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <glad/glad.h>
+#include <stb_image.h>
+#ifndef NDEBUG
+#include <debugout.hpp>
+#endif
+
+#include "texture.hpp"
+#include "profile/profiler.hpp"
+
+Texture::Texture() : id(0), width(0), height(0), numChannels(0), hasStorage(false) {
+	glGenTextures(1, &id);
+}
+
+Texture::Texture(const char *texturePath, bool flipVertically) : Texture() {
+	load(texturePath, flipVertically);
+}
+
+Texture::~Texture() {
+	glDeleteTextures(1, &id);
+}
+
+bool Texture::load(const char *texturePath, bool flipVertically) {
+	PROFILE_SCOPE("Texture::load");
+	stbi_set_flip_vertically_on_load(flipVertically);
+	unsigned char *data = stbi_load(texturePath, &width, &height, &numChannels, 0);
+	if (!data) {
+	#ifndef NDEBUG
+		DEBUG_OUT << "ERROR::TEXTURE::FILE_NOT_SUCCESFULLY_READ\n" << texturePath << std::endl;
+	#endif
+		return false;
+	}
+
+	unsigned int internalFormat, format;
+	switch (numChannels) {
+		case 1:
+			internalFormat = GL_R8;
+			format = GL_RED;
+			break;
+		case 2:
+			internalFormat = GL_RG8;
+			format = GL_RG;
+			break;
+		case 3:
+			internalFormat = GL_RGB8;
+			format = GL_RGB;
+			break;
+		case 4:
+			internalFormat = GL_RGBA8;
+			format = GL_RGBA;
+			break;
+		default:
+		#ifndef NDEBUG
+			DEBUG_OUT << "ERROR::TEXTURE::UNSUPPORTED_CHANNEL_COUNT\n" << texturePath << std::endl;
+		#endif
+			stbi_image_free(data);
+			return false;
+	}
+
+	// Full mip chain down to 1x1.
+	int levels = 1 + static_cast<int>(std::floor(std::log2(std::max(width, height))));
+
+	// Immutable storage cannot be respecified, so a reload gets a new texture object.
+	if (hasStorage) {
+		glDeleteTextures(1, &id);
+		glGenTextures(1, &id);
+	}
+	glBindTexture(GL_TEXTURE_2D, id);
+	allocateStorage(levels, internalFormat, format, data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	hasStorage = true;
+
+	stbi_image_free(data);
+
+	return true;
+}
+
+void Texture::bind(unsigned int unit) const {
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, id);
+}
+
+void Texture::allocateStorage(int levels, unsigned int internalFormat, unsigned int format, const unsigned char *data) {
+	// Rows of tightly packed RGB or single channel images are not 4-byte aligned.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if (GLAD_GL_VERSION_4_2) {
+		// Immutable storage: format and mip chain are fixed, so the driver can skip completeness checks on bind.
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+	}
+	else {
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
\ No newline at end of file
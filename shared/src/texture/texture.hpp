@@ -0,0 +1,29 @@
+#pragma once
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+// 2D texture backed by immutable storage where supported (GL 4.2+).
+// Sampling state is not stored on the texture, bind a sampler object instead.
+class Texture {
+public:
+	unsigned int id;
+	int width;
+	int height;
+	int numChannels;
+
+	Texture();
+	Texture(const char *texturePath, bool flipVertically = true);
+	~Texture();
+	Texture(const Texture &) = delete;
+	Texture &operator=(const Texture &) = delete;
+
+	// Loading again replaces the texture object, so id changes and units must be rebound.
+	bool load(const char *texturePath, bool flipVertically = true);
+	void bind(unsigned int unit) const;
+
+private:
+	bool hasStorage;
+
+	void allocateStorage(int levels, unsigned int internalFormat, unsigned int format, const unsigned char *data);
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <cstdio>
+
+#include "jobsystem.hpp"
+#include "profile/profiler.hpp"
+
+namespace {
+	const int64_t DEQUE_MASK = WorkStealingDeque::CAPACITY - 1;
+	const unsigned int STEAL_ATTEMPTS_BEFORE_SLEEP = 64;
+
+	// Index of the calling thread in the job system it belongs to.
+	thread_local const JobSystem *currentSystem = nullptr;
+	thread_local unsigned int currentThread = 0;
+
+	uint32_t nextRandom(uint32_t &state) {
+		// Xorshift, victims only need to be spread out.
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+}
+
+// Memory orders follow Le et al., Correct and Efficient Work-Stealing for Weak Memory Models (2013).
+WorkStealingDeque::WorkStealingDeque() : top(0), bottom(0) {
+	for (std::atomic<Job *> &job : jobs)
+		job.store(nullptr, std::memory_order_relaxed);
+}
+
+bool WorkStealingDeque::push(Job *job) {
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= CAPACITY)
+		return false;
+	jobs[b & DEQUE_MASK].store(job, std::memory_order_relaxed);
+	// Publishes the job's contents to thieves that load bottom with acquire.
+	bottom.store(b + 1, std::memory_order_release);
+
+	return true;
+}
+
+Job *WorkStealingDeque::pop() {
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+	if (t > b) {
+		// Empty, restore.
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job *job = jobs[b & DEQUE_MASK].load(std::memory_order_relaxed);
+	if (t == b) {
+		// Last job, race thieves for it.
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+Job *WorkStealingDeque::steal() {
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+	if (t >= b)
+		return nullptr;
+
+	Job *job = jobs[t & DEQUE_MASK].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+
+	return job;
+}
+
+JobSystem::JobSystem(unsigned int threadCount) : running(true), submitEpoch(0), sleepingWorkers(0) {
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.push_back(std::make_unique<Worker>());
+		workers[i]->nextJob = 0;
+		workers[i]->randomState = 0x9E3779B9u * (i + 1);
+	}
+
+	currentSystem = this;
+	currentThread = 0;
+	for (unsigned int i = 1; i < threadCount; i++)
+		threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+	running.store(false);
+	submitEpoch.fetch_add(1);
+	submitEpoch.notify_all();
+	for (std::thread &thread : threads)
+		thread.join();
+	if (currentSystem == this)
+		currentSystem = nullptr;
+}
+
+unsigned int JobSystem::threadCount() const {
+	return static_cast<unsigned int>(workers.size());
+}
+
+void JobSystem::submit(const Job &job, JobCounter &counter) {
+	Worker &worker = *workers[currentIndex()];
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+	unsigned int slot = worker.nextJob++ % WorkStealingDeque::CAPACITY;
+	worker.jobPool[slot] = job;
+	worker.counters[slot] = &counter;
+	if (!worker.deque.push(&worker.jobPool[slot])) {
+		// Deque full, run it here instead.
+		job.function(job.context, job.begin, job.end);
+		counter.pending.fetch_sub(1, std::memory_order_release);
+		return;
+	}
+
+	submitEpoch.fetch_add(1);
+	if (sleepingWorkers.load() > 0)
+		submitEpoch.notify_all();
+}
+
+void JobSystem::wait(JobCounter &counter) {
+	unsigned int index = currentIndex();
+	while (counter.pending.load(std::memory_order_acquire) > 0) {
+		// Help instead of blocking, the jobs being waited on are usually still queued.
+		if (!runOne(index))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+	currentSystem = this;
+	currentThread = index;
+	char threadName[32];
+	std::snprintf(threadName, sizeof(threadName), "job worker %u", index);
+	Profiler::setThreadName(threadName);
+	unsigned int failedAttempts = 0;
+	while (running.load(std::memory_order_relaxed)) {
+		if (runOne(index)) {
+			failedAttempts = 0;
+			continue;
+		}
+		if (++failedAttempts < STEAL_ATTEMPTS_BEFORE_SLEEP) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Announce sleep, then look once more, a submit after reading the epoch wakes the wait.
+		unsigned int epoch = submitEpoch.load();
+		sleepingWorkers.fetch_add(1);
+		if (!runOne(index) && running.load())
+			submitEpoch.wait(epoch);
+		sleepingWorkers.fetch_sub(1);
+		failedAttempts = 0;
+	}
+}
+
+bool JobSystem::runOne(unsigned int index) {
+	unsigned int owner = index;
+	Job *taken = workers[index]->deque.pop();
+	if (!taken) {
+		// Start at a random victim so thieves spread over the deques.
+		unsigned int count = threadCount();
+		unsigned int start = nextRandom(workers[index]->randomState) % count;
+		for (unsigned int i = 0; i < count && !taken; i++) {
+			owner = (start + i) % count;
+			if (owner != index)
+				taken = workers[owner]->deque.steal();
+		}
+		if (!taken)
+			return false;
+	}
+
+	Job job = *taken;
+	JobCounter *counter = workers[owner]->counters[taken - workers[owner]->jobPool];
+	{
+		PROFILE_SCOPE("job");
+		job.function(job.context, job.begin, job.end);
+	}
+	counter->pending.fetch_sub(1, std::memory_order_release);
+
+	return true;
+}
+
+unsigned int JobSystem::currentIndex() const {
+	// Threads outside the system share thread 0's deque, which is only safe from the creating thread.
+	return currentSystem == this ? currentThread : 0;
+}
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Counts unfinished jobs. Submitting adds one, finishing subtracts one, wait returns at zero.
+// A job that others depend on shares a counter with them, the dependents are submitted after the wait.
+struct JobCounter {
+	std::atomic<unsigned int> pending{ 0 };
+};
+
+// A call of function(context, begin, end). Jobs are copied into the scheduler, context must outlive them.
+struct Job {
+	void (*function)(void *context, size_t begin, size_t end);
+	void *context;
+	size_t begin;
+	size_t end;
+};
+
+// Fixed size Chase-Lev deque of job pointers. The owning thread pushes and pops at the bottom, any thread
+// steals from the top, so owners work newest first and thieves take the oldest, largest remaining work.
+class WorkStealingDeque {
+public:
+	static const int64_t CAPACITY = 4096;
+
+	WorkStealingDeque();
+
+	// Owner only. False if the deque is full.
+	bool push(Job *job);
+	// Owner only. nullptr if empty or the last job was stolen.
+	Job *pop();
+	// Any thread. nullptr if empty or another thread won the race.
+	Job *steal();
+
+private:
+	alignas(64) std::atomic<int64_t> top;
+	alignas(64) std::atomic<int64_t> bottom;
+	std::atomic<Job *> jobs[CAPACITY];
+};
+
+// Work-stealing scheduler with one deque per thread. The thread that creates it counts as thread 0 and
+// helps run jobs while it waits, threadCount - 1 workers are started. Jobs may be submitted from thread 0
+// and from inside jobs. Idle workers steal from random victims, then sleep until more work is submitted.
+class JobSystem {
+public:
+	// Chunks per thread parallelFor splits a range into, enough for stealing to even out uneven chunks.
+	static const unsigned int CHUNKS_PER_THREAD = 4;
+
+	// threadCount 0 uses every hardware thread.
+	JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+	JobSystem(const JobSystem &) = delete;
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	unsigned int threadCount() const;
+	void submit(const Job &job, JobCounter &counter);
+	// Runs queued jobs until the counter reaches zero.
+	void wait(JobCounter &counter);
+	// Calls function(begin, end) over chunks of at least grainSize elements, on every thread, and returns when all are done.
+	template <typename Function>
+	void parallelFor(size_t begin, size_t end, size_t grainSize, const Function &function);
+
+private:
+	struct Worker {
+		WorkStealingDeque deque;
+		// Submitted jobs live here until run, slots are reused after CAPACITY further submissions from
+		// the same thread. A thread copies a job out as soon as it takes it.
+		Job jobPool[WorkStealingDeque::CAPACITY];
+		JobCounter *counters[WorkStealingDeque::CAPACITY];
+		unsigned int nextJob;
+		uint32_t randomState;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<std::thread> threads;
+	std::atomic<bool> running;
+	std::atomic<unsigned int> submitEpoch; // Bumped by every submit, sleeping workers wait on it.
+	std::atomic<unsigned int> sleepingWorkers;
+
+	void workerLoop(unsigned int index);
+	// Run one job from the thread's own deque or stolen from another, false if none was found.
+	bool runOne(unsigned int index);
+	unsigned int currentIndex() const;
+};
+
+template <typename Function>
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize, const Function &function) {
+	if (begin >= end)
+		return;
+	size_t count = end - begin;
+	size_t chunkCount = std::min((count + std::max<size_t>(grainSize, 1) - 1) / std::max<size_t>(grainSize, 1),
+		static_cast<size_t>(threadCount()) * CHUNKS_PER_THREAD);
+	if (chunkCount <= 1) {
+		function(begin, end);
+		return;
+	}
+
+	auto runChunk = [](void *context, size_t chunkBegin, size_t chunkEnd) {
+		(*static_cast<const Function *>(context))(chunkBegin, chunkEnd);
+	};
+	JobCounter counter;
+	size_t chunkSize = count / chunkCount, remainder = count % chunkCount;
+	// The first chunk runs on this thread, the rest are queued for stealing.
+	size_t firstEnd = begin + chunkSize + (remainder > 0);
+	size_t chunkBegin = firstEnd;
+	for (size_t chunk = 1; chunk < chunkCount; chunk++) {
+		size_t chunkEnd = chunkBegin + chunkSize + (chunk < remainder);
+		submit({ runChunk, const_cast<Function *>(&function), chunkBegin, chunkEnd }, counter);
+		chunkBegin = chunkEnd;
+	}
+	function(begin, firstEnd);
+	wait(counter);
+}
+#endif
\ No newline at end of file
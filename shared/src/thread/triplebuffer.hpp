@@ -0,0 +1,50 @@
+#pragma once
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Hands the latest value from one writer thread to one reader thread without locks. The writer fills
+// its back slot and publishes it, the reader acquires the newest published slot. Each side swaps its
+// slot with the shared middle one in a single atomic exchange, so neither ever waits on the other,
+// and a value published twice before the reader looks is simply replaced.
+// Slots are reused, so values holding vectors keep their capacity from frame to frame.
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : back(0), middle(1), front(2) {}
+	TripleBuffer(const TripleBuffer &) = delete;
+	TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+	// Writer side. The slot belongs to the writer until publish.
+	T &writeSlot() {
+		return slots[back];
+	}
+
+	void publish() {
+		back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// Reader side. True if a value was published since the last acquire, readSlot then holds it.
+	// Otherwise readSlot keeps the previous value.
+	bool acquire() {
+		if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	const T &readSlot() const {
+		return slots[front];
+	}
+
+private:
+	static const unsigned int INDEX_MASK = 3, FRESH_BIT = 4;
+
+	T slots[3];
+	// Each index on its own cache line, the writer and reader only share middle.
+	alignas(64) unsigned int back;
+	alignas(64) std::atomic<unsigned int> middle;
+	alignas(64) unsigned int front;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <GLFW/glfw3.h>
+
+#include "framepacer.hpp"
+
+namespace {
+	const uint64_t MIN_SPIN_NS = 200000; // Spin at least this long before the deadline.
+	const uint64_t INITIAL_SLEEP_LATENESS_NS = 1000000;
+}
+
+uint64_t nowNanoseconds() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count());
+}
+
+SwapMode applySwapMode(SwapMode mode) {
+	if (mode == SWAP_ADAPTIVE && !glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+		mode = SWAP_VSYNC;
+	// A negative interval enables adaptive sync.
+	glfwSwapInterval(mode == SWAP_VSYNC ? 1 : mode == SWAP_ADAPTIVE ? -1 : 0);
+
+	return mode;
+}
+
+FramePacer::FramePacer(double targetFrameRate) : startTime(nowNanoseconds()), frameStart(startTime), periodNs(0), deadline(0),
+	sleepLatenessNs(INITIAL_SLEEP_LATENESS_NS), deltas(), deltaCount(0), nextDelta(0), lastDelta(0.0) {
+	setTargetFrameRate(targetFrameRate);
+}
+
+void FramePacer::setTargetFrameRate(double framesPerSecond) {
+	periodNs = framesPerSecond > 0.0 ? static_cast<uint64_t>(1e9 / framesPerSecond) : 0;
+	deadline = nowNanoseconds() + periodNs;
+}
+
+void FramePacer::beginFrame() {
+	uint64_t now = nowNanoseconds();
+	lastDelta = (now - frameStart) * 1e-9;
+	frameStart = now;
+
+	deltas[nextDelta] = std::min(lastDelta, MAX_DELTA_SECONDS);
+	nextDelta = (nextDelta + 1) % SMOOTHING_FRAMES;
+	deltaCount = std::min(deltaCount + 1, SMOOTHING_FRAMES);
+}
+
+void FramePacer::waitForNextFrame() {
+	if (periodNs == 0)
+		return;
+
+	uint64_t now = nowNanoseconds();
+	uint64_t spinMargin = std::max(sleepLatenessNs, MIN_SPIN_NS);
+	if (now + spinMargin < deadline) {
+		uint64_t sleepUntil = deadline - spinMargin;
+		std::this_thread::sleep_for(std::chrono::nanoseconds(sleepUntil - now));
+		uint64_t woke = nowNanoseconds();
+		uint64_t lateness = woke > sleepUntil ? woke - sleepUntil : 0;
+		// Jump up to a late wake at once, come back down slowly.
+		sleepLatenessNs = std::max(lateness, sleepLatenessNs - sleepLatenessNs / 16);
+	}
+	while (nowNanoseconds() < deadline)
+		std::this_thread::yield();
+
+	// Missed by more than a period, restart the schedule instead of rushing frames to catch up.
+	now = nowNanoseconds();
+	deadline += periodNs;
+	if (deadline < now)
+		deadline = now + periodNs;
+}
+
+double FramePacer::deltaSeconds() const {
+	return lastDelta;
+}
+
+float FramePacer::smoothedDeltaSeconds() const {
+	if (deltaCount == 0)
+		return 0.0f;
+	double sum = 0.0;
+	for (unsigned int i = 0; i < deltaCount; i++)
+		sum += deltas[i];
+
+	return static_cast<float>(sum / deltaCount);
+}
+
+double FramePacer::elapsedSeconds() const {
+	return (nowNanoseconds() - startTime) * 1e-9;
+}
\ No newline at end of file
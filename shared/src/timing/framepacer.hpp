@@ -0,0 +1,54 @@
+#pragma once
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <cstdint>
+
+// Monotonic clock in nanoseconds, 64 bits hold centuries without losing precision.
+uint64_t nowNanoseconds();
+
+enum SwapMode {
+	SWAP_VSYNC, // Wait for every vertical blank.
+	SWAP_ADAPTIVE, // Vsync, but late frames tear instead of waiting a whole extra refresh.
+	SWAP_UNCAPPED // Never wait, pair with a frame rate limit to save CPU.
+};
+
+// Sets the swap interval of the current context. Adaptive sync needs EXT_swap_control_tear and falls back
+// to vsync without it. Returns the mode applied.
+SwapMode applySwapMode(SwapMode mode);
+
+// Measures frame times on the nanosecond clock, smooths them for movement, and optionally limits the
+// frame rate. The limiter sleeps until just before the deadline and spins the rest, the margin it leaves
+// follows how late sleeps have recently woken up, so a coarse scheduler costs some spinning rather than
+// missed deadlines. Deadlines advance by whole periods, so a late frame does not shift the ones after it.
+class FramePacer {
+public:
+	static constexpr unsigned int SMOOTHING_FRAMES = 8;
+	// Longer frames (breakpoints, window drags) count as this long, so movement does not jump.
+	static constexpr double MAX_DELTA_SECONDS = 0.1;
+
+	// targetFrameRate 0 disables the limiter.
+	FramePacer(double targetFrameRate = 0.0);
+
+	void setTargetFrameRate(double framesPerSecond);
+	// Call at the start of every frame.
+	void beginFrame();
+	// Sleep then spin until the next frame's deadline. Does nothing without a target frame rate.
+	void waitForNextFrame();
+
+	double deltaSeconds() const; // Last frame, unsmoothed.
+	float smoothedDeltaSeconds() const; // Mean of the last SMOOTHING_FRAMES, clamped.
+	double elapsedSeconds() const; // Since construction.
+
+private:
+	uint64_t startTime;
+	uint64_t frameStart;
+	uint64_t periodNs; // 0 without a limit.
+	uint64_t deadline;
+	uint64_t sleepLatenessNs; // Recent worst case of how late sleeps wake, decays over time.
+	double deltas[SMOOTHING_FRAMES];
+	unsigned int deltaCount;
+	unsigned int nextDelta;
+	double lastDelta;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+#if defined(__AVX__)
+#define TRANSFORM_ARRAY_AVX
+#define TRANSFORM_ARRAY_SSE
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_ARRAY_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "transformarray.hpp"
+
+namespace {
+	const size_t MATRIX_FLOATS = 16;
+
+#ifdef TRANSFORM_ARRAY_SSE
+	// Four objects' x, y, z, w of one matrix column, transposed into that column of each object's matrix.
+	inline void storeColumn(__m128 x, __m128 y, __m128 z, __m128 w, float *destination, size_t column) {
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(destination + column * 4, x);
+		_mm_storeu_ps(destination + MATRIX_FLOATS + column * 4, y);
+		_mm_storeu_ps(destination + MATRIX_FLOATS * 2 + column * 4, z);
+		_mm_storeu_ps(destination + MATRIX_FLOATS * 3 + column * 4, w);
+	}
+#endif
+}
+
+TransformArray::TransformArray() : count(0) {}
+
+size_t TransformArray::add(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale) {
+	resize(count + 1);
+	setPosition(count - 1, position);
+	setRotation(count - 1, rotation);
+	setScale(count - 1, scale);
+
+	return count - 1;
+}
+
+void TransformArray::resize(size_t count) {
+	for (int lane = 0; lane < LANE_COUNT; lane++) {
+		// New objects start as identity: zero translation and rotation vector, unit w and scale.
+		float identity = lane == ROTATION_W || lane >= SCALE_X ? 1.0f : 0.0f;
+		lanes[lane].resize(count, identity);
+	}
+	this->count = count;
+}
+
+void TransformArray::clear() {
+	for (auto &lane : lanes)
+		lane.clear();
+	count = 0;
+}
+
+void TransformArray::setPosition(size_t index, const glm::vec3 &position) {
+	lanes[POSITION_X][index] = position.x;
+	lanes[POSITION_Y][index] = position.y;
+	lanes[POSITION_Z][index] = position.z;
+}
+
+void TransformArray::setRotation(size_t index, const glm::quat &rotation) {
+	lanes[ROTATION_X][index] = rotation.x;
+	lanes[ROTATION_Y][index] = rotation.y;
+	lanes[ROTATION_Z][index] = rotation.z;
+	lanes[ROTATION_W][index] = rotation.w;
+}
+
+void TransformArray::setScale(size_t index, const glm::vec3 &scale) {
+	lanes[SCALE_X][index] = scale.x;
+	lanes[SCALE_Y][index] = scale.y;
+	lanes[SCALE_Z][index] = scale.z;
+}
+
+glm::vec3 TransformArray::position(size_t index) const {
+	return glm::vec3(lanes[POSITION_X][index], lanes[POSITION_Y][index], lanes[POSITION_Z][index]);
+}
+
+glm::quat TransformArray::rotation(size_t index) const {
+	return glm::quat(lanes[ROTATION_W][index], lanes[ROTATION_X][index], lanes[ROTATION_Y][index], lanes[ROTATION_Z][index]);
+}
+
+glm::vec3 TransformArray::scale(size_t index) const {
+	return glm::vec3(lanes[SCALE_X][index], lanes[SCALE_Y][index], lanes[SCALE_Z][index]);
+}
+
+size_t TransformArray::size() const {
+	return count;
+}
+
+void TransformArray::composeMatrices(size_t first, size_t count, float *destination, bool simd) const {
+	size_t i = first, end = first + count;
+#ifdef TRANSFORM_ARRAY_SSE
+	if (simd) {
+		const float *px = lanes[POSITION_X].data(), *py = lanes[POSITION_Y].data(), *pz = lanes[POSITION_Z].data();
+		const float *qx = lanes[ROTATION_X].data(), *qy = lanes[ROTATION_Y].data(), *qz = lanes[ROTATION_Z].data(), *qw = lanes[ROTATION_W].data();
+		const float *sx = lanes[SCALE_X].data(), *sy = lanes[SCALE_Y].data(), *sz = lanes[SCALE_Z].data();
+	#ifdef TRANSFORM_ARRAY_AVX
+		const __m256 one8 = _mm256_set1_ps(1.0f);
+		for (; i + 8 <= end; i += 8) {
+			__m256 x = _mm256_loadu_ps(qx + i), y = _mm256_loadu_ps(qy + i), z = _mm256_loadu_ps(qz + i), w = _mm256_loadu_ps(qw + i);
+			__m256 x2 = _mm256_add_ps(x, x), y2 = _mm256_add_ps(y, y), z2 = _mm256_add_ps(z, z);
+			__m256 xx = _mm256_mul_ps(x, x2), yy = _mm256_mul_ps(y, y2), zz = _mm256_mul_ps(z, z2);
+			__m256 xy = _mm256_mul_ps(x, y2), xz = _mm256_mul_ps(x, z2), yz = _mm256_mul_ps(y, z2);
+			__m256 wx = _mm256_mul_ps(w, x2), wy = _mm256_mul_ps(w, y2), wz = _mm256_mul_ps(w, z2);
+			__m256 scaleX = _mm256_loadu_ps(sx + i), scaleY = _mm256_loadu_ps(sy + i), scaleZ = _mm256_loadu_ps(sz + i);
+
+			__m256 columns[4][4] = {
+				{ _mm256_mul_ps(_mm256_sub_ps(one8, _mm256_add_ps(yy, zz)), scaleX), _mm256_mul_ps(_mm256_add_ps(xy, wz), scaleX),
+					_mm256_mul_ps(_mm256_sub_ps(xz, wy), scaleX), _mm256_setzero_ps() },
+				{ _mm256_mul_ps(_mm256_sub_ps(xy, wz), scaleY), _mm256_mul_ps(_mm256_sub_ps(one8, _mm256_add_ps(xx, zz)), scaleY),
+					_mm256_mul_ps(_mm256_add_ps(yz, wx), scaleY), _mm256_setzero_ps() },
+				{ _mm256_mul_ps(_mm256_add_ps(xz, wy), scaleZ), _mm256_mul_ps(_mm256_sub_ps(yz, wx), scaleZ),
+					_mm256_mul_ps(_mm256_sub_ps(one8, _mm256_add_ps(xx, yy)), scaleZ), _mm256_setzero_ps() },
+				{ _mm256_loadu_ps(px + i), _mm256_loadu_ps(py + i), _mm256_loadu_ps(pz + i), one8 }
+			};
+			// Halves are objects i - i + 3 and i + 4 - i + 7.
+			float *matrices = destination + (i - first) * MATRIX_FLOATS;
+			for (size_t column = 0; column < 4; column++) {
+				const __m256 *c = columns[column];
+				storeColumn(_mm256_castps256_ps128(c[0]), _mm256_castps256_ps128(c[1]), _mm256_castps256_ps128(c[2]),
+					_mm256_castps256_ps128(c[3]), matrices, column);
+				storeColumn(_mm256_extractf128_ps(c[0], 1), _mm256_extractf128_ps(c[1], 1), _mm256_extractf128_ps(c[2], 1),
+					_mm256_extractf128_ps(c[3], 1), matrices + MATRIX_FLOATS * 4, column);
+			}
+		}
+	#endif
+		const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+		for (; i + 4 <= end; i += 4) {
+			__m128 x = _mm_loadu_ps(qx + i), y = _mm_loadu_ps(qy + i), z = _mm_loadu_ps(qz + i), w = _mm_loadu_ps(qw + i);
+			__m128 x2 = _mm_add_ps(x, x), y2 = _mm_add_ps(y, y), z2 = _mm_add_ps(z, z);
+			__m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+			__m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+			__m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+			__m128 scaleX = _mm_loadu_ps(sx + i), scaleY = _mm_loadu_ps(sy + i), scaleZ = _mm_loadu_ps(sz + i);
+
+			float *matrices = destination + (i - first) * MATRIX_FLOATS;
+			storeColumn(_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleX), _mm_mul_ps(_mm_add_ps(xy, wz), scaleX),
+				_mm_mul_ps(_mm_sub_ps(xz, wy), scaleX), zero, matrices, 0);
+			storeColumn(_mm_mul_ps(_mm_sub_ps(xy, wz), scaleY), _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleY),
+				_mm_mul_ps(_mm_add_ps(yz, wx), scaleY), zero, matrices, 1);
+			storeColumn(_mm_mul_ps(_mm_add_ps(xz, wy), scaleZ), _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZ),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZ), zero, matrices, 2);
+			storeColumn(_mm_loadu_ps(px + i), _mm_loadu_ps(py + i), _mm_loadu_ps(pz + i), one, matrices, 3);
+		}
+	}
+#endif
+	for (; i < end; i++)
+		composeScalar(i, destination + (i - first) * MATRIX_FLOATS);
+}
+
+unsigned int TransformArray::simdWidth() {
+#if defined(TRANSFORM_ARRAY_AVX)
+	return 8;
+#elif defined(TRANSFORM_ARRAY_SSE)
+	return 4;
+#else
+	return 1;
+#endif
+}
+
+void TransformArray::composeScalar(size_t index, float *destination) const {
+	float x = lanes[ROTATION_X][index], y = lanes[ROTATION_Y][index], z = lanes[ROTATION_Z][index], w = lanes[ROTATION_W][index];
+	float x2 = x + x, y2 = y + y, z2 = z + z;
+	float xx = x * x2, yy = y * y2, zz = z * z2;
+	float xy = x * y2, xz = x * z2, yz = y * z2;
+	float wx = w * x2, wy = w * y2, wz = w * z2;
+	float scaleX = lanes[SCALE_X][index], scaleY = lanes[SCALE_Y][index], scaleZ = lanes[SCALE_Z][index];
+
+	float matrix[MATRIX_FLOATS] = {
+		(1.0f - (yy + zz)) * scaleX, (xy + wz) * scaleX, (xz - wy) * scaleX, 0.0f,
+		(xy - wz) * scaleY, (1.0f - (xx + zz)) * scaleY, (yz + wx) * scaleY, 0.0f,
+		(xz + wy) * scaleZ, (yz - wx) * scaleZ, (1.0f - (xx + yy)) * scaleZ, 0.0f,
+		lanes[POSITION_X][index], lanes[POSITION_Y][index], lanes[POSITION_Z][index], 1.0f
+	};
+	for (size_t i = 0; i < MATRIX_FLOATS; i++)
+		destination[i] = matrix[i];
+}
\ No newline at end of file
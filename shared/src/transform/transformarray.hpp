@@ -0,0 +1,79 @@
+#pragma once
+#ifndef TRANSFORM_ARRAY_H
+#define TRANSFORM_ARRAY_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Allocator for vectors whose data must start on an alignment boundary, so SIMD loads of whole groups
+// never straddle cache lines.
+template <typename T, size_t ALIGNMENT>
+struct AlignedAllocator {
+	typedef T value_type;
+	template <typename U>
+	struct rebind {
+		typedef AlignedAllocator<U, ALIGNMENT> other;
+	};
+
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, ALIGNMENT> &) {}
+
+	T *allocate(size_t count) {
+		return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(ALIGNMENT)));
+	}
+	void deallocate(T *pointer, size_t) {
+		::operator delete(pointer, std::align_val_t(ALIGNMENT));
+	}
+	bool operator==(const AlignedAllocator &) const {
+		return true;
+	}
+	bool operator!=(const AlignedAllocator &) const {
+		return false;
+	}
+};
+
+// Translation, rotation and scale of many objects in structure of arrays form, one 32 byte aligned lane
+// per component. World matrices are composed eight objects at a time with AVX or four with SSE, whichever
+// the compiler targets, and written as consecutive column-major mat4s straight to any destination, such as
+// a mapped instance or stream buffer. Objects past the last whole group take the scalar path.
+class TransformArray {
+public:
+	static const size_t ALIGNMENT = 32;
+
+	TransformArray();
+
+	size_t add(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale);
+	void resize(size_t count);
+	void clear();
+
+	void setPosition(size_t index, const glm::vec3 &position);
+	// Rotation must be a unit quaternion.
+	void setRotation(size_t index, const glm::quat &rotation);
+	void setScale(size_t index, const glm::vec3 &scale);
+	glm::vec3 position(size_t index) const;
+	glm::quat rotation(size_t index) const;
+	glm::vec3 scale(size_t index) const;
+	size_t size() const;
+
+	// Matrices of objects [first, first + count) go to destination, 16 floats each, equal to
+	// translate * mat4_cast(rotation) * scale. Ranges from different threads may overlap neither in
+	// objects nor in destination. simd false forces the scalar path.
+	void composeMatrices(size_t first, size_t count, float *destination, bool simd = true) const;
+
+	// Objects per SIMD step, 1 without SIMD.
+	static unsigned int simdWidth();
+
+private:
+	enum Lane { POSITION_X, POSITION_Y, POSITION_Z, ROTATION_X, ROTATION_Y, ROTATION_Z, ROTATION_W,
+		SCALE_X, SCALE_Y, SCALE_Z, LANE_COUNT };
+
+	std::vector<float, AlignedAllocator<float, ALIGNMENT>> lanes[LANE_COUNT];
+	size_t count;
+
+	void composeScalar(size_t index, float *destination) const;
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <cstdint>
+#include <cstring>
+#include <glad/glad.h>
+#include <glm/gtc/packing.hpp>
+
+#include "vertexformat.hpp"
+
+namespace {
+	const unsigned int POSITION_SIZE = 4 * sizeof(uint16_t);
+	const unsigned int TEX_COORD_SIZE = 2 * sizeof(uint16_t);
+	const unsigned int NORMAL_SIZE = sizeof(uint32_t);
+	const uint16_t HALF_ONE = 0x3C00;
+
+	// Avoid dividing by zero for flat bounds, any scale works when every value is the origin.
+	float inverseExtent(float extent) {
+		return extent > 0.0f ? 1.0f / extent : 1.0f;
+	}
+}
+
+size_t QuantizedMesh::vertexCount() const {
+	return stride ? vertices.size() / stride : 0;
+}
+
+QuantizedMesh quantizeMesh(const Mesh &mesh, const MeshAttributes &attributes) {
+	QuantizedMesh quantized;
+	quantized.indices = mesh.indices;
+	quantized.stride = POSITION_SIZE;
+	quantized.texCoordOffset = 0;
+	quantized.normalOffset = 0;
+	if (attributes.texCoord >= 0) {
+		quantized.texCoordOffset = quantized.stride;
+		quantized.stride += TEX_COORD_SIZE;
+	}
+	if (attributes.normal >= 0) {
+		quantized.normalOffset = quantized.stride;
+		quantized.stride += NORMAL_SIZE;
+	}
+
+	// Per mesh bounds of positions and texture coordinates.
+	size_t vertexCount = mesh.vertexCount();
+	glm::vec3 positionMin(0.0f), positionMax(0.0f);
+	glm::vec2 texCoordMin(0.0f), texCoordMax(0.0f);
+	for (size_t i = 0; i < vertexCount; i++) {
+		const float *vertex = &mesh.vertices[i * mesh.vertexSize];
+		glm::vec3 position(vertex[attributes.position], vertex[attributes.position + 1], vertex[attributes.position + 2]);
+		positionMin = i == 0 ? position : glm::min(positionMin, position);
+		positionMax = i == 0 ? position : glm::max(positionMax, position);
+		if (attributes.texCoord >= 0) {
+			glm::vec2 texCoord(vertex[attributes.texCoord], vertex[attributes.texCoord + 1]);
+			texCoordMin = i == 0 ? texCoord : glm::min(texCoordMin, texCoord);
+			texCoordMax = i == 0 ? texCoord : glm::max(texCoordMax, texCoord);
+		}
+	}
+
+	// Positions map to [-1, 1] around the bounds center, texture coords to [0, 1] from the minimum.
+	quantized.positionOrigin = (positionMin + positionMax) * 0.5f;
+	quantized.positionScale = (positionMax - positionMin) * 0.5f;
+	quantized.texCoordOrigin = texCoordMin;
+	quantized.texCoordScale = texCoordMax - texCoordMin;
+	glm::vec3 positionFactor(
+		inverseExtent(quantized.positionScale.x),
+		inverseExtent(quantized.positionScale.y),
+		inverseExtent(quantized.positionScale.z)
+	);
+	glm::vec2 texCoordFactor(inverseExtent(quantized.texCoordScale.x), inverseExtent(quantized.texCoordScale.y));
+
+	quantized.vertices.resize(vertexCount * quantized.stride);
+	for (size_t i = 0; i < vertexCount; i++) {
+		const float *vertex = &mesh.vertices[i * mesh.vertexSize];
+		unsigned char *out = &quantized.vertices[i * quantized.stride];
+
+		uint16_t position[4];
+		for (int c = 0; c < 3; c++)
+			position[c] = glm::packHalf1x16((vertex[attributes.position + c] - quantized.positionOrigin[c]) * positionFactor[c]);
+		position[3] = HALF_ONE;
+		std::memcpy(out, position, POSITION_SIZE);
+
+		if (attributes.texCoord >= 0) {
+			uint16_t texCoord[2];
+			for (int c = 0; c < 2; c++)
+				texCoord[c] = glm::packUnorm1x16((vertex[attributes.texCoord + c] - quantized.texCoordOrigin[c]) * texCoordFactor[c]);
+			std::memcpy(out + quantized.texCoordOffset, texCoord, TEX_COORD_SIZE);
+		}
+
+		if (attributes.normal >= 0) {
+			glm::vec4 normal(vertex[attributes.normal], vertex[attributes.normal + 1], vertex[attributes.normal + 2], 0.0f);
+			uint32_t packed = glm::packSnorm3x10_1x2(normal);
+			std::memcpy(out + quantized.normalOffset, &packed, NORMAL_SIZE);
+		}
+	}
+
+	return quantized;
+}
+
+void dequantizeVertex(const QuantizedMesh &mesh, size_t index, glm::vec3 &position, glm::vec2 &texCoord, glm::vec3 &normal) {
+	const unsigned char *vertex = &mesh.vertices[index * mesh.stride];
+
+	uint16_t packedPosition[4];
+	std::memcpy(packedPosition, vertex, POSITION_SIZE);
+	for (int c = 0; c < 3; c++)
+		position[c] = glm::unpackHalf1x16(packedPosition[c]) * mesh.positionScale[c] + mesh.positionOrigin[c];
+
+	texCoord = glm::vec2(0.0f);
+	if (mesh.texCoordOffset) {
+		uint16_t packedTexCoord[2];
+		std::memcpy(packedTexCoord, vertex + mesh.texCoordOffset, TEX_COORD_SIZE);
+		for (int c = 0; c < 2; c++)
+			texCoord[c] = glm::unpackUnorm1x16(packedTexCoord[c]) * mesh.texCoordScale[c] + mesh.texCoordOrigin[c];
+	}
+
+	normal = glm::vec3(0.0f);
+	if (mesh.normalOffset) {
+		uint32_t packedNormal;
+		std::memcpy(&packedNormal, vertex + mesh.normalOffset, NORMAL_SIZE);
+		glm::vec4 unpacked = glm::unpackSnorm3x10_1x2(packedNormal);
+		normal = glm::vec3(unpacked.x, unpacked.y, unpacked.z);
+	}
+}
+
+void setVertexAttributes(const QuantizedMesh &mesh) {
+	glVertexAttribPointer(0, 4, GL_HALF_FLOAT, GL_FALSE, mesh.stride, reinterpret_cast<void *>(0));
+	glEnableVertexAttribArray(0);
+	if (mesh.texCoordOffset) {
+		glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, mesh.stride, reinterpret_cast<void *>(static_cast<uintptr_t>(mesh.texCoordOffset)));
+		glEnableVertexAttribArray(1);
+	}
+	if (mesh.normalOffset) {
+		glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, mesh.stride, reinterpret_cast<void *>(static_cast<uintptr_t>(mesh.normalOffset)));
+		glEnableVertexAttribArray(2);
+	}
+}
+
+void setDequantizationUniforms(const Shader &shader, const QuantizedMesh &mesh) {
+	shader.setVec3("positionScale", mesh.positionScale);
+	shader.setVec3("positionOrigin", mesh.positionOrigin);
+	shader.setVec2("texCoordScale", mesh.texCoordScale);
+	shader.setVec2("texCoordOrigin", mesh.texCoordOrigin);
+}
+
+void setInstanceMatrixAttribute(unsigned int location) {
+	// A mat4 attribute is four vec4 columns, each advancing once per instance.
+	for (unsigned int column = 0; column < 4; column++) {
+		glVertexAttribPointer(location + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), reinterpret_cast<void *>(column * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(location + column);
+		glVertexAttribDivisor(location + column, 1);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "mesh/mesh.hpp"
+#include "shader/shader.hpp"
+
+// Attribute offsets in floats within an interleaved Mesh vertex, -1 when absent.
+struct MeshAttributes {
+	int position;
+	int texCoord;
+	int normal;
+};
+
+// Compact vertex stream:
+//   location 0: position, 4 x half float, normalized to the mesh bounds (w is padding).
+//   location 1: texture coords, 2 x GL_UNSIGNED_SHORT normalized to the mesh UV range.
+//   location 2: normal, GL_INT_2_10_10_10_REV normalized.
+// Dequantization happens in the vertex shader: value = quantized * scale + origin.
+struct QuantizedMesh {
+	std::vector<unsigned char> vertices;
+	std::vector<unsigned int> indices;
+	unsigned int stride; // Bytes per vertex.
+	unsigned int texCoordOffset; // Byte offset of texture coords, 0 when absent.
+	unsigned int normalOffset; // Byte offset of normal, 0 when absent.
+	glm::vec3 positionScale;
+	glm::vec3 positionOrigin;
+	glm::vec2 texCoordScale;
+	glm::vec2 texCoordOrigin;
+
+	size_t vertexCount() const;
+};
+
+QuantizedMesh quantizeMesh(const Mesh &mesh, const MeshAttributes &attributes);
+// Decode one vertex back to floats, used for error measurement.
+void dequantizeVertex(const QuantizedMesh &mesh, size_t index, glm::vec3 &position, glm::vec2 &texCoord, glm::vec3 &normal);
+// Configure attribute pointers on the currently bound VAO and GL_ARRAY_BUFFER.
+void setVertexAttributes(const QuantizedMesh &mesh);
+// Scale and origin uniforms consumed by the vertex shader.
+void setDequantizationUniforms(const Shader &shader, const QuantizedMesh &mesh);
+// Per instance glm::mat4 from the currently bound GL_ARRAY_BUFFER, occupies locations location to location + 3.
+void setInstanceMatrixAttribute(unsigned int location);
+#endif
\ No newline at end of file